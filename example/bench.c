@@ -0,0 +1,152 @@
+#include "../jsmn.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Measures jsmn_parse throughput on a JSON file, or on a generated document
+ * of numbers, strings, and small objects when no file is given. Build with
+ * -DJSMN_TRUSTED (the bench_trusted target) to compare against strict mode,
+ * or with -DJSMN_EVENTS (the bench_events target) to also measure
+ * jsmn_parse_events with callbacks that only count what they are given.
+ */
+
+#if defined(JSMN_EVENTS)
+static int count_container(void *data, const jsmntype_t type, const jsmnpos_t pos) {
+  (void)type;
+  (void)pos;
+  ++*(unsigned long *)data;
+  return 0;
+}
+
+static int count_string(void *data, const char *js, const jsmnpos_t start, const jsmnpos_t end) {
+  (void)js;
+  *(unsigned long *)data += end - start;
+  return 0;
+}
+
+static int count_primitive(void *data, const jsmntype_t type, const char *js,
+                           const jsmnpos_t start, const jsmnpos_t end) {
+  (void)type;
+  (void)js;
+  *(unsigned long *)data += end - start;
+  return 0;
+}
+#endif
+
+static char *generate(size_t *len) {
+  size_t cap = 4 * 1024 * 1024, n = 0;
+  char *js = malloc(cap);
+  int i = 0;
+
+  if (js == NULL) {
+    return NULL;
+  }
+  /* Rows of 128 items keep the sibling chains short */
+  n += sprintf(js + n, "[[");
+  while (n < cap - 256) {
+    n += sprintf(js + n,
+                 "%s{\"id\": %d, \"name\": \"item %d\", \"price\": %d.%02d, "
+                 "\"tags\": [\"a\", \"b\\n\"], \"ok\": %s, \"pos\": [%d, -%d.5e3]}",
+                 i == 0 ? "" : (i % 128 ? ", " : "],\n["), i, i, i % 1000, i % 100,
+                 i % 2 ? "true" : "null", i * 7, i % 13);
+    i++;
+  }
+  n += sprintf(js + n, "]]");
+  *len = n;
+  return js;
+}
+
+static char *load(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  char *js;
+  long size;
+
+  if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) {
+    return NULL;
+  }
+  rewind(f);
+  js = malloc(size + 1);
+  if (js != NULL && fread(js, 1, size, f) != (size_t)size) {
+    free(js);
+    js = NULL;
+  }
+  fclose(f);
+  *len = size;
+  return js;
+}
+
+int main(int argc, char **argv) {
+  jsmn_parser p;
+  jsmntok_t *t;
+  jsmnint_t r;
+  size_t len, i, iterations = 20;
+  clock_t start;
+  double seconds, best = 0;
+  char *js = (argc > 1 ? load(argv[1], &len) : generate(&len));
+
+  if (js == NULL) {
+    fprintf(stderr, "Could not read the JSON data\n");
+    return 1;
+  }
+
+  jsmn_init(&p);
+  r = jsmn_parse(&p, js, len, NULL, 0);
+  if (r >= (jsmnint_t)JSMN_ERROR_MAX) {
+    fprintf(stderr, "Failed to parse JSON: %d\n", (int)r);
+    return 1;
+  }
+  t = malloc(sizeof(*t) * r);
+  if (t == NULL) {
+    return 1;
+  }
+
+  /* The fastest run is the least disturbed by the rest of the system */
+  for (i = 0; i < iterations; i++) {
+    start = clock();
+    jsmn_init(&p);
+    jsmn_parse(&p, js, len, t, r);
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (i == 0 || seconds < best) {
+      best = seconds;
+    }
+  }
+
+  printf("%s: %lu bytes, %lu tokens, %.1f MB/s\n",
+#if defined(JSMN_TRUSTED)
+         "trusted",
+#else
+         "strict",
+#endif
+         (unsigned long)len, (unsigned long)r,
+         (double)len / best / (1024 * 1024));
+
+#if defined(JSMN_EVENTS)
+  {
+    unsigned long seen = 0;
+    jsmn_handler handler = {
+      count_container, count_container, count_string, count_string, count_primitive, NULL
+    };
+    handler.data = &seen;
+
+    for (i = 0; i < iterations; i++) {
+      start = clock();
+      jsmn_init(&p);
+      p.final = JSMN_TRUE;
+      jsmn_parse_events(&p, js, len, &handler);
+      seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+      if (i == 0 || seconds < best) {
+        best = seconds;
+      }
+    }
+
+    printf("events: %lu bytes, no tokens, %.1f MB/s\n",
+           (unsigned long)len, (double)len / best / (1024 * 1024));
+  }
+#endif
+
+  free(t);
+  free(js);
+  return 0;
+}
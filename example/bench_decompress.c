@@ -0,0 +1,150 @@
+#include "../jsmn_reader.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Parses a gzip or zstd compressed JSON file (or a plain one) with
+ * jsmn_reader_open_compressed and reports the throughput of each stage:
+ * reading the compressed input, decompressing it, and parsing, so it shows
+ * which one bounds the pipeline. With "lines" the input is taken as newline
+ * delimited JSON and each record is parsed on its own as soon as its block has
+ * arrived, dropping the records already parsed; otherwise the whole input is
+ * parsed as one document with jsmn_reader_parse. Tokens are only counted.
+ */
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double mb_per_s(const double bytes, const double seconds) {
+  return (seconds > 0 ? bytes / seconds / (1024 * 1024) : 0);
+}
+
+/* Parses one record, skipping empty lines */
+static jsmnint_t parse_record(const char *js, const size_t len, unsigned long *records) {
+  jsmn_parser p;
+  jsmnint_t r;
+
+  if (len == 0) {
+    return 0;
+  }
+  jsmn_init(&p);
+  r = jsmn_parse(&p, js, len, NULL, 0);
+  if (r >= (jsmnint_t)JSMN_ERROR_MAX) {
+    fprintf(stderr, "Record %lu does not parse: %d\n", *records + 1, (int)r);
+  } else {
+    (*records)++;
+  }
+  return r;
+}
+
+/* Parses every complete line taken so far, then takes the next block */
+static jsmnint_t parse_lines(jsmn_reader *rd, unsigned long long *out,
+                             unsigned long *records) {
+  jsmnint_t tokens = 0, r;
+  size_t start, end;
+  long n;
+
+  *out = 0;
+  *records = 0;
+  do {
+    n = jsmn_reader_fill(rd);
+    if (n < 0) {
+      return JSMN_ERROR_INVAL;
+    }
+    start = 0;
+    for (end = 0; end <= rd->len; end++) {
+      /* The last record may not end with a newline */
+      if (end == rd->len ? n != 0 || start == end : rd->js[end] != '\n') {
+        continue;
+      }
+      r = parse_record(rd->js + start, end - start, records);
+      if (r >= (jsmnint_t)JSMN_ERROR_MAX) {
+        return r;
+      }
+      tokens += r;
+      start = (end < rd->len ? end + 1 : end);
+    }
+    *out += start;
+    jsmn_reader_drop(rd, start);
+  } while (n > 0);
+
+  return tokens;
+}
+
+int main(int argc, char **argv) {
+  static const char *const formats[] = {"auto", "plain", "gzip", "zstd"};
+  size_t block_size = 1024 * 1024;
+  unsigned long long out = 0;
+  unsigned long records = 1;
+  int i, fd, depth = 4, lines = 0;
+  double start, seconds;
+  jsmn_reader rd;
+  jsmn_parser p;
+  jsmnint_t r;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file.json[.gz|.zst] [depth] [block KB] [lines]\n", argv[0]);
+    return 1;
+  }
+  if (argc > 2) {
+    depth = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    block_size = (size_t)atol(argv[3]) * 1024;
+  }
+  for (i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "lines") == 0) {
+      lines = 1;
+    }
+  }
+
+  fd = open(argv[1], O_RDONLY);
+  if (fd < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  if (jsmn_reader_open_compressed(&rd, fd, JSMN_READ_AUTO, block_size, depth) != 0) {
+    fprintf(stderr, "Cannot read %s\n", argv[1]);
+    close(fd);
+    return 1;
+  }
+
+  start = now();
+  if (lines) {
+    r = parse_lines(&rd, &out, &records);
+  } else {
+    jsmn_init(&p);
+    r = jsmn_reader_parse(&rd, &p, NULL, 0);
+    out = rd.len;
+  }
+  seconds = now() - start;
+
+  if (r >= (jsmnint_t)JSMN_ERROR_MAX) {
+    fprintf(stderr, "Failed to parse %s: %d (%s)\n", argv[1], (int)r,
+            rd.error ? strerror(rd.error) : "bad JSON");
+    jsmn_reader_close(&rd);
+    close(fd);
+    return 1;
+  }
+
+  printf("%s x%d: %llu bytes in, %llu bytes out, %lu records, %lu tokens, %.2f s\n",
+         formats[rd.format], depth, rd.in, out, records, (unsigned long)r, seconds);
+  printf("  read:       %8.1f MB/s in,  %.2f s\n",
+         mb_per_s((double)rd.in, rd.read_time), rd.read_time);
+  printf("  decompress: %8.1f MB/s out, %.2f s\n",
+         mb_per_s((double)out, rd.decode_time), rd.decode_time);
+  printf("  parse:      %8.1f MB/s out, %.2f s, %.2f s waiting for input\n",
+         mb_per_s((double)out, seconds - rd.wait), seconds - rd.wait, rd.wait);
+  printf("  overall:    %8.1f MB/s out\n", mb_per_s((double)out, seconds));
+
+  jsmn_reader_close(&rd);
+  close(fd);
+  return 0;
+}
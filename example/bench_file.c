@@ -0,0 +1,105 @@
+#include "../jsmn_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Compares the time to tokenize a JSON file read into a heap buffer (the
+ * fopen/fread sequence of explode.c) with jsmn_parse_file, which maps it.
+ * Tokens are only counted so memory use does not grow with the file; pass
+ * "populate" or "huge" after the path for the matching jsmn_file_open flags.
+ * Run it on files larger than RAM or after dropping the page cache to see
+ * the cold case, the first run of each method is reported apart.
+ */
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static jsmnint_t parse_read(const char *path, size_t *len) {
+  FILE *fp = fopen(path, "rb");
+  jsmn_parser p;
+  jsmnint_t r;
+  char *js;
+  long size;
+
+  if (fp == NULL || fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0) {
+    return JSMN_ERROR_INVAL;
+  }
+  rewind(fp);
+  js = malloc(size + 1);
+  if (js == NULL || fread(js, 1, size, fp) != (size_t)size) {
+    free(js);
+    fclose(fp);
+    return JSMN_ERROR_INVAL;
+  }
+  fclose(fp);
+
+  jsmn_init(&p);
+  r = jsmn_parse(&p, js, size, NULL, 0);
+  free(js);
+  *len = size;
+  return r;
+}
+
+static jsmnint_t parse_mapped(const char *path, const int flags, size_t *len) {
+  jsmn_parser p;
+  jsmn_file file;
+  jsmnint_t r;
+
+  jsmn_init(&p);
+  r = jsmn_parse_file(path, flags, &file, &p, NULL, 0);
+  *len = file.len;
+  jsmn_file_close(&file);
+  return r;
+}
+
+int main(int argc, char **argv) {
+  int flags = 0, i, m, runs = 5;
+  const char *name[] = { "read", "mmap" };
+  double start, seconds, first[2], best[2];
+  size_t len = 0;
+  jsmnint_t r = 0;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file.json [populate] [huge]\n", argv[0]);
+    return 1;
+  }
+  for (i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "populate") == 0) {
+      flags |= JSMN_MAP_POPULATE;
+    } else if (strcmp(argv[i], "huge") == 0) {
+      flags |= JSMN_MAP_HUGE;
+    }
+  }
+
+  /* Alternate the methods so neither gets a warmer page cache */
+  for (i = 0; i < runs; i++) {
+    for (m = 0; m < 2; m++) {
+      start = now();
+      r = (m == 0 ? parse_read(argv[1], &len) : parse_mapped(argv[1], flags, &len));
+      seconds = now() - start;
+      if (r >= (jsmnint_t)JSMN_ERROR_MAX) {
+        fprintf(stderr, "Failed to parse %s: %d\n", argv[1], (int)r);
+        return 1;
+      }
+      if (i == 0) {
+        first[m] = best[m] = seconds;
+      } else if (seconds < best[m]) {
+        best[m] = seconds;
+      }
+    }
+  }
+
+  for (m = 0; m < 2; m++) {
+    printf("%s: %lu bytes, %lu tokens, first %.1f MB/s, best %.1f MB/s\n",
+           name[m], (unsigned long)len, (unsigned long)r,
+           (double)len / first[m] / (1024 * 1024),
+           (double)len / best[m] / (1024 * 1024));
+  }
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#define _DEFAULT_SOURCE
+#include "../jsmn_reader.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Compares reading a JSON file block by block and parsing each block before
+ * reading the next with jsmn_reader_parse, which keeps reads in flight while
+ * the parser works. The file's pages are dropped from the page cache before
+ * every run (unless "warm" is given) so the reads come from the disk, and the
+ * time the parser spent waiting for input shows how much of the reading was
+ * hidden behind parsing. Tokens are only counted.
+ */
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int open_cold(const char *path, const int warm) {
+  int fd = open(path, O_RDONLY);
+  if (fd >= 0 && !warm) {
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  }
+  return fd;
+}
+
+/* Reads a block, parses what has been read so far, and so on */
+static jsmnint_t parse_serial(const char *path, const size_t block_size, const int warm,
+                              size_t *len, double *io) {
+  int fd = open_cold(path, warm);
+  char *js = NULL;
+  size_t cap = 0;
+  jsmn_parser p;
+  jsmnint_t r = JSMN_ERROR_INVAL;
+  double start;
+  long n;
+
+  *len = 0;
+  *io = 0;
+  if (fd < 0) {
+    return r;
+  }
+  jsmn_init(&p);
+  for (;;) {
+    if (*len + block_size > cap) {
+      cap = (cap != 0 ? cap * 2 : block_size);
+      js = realloc(js, cap);
+    }
+    start = now();
+    n = (long)read(fd, js + *len, block_size);
+    *io += now() - start;
+    if (n < 0) {
+      break;
+    }
+    *len += n;
+    r = jsmn_parse(&p, js, *len, NULL, 0);
+    if (n == 0 || (r < (jsmnint_t)JSMN_ERROR_MAX && p.expected == JSMN_UNDEFINED)) {
+      break;
+    }
+  }
+  free(js);
+  close(fd);
+  return r;
+}
+
+static jsmnint_t parse_reader(const char *path, const size_t block_size, const int depth,
+                              const int warm, size_t *len, double *io, int *uring) {
+  int fd = open_cold(path, warm);
+  jsmn_reader rd;
+  jsmn_parser p;
+  jsmnint_t r = JSMN_ERROR_INVAL;
+
+  *len = 0;
+  *io = 0;
+  *uring = 0;
+  if (fd < 0) {
+    return r;
+  }
+  if (jsmn_reader_open(&rd, fd, block_size, depth) == 0) {
+    jsmn_init(&p);
+    r = jsmn_reader_parse(&rd, &p, NULL, 0);
+    *len = rd.len;
+    *io = rd.wait;
+    *uring = rd.uring;
+    jsmn_reader_close(&rd);
+  }
+  close(fd);
+  return r;
+}
+
+int main(int argc, char **argv) {
+  size_t block_size = 1024 * 1024, len = 0;
+  int i, depth = 4, warm = 0, uring = 0;
+  double start, seconds[2], io[2];
+  jsmnint_t r[2];
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s file.json [depth] [block KB] [warm]\n", argv[0]);
+    return 1;
+  }
+  if (argc > 2) {
+    depth = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    block_size = (size_t)atol(argv[3]) * 1024;
+  }
+  for (i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "warm") == 0) {
+      warm = 1;
+    }
+  }
+
+  start = now();
+  r[0] = parse_serial(argv[1], block_size, warm, &len, &io[0]);
+  seconds[0] = now() - start;
+
+  start = now();
+  r[1] = parse_reader(argv[1], block_size, depth, warm, &len, &io[1], &uring);
+  seconds[1] = now() - start;
+
+  if (r[0] >= (jsmnint_t)JSMN_ERROR_MAX || r[0] != r[1]) {
+    fprintf(stderr, "Failed to parse %s: %d, %d\n", argv[1], (int)r[0], (int)r[1]);
+    return 1;
+  }
+
+  printf("serial: %lu bytes, %lu tokens, %.1f MB/s, %.2f s of %.2f s reading\n",
+         (unsigned long)len, (unsigned long)r[0],
+         (double)len / seconds[0] / (1024 * 1024), io[0], seconds[0]);
+  printf("%s x%d: %lu bytes, %lu tokens, %.1f MB/s, %.2f s of %.2f s waiting for input\n",
+         uring ? "io_uring" : "thread", depth, (unsigned long)len, (unsigned long)r[1],
+         (double)len / seconds[1] / (1024 * 1024), io[1], seconds[1]);
+
+  return 0;
+}
@@ -4,41 +4,122 @@
 
 #include "jsmn.h"
 
+/* Nonzero if the parser checks the grammar, see JSMN_TRUSTED */
+#if !defined(JSMN_TRUSTED)
+# define JSMN_CHECKING(parser) JSMN_TRUE
+#else
+# define JSMN_CHECKING(parser) (!(parser)->trusted)
+#endif
+
 /**
  * Allocates a fresh unused token from the token pool.
  */
 static
-jsmntok_t *jsmn_alloc_token(jsmn_parser *parser, jsmntok_t *tokens,
-                            const size_t num_tokens)
+jsmnint_t jsmn_alloc_token(jsmn_parser *parser, jsmntokens_t *tokens,
+                           const size_t num_tokens)
 {
-  if (parser->toknext >= num_tokens) {
-    return NULL;
+  /* Token ids must stay clear of the error codes */
+  if (parser->toknext >= num_tokens ||
+      parser->toknext >= (jsmnint_t)JSMN_ERROR_MAX - 1) {
+    return JSMN_NEG;
   }
+#if defined(JSMN_BLOCK_TOKENS)
+  /* Ask for another block once the directory is full */
+  if ((size_t)(parser->toknext >> JSMN_BLOCK_SHIFT) >= tokens->num_blocks &&
+      (tokens->grow == NULL || !tokens->grow(tokens) ||
+       (size_t)(parser->toknext >> JSMN_BLOCK_SHIFT) >= tokens->num_blocks)) {
+    return JSMN_NEG;
+  }
+#endif
 
-  jsmntok_t *tok = &tokens[parser->toknext++];
-  tok->start = tok->end = JSMN_NEG;
-  tok->size = 0;
+  jsmnint_t tok = parser->toknext++;
+  JSMN_TOK_START(tokens, tok) = JSMN_TOK_END(tokens, tok) = JSMN_NEG;
+  JSMN_TOK_SIZE(tokens, tok) = 0;
+#if defined(JSMN_PAIR_TOKENS)
+  JSMN_TOK_KEY_START(tokens, tok) = JSMN_TOK_KEY_END(tokens, tok) = JSMN_NEG;
+#endif
 #if defined(JSMN_PARENT_LINKS)
-  tok->parent = JSMN_NEG;
+  JSMN_TOK_PARENT(tokens, tok) = JSMN_NEG;
 #endif
 #if defined(JSMN_NEXT_SIBLING)
-  tok->next_sibling = JSMN_NEG;
+  JSMN_TOK_NEXT_SIBLING(tokens, tok) = JSMN_NEG;
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+  JSMN_TOK_ELEMENTS(tokens, tok) = JSMN_NEG;
 #endif
   parser->count++;
   return tok;
 }
 
+#if defined(JSMN_SEGMENTED_TOKENS)
+/**
+ * Stores pos relative to the current segment, starting a new segment when pos
+ * is out of its reach. Positions are stored in increasing order, so the newest
+ * segment is always the right one.
+ */
+static
+jsmnint_t jsmn_segment_pos(jsmn_parser *parser, const jsmnpos_t pos,
+                           unsigned char *segment, jsmnint_t *offset)
+{
+  if (pos - parser->segments[parser->segment] >= JSMNINT_MAX) {
+    if (parser->segment + 1 >= JSMN_SEGMENTS) {
+      return JSMN_ERROR_LENGTH;
+    }
+    parser->segments[++parser->segment] = pos;
+  }
+  *segment = parser->segment;
+  *offset = pos - parser->segments[parser->segment];
+  return JSMN_SUCCESS;
+}
+#endif
+
+/**
+ * Sets a token's end boundary.
+ */
+static
+jsmnint_t jsmn_token_end(jsmn_parser *parser, jsmntokens_t *tokens,
+                         const jsmnint_t token, const jsmnpos_t end)
+{
+#if !defined(JSMN_SEGMENTED_TOKENS)
+  (void)parser;
+  JSMN_TOK_END(tokens, token) = end;
+  return JSMN_SUCCESS;
+#else
+  if (end == JSMN_POS_NEG) {
+    JSMN_TOK_END(tokens, token) = JSMN_NEG;
+    return JSMN_SUCCESS;
+  }
+  return jsmn_segment_pos(parser, end, &JSMN_TOK(tokens, token).end_segment,
+                          &JSMN_TOK(tokens, token).end);
+#endif
+}
+
 /**
  * Fills token type and boundaries.
  */
 static
-void jsmn_fill_token(jsmntok_t *token, const jsmntype_t type,
-                     const jsmnint_t start, const jsmnint_t end)
+jsmnint_t jsmn_fill_token(jsmn_parser *parser, jsmntokens_t *tokens,
+                          const jsmnint_t token, const jsmntype_t type,
+                          const jsmnpos_t start, const jsmnpos_t end)
 {
-  token->type = type;
-  token->start = start;
-  token->end = end;
-  token->size = 0;
+  JSMN_TOK_TYPE(tokens, token) = type;
+  JSMN_TOK_SIZE(tokens, token) = 0;
+#if defined(JSMN_PAIR_TOKENS)
+  /* Object members carry the key that was parsed before them */
+  if (type & JSMN_INSD_OBJ) {
+    JSMN_TOK_KEY_START(tokens, token) = parser->key_start;
+    JSMN_TOK_KEY_END(tokens, token) = parser->key_end;
+  }
+#endif
+#if !defined(JSMN_SEGMENTED_TOKENS)
+  JSMN_TOK_START(tokens, token) = start;
+#else
+  if (jsmn_segment_pos(parser, start, &JSMN_TOK(tokens, token).start_segment,
+                       &JSMN_TOK(tokens, token).start) != JSMN_SUCCESS) {
+    return JSMN_ERROR_LENGTH;
+  }
+#endif
+  return jsmn_token_end(parser, tokens, token, end);
 }
 
 #if defined(JSMN_NEXT_SIBLING)
@@ -46,7 +127,7 @@ void jsmn_fill_token(jsmntok_t *token, const jsmntype_t type,
  * Set previous child's next_sibling to current token
  */
 static
-void jsmn_next_sibling(jsmn_parser *parser, jsmntok_t *tokens)
+void jsmn_next_sibling(jsmn_parser *parser, jsmntokens_t *tokens)
 {
   jsmnint_t sibling;
 
@@ -63,12 +144,84 @@ void jsmn_next_sibling(jsmn_parser *parser, jsmntok_t *tokens)
   }
 
   /* Loop until we find previous sibling */
-  while (tokens[sibling].next_sibling != JSMN_NEG) {
-    sibling = tokens[sibling].next_sibling;
+  while (JSMN_TOK_NEXT_SIBLING(tokens, sibling) != JSMN_NEG) {
+    sibling = JSMN_TOK_NEXT_SIBLING(tokens, sibling);
   }
 
   /* Set previous sibling's next_sibling to current token */
-  tokens[sibling].next_sibling = parser->toknext - 1;
+  JSMN_TOK_NEXT_SIBLING(tokens, sibling) = parser->toknext - 1;
+}
+#endif
+
+#if defined(JSMN_COMPACT_ARRAYS)
+/**
+ * Finds the end of a number that has already been checked, and the type its
+ * token gets as an ARRAY element.
+ */
+static
+jsmnpos_t jsmn_compact_number(const char *js, jsmnpos_t pos, jsmntype_t *type)
+{
+  *type = JSMN_PRIMITIVE | JSMN_VALUE;
+  if (js[pos] == '-') {
+    *type |= JSMN_PRI_MINUS;
+    pos++;
+  }
+  for (;; pos++) {
+    if (js[pos] >= '0' && js[pos] <= '9') {
+      continue;
+    }
+    if (js[pos] == '.') {
+      *type |= JSMN_PRI_DECIMAL;
+    } else if (js[pos] == 'e' || js[pos] == 'E') {
+      *type |= JSMN_PRI_EXPONENT;
+    } else if (js[pos] != '-' && js[pos] != '+') {
+      return pos;
+    }
+  }
+}
+
+/**
+ * Gives the elements of the compact ARRAY being parsed their tokens, it
+ * becomes an ordinary ARRAY. Nothing changes if there are not enough tokens.
+ */
+static
+jsmnint_t jsmn_compact_expand(jsmn_parser *parser, const char *js,
+                              jsmntokens_t *tokens, const size_t num_tokens)
+{
+  const jsmnint_t array = parser->compact;
+  const jsmnint_t first = JSMN_TOK_ELEMENTS(tokens, array);
+  const jsmnint_t size = parser->offsets[first];
+  const jsmnint_t toknext = parser->toknext, count = parser->count;
+  jsmnint_t i, token;
+  jsmntype_t type;
+
+  for (i = 0; i < size; i++) {
+    token = jsmn_alloc_token(parser, tokens, num_tokens);
+    if (token == JSMN_NEG) {
+      parser->toknext = toknext;
+      parser->count = count;
+      return JSMN_ERROR_NOMEM;
+    }
+    jsmnpos_t start = parser->offsets[first + 1 + i];
+    jsmnpos_t end = jsmn_compact_number(js, start, &type);
+    jsmn_fill_token(parser, tokens, token, type, start, end);
+#if defined(JSMN_PARENT_LINKS)
+    JSMN_TOK_PARENT(tokens, token) = array;
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+    /* The elements are the array's only tokens, in order */
+    if (i != 0) {
+      JSMN_TOK_NEXT_SIBLING(tokens, token - 1) = token;
+    }
+#endif
+  }
+
+  JSMN_TOK_SIZE(tokens, array) = size;
+  JSMN_TOK_ELEMENTS(tokens, array) = JSMN_NEG;
+  parser->offnext = first;
+  parser->compact = JSMN_NEG;
+
+  return JSMN_SUCCESS;
 }
 #endif
 
@@ -111,20 +264,64 @@ jsmnbool isSpecialChar(const char c)
   return JSMN_FALSE;
 }
 
+/* Every byte of a size_t set to 0x01, and to 0x80 */
+#define JSMN_SWAR_ONES  ((size_t)-1 / 0xFF)
+#define JSMN_SWAR_HIGHS (JSMN_SWAR_ONES * 0x80)
+/* Nonzero if any byte of word equals c */
+#define JSMN_SWAR_HAS(word, c) \
+  ((((word) ^ (JSMN_SWAR_ONES * (unsigned char)(c))) - JSMN_SWAR_ONES) & \
+   ~((word) ^ (JSMN_SWAR_ONES * (unsigned char)(c))) & JSMN_SWAR_HIGHS)
+/* Nonzero if any byte of word is below n (n <= 0x80) */
+#define JSMN_SWAR_LESS(word, n) \
+  (((word) - JSMN_SWAR_ONES * (n)) & ~(word) & JSMN_SWAR_HIGHS)
+/* Nonzero if every byte of word is a digit, '0' - '9' */
+#define JSMN_SWAR_DIGITS(word) \
+  (((word) & (JSMN_SWAR_ONES * 0xF0)) == JSMN_SWAR_ONES * 0x30 && \
+   (((word) + JSMN_SWAR_ONES * 0x06) & (JSMN_SWAR_ONES * 0xF0)) == JSMN_SWAR_ONES * 0x30)
+
+/**
+ * Reads a size_t worth of bytes from any alignment, compilers turn this into
+ * a single load.
+ */
+static
+size_t jsmn_swar_load(const char *js)
+{
+  size_t word = 0, i;
+  for (i = 0; i < sizeof(size_t); i++) {
+    word |= (size_t)(unsigned char)js[i] << (i * CHAR_BIT);
+  }
+  return word;
+}
+
+#if !defined(JSMN_PERMISSIVE_PRIMITIVE)
+/**
+ * Reads 4 bytes from any alignment, for comparing literals a word at a time.
+ */
+static
+unsigned long jsmn_load4(const char *js)
+{
+  return (unsigned long)(unsigned char)js[0] |
+         (unsigned long)(unsigned char)js[1] << 8 |
+         (unsigned long)(unsigned char)js[2] << 16 |
+         (unsigned long)(unsigned char)js[3] << 24;
+}
+#endif
+
 /**
  * Fills next available token with JSON primitive.
  */
 static
 jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
-                               const size_t len, jsmntok_t *tokens,
+                               const size_t len, jsmntokens_t *tokens,
                                const size_t num_tokens)
 {
   /* If a PRIMITIVE wasn't expected */
-  if (!(parser->expected & (JSMN_PRIMITIVE | JSMN_PRI_CONTINUE))) {
+  if (JSMN_CHECKING(parser) &&
+      !(parser->expected & (JSMN_PRIMITIVE | JSMN_PRI_CONTINUE))) {
     return JSMN_ERROR_INVAL;
   }
 
-  jsmnint_t pos;
+  jsmnpos_t pos;
   jsmntype_t type;
   jsmntype_t expected = JSMN_CLOSE;
 
@@ -132,10 +329,10 @@ jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
     pos = parser->pos;
   } else {
     if (tokens != NULL) {
-      pos = tokens[parser->toknext - 1].start;
+      pos = JSMN_TOK_POS_START(parser, tokens, parser->toknext - 1);
     } else {
       pos = parser->pos;
-      while (pos != JSMN_NEG &&
+      while (pos != JSMN_POS_NEG &&
              !isWhitespace(js[pos]) &&
              !isSpecialChar(js[pos]) &&
              isCharacter(js[pos])) {
@@ -147,10 +344,82 @@ jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
   type = JSMN_PRIMITIVE;
 
 #if !defined(JSMN_PERMISSIVE_PRIMITIVE)
+  const jsmnpos_t start = pos;
+# if defined(JSMN_TRUSTED)
+  if (parser->trusted) {
+    /* Only find the end, and the JSMN_PRI_* bits checking would have given */
+    switch (js[pos]) {
+    case 't':
+    case 'n':
+      pos += 4;
+      break;
+    case 'f':
+      pos += 5;
+      break;
+#  if defined(JSMN_PERMISSIVE_LITERALS)
+    case 'N':
+      pos += 3;
+      break;
+    case 'I':
+      pos += 8;
+      break;
+#  endif
+    default:
+      if (js[pos] == '-') {
+        type |= JSMN_PRI_MINUS;
+        pos++;
+      }
+      for (; pos < len; pos++) {
+        if (js[pos] >= '0' && js[pos] <= '9') {
+          continue;
+        }
+        if (js[pos] == '.') {
+          type |= JSMN_PRI_DECIMAL;
+        } else if (js[pos] == 'e' || js[pos] == 'E') {
+          type |= JSMN_PRI_EXPONENT;
+        } else if (js[pos] != '-' && js[pos] != '+') {
+          break;
+        }
+      }
+      goto found;
+    }
+    type |= JSMN_PRI_LITERAL;
+    if (pos > len) {
+      return JSMN_ERROR_PART;
+    }
+    goto found;
+  }
+# endif
+  /* Complete literals are compared a word at a time */
+  if (len - pos >= 4) {
+    const unsigned long word = jsmn_load4(js + pos);
+    jsmnint_t length = 0;
+    if (word == jsmn_load4("true") || word == jsmn_load4("null")) {
+      length = 4;
+    } else if (js[pos] == 'f' && len - pos >= 5 &&
+               jsmn_load4(js + pos + 1) == jsmn_load4("alse")) {
+      length = 5;
+# if defined(JSMN_PERMISSIVE_LITERALS)
+    } else if (word == jsmn_load4("Infi") && len - pos >= 8 &&
+               jsmn_load4(js + pos + 4) == jsmn_load4("nity")) {
+      length = 8;
+# endif
+    }
+    if (length != 0) {
+      pos += length;
+      type |= JSMN_PRI_LITERAL;
+      if (pos == len) {
+        goto found;
+      }
+      goto check_primitive_border;
+    }
+  }
+
+  /* Anything else that starts like a literal is partial or invalid */
 # if !defined(JSMN_PERMISSIVE_LITERALS)
-  char literal[][6] = { "true", "false", "null" };
+  static const char literal[][6] = { "true", "false", "null" };
 # else
-  char literal[][9] = { "true", "false", "null", "NaN", "Infinity" };
+  static const char literal[][9] = { "true", "false", "null", "NaN", "Infinity" };
 # endif
   jsmnint_t i;
   for (i = 0; i < sizeof(literal) / sizeof(literal[0]); i++) {
@@ -176,7 +445,7 @@ jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
 
   expected = JSMN_PRI_MINUS | JSMN_PRI_INTEGER;
   for (; pos < len; pos++) {
-    if (js[pos] == '0') {
+    if (js[pos] >= '0' && js[pos] <= '9') {
       if (!(expected & JSMN_PRI_INTEGER)) {
         return JSMN_ERROR_INVAL;
       }
@@ -184,25 +453,18 @@ jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
         expected = JSMN_PRI_INTEGER |                                        JSMN_CLOSE;
       } else if (type & JSMN_PRI_DECIMAL) {
         expected = JSMN_PRI_INTEGER |                    JSMN_PRI_EXPONENT | JSMN_CLOSE;
-      } else if (parser->pos == pos ||
-                 (parser->pos + 1 == pos && (type & JSMN_PRI_MINUS))) {
+      } else if (js[pos] == '0' &&
+                 (start == pos ||
+                  (start + 1 == pos && (type & JSMN_PRI_MINUS)))) {
         expected =                    JSMN_PRI_DECIMAL | JSMN_PRI_EXPONENT | JSMN_CLOSE;
+        continue;
       } else {
         expected = JSMN_PRI_INTEGER | JSMN_PRI_DECIMAL | JSMN_PRI_EXPONENT | JSMN_CLOSE;
       }
-      continue;
-    }
-
-    if (js[pos] >= '1' && js[pos] <= '9') {
-      if (!(expected & JSMN_PRI_INTEGER)) {
-        return JSMN_ERROR_INVAL;
-      }
-      if (type & JSMN_PRI_EXPONENT) {
-        expected = JSMN_PRI_INTEGER |                                        JSMN_CLOSE;
-      } else if (type & JSMN_PRI_DECIMAL) {
-        expected = JSMN_PRI_INTEGER |                    JSMN_PRI_EXPONENT | JSMN_CLOSE;
-      } else {
-        expected = JSMN_PRI_INTEGER | JSMN_PRI_DECIMAL | JSMN_PRI_EXPONENT | JSMN_CLOSE;
+      /* The digits that follow leave expected as it is, take them a word at a time */
+      while (len - pos > sizeof(size_t) &&
+             JSMN_SWAR_DIGITS(jsmn_swar_load(js + pos + 1))) {
+        pos += sizeof(size_t);
       }
       continue;
     }
@@ -211,7 +473,7 @@ jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
       if (!(expected & JSMN_PRI_MINUS)) {
         return JSMN_ERROR_INVAL;
       }
-      if (parser->pos == pos) {
+      if (start == pos) {
         type |= JSMN_PRI_MINUS;
       }
       expected = JSMN_PRI_INTEGER;
@@ -249,8 +511,9 @@ jsmnint_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
     }
     goto check_primitive_border;
   }
+  /* The number was cut short, more data may complete it */
   if (!(expected & JSMN_CLOSE)) {
-    return JSMN_ERROR_INVAL;
+    return JSMN_ERROR_PART;
   }
   goto found;
 
@@ -315,6 +578,9 @@ found:
   if (pos == len) {
     parser->expected |= JSMN_PRI_CONTINUE;
   }
+#if defined(JSMN_EVENTS)
+  parser->type = type;
+#endif
 
   if (tokens == NULL) {
     parser->pos = pos - 1;
@@ -324,38 +590,69 @@ found:
     return JSMN_SUCCESS;
   }
 
-  jsmntok_t *token;
+  jsmnint_t token, r;
+#if defined(JSMN_COMPACT_ARRAYS)
+  /* Anything else has expanded the array already, this is a number */
+  if (parser->compact != JSMN_NEG) {
+    if (pos == len) {
+      /* It may go on in the next chunk, parse it again then */
+      parser->expected = expected;
+      return JSMN_ERROR_PART;
+    }
+    if (parser->offnext < parser->num_offsets) {
+      parser->offsets[parser->offnext++] = parser->pos;
+      parser->offsets[JSMN_TOK_ELEMENTS(tokens, parser->compact)]++;
+      parser->pos = pos - 1;
+      return JSMN_SUCCESS;
+    }
+    r = jsmn_compact_expand(parser, js, tokens, num_tokens);
+    if (r != JSMN_SUCCESS) {
+      parser->expected = expected;
+      return r;
+    }
+  }
+#endif
   if (!(expected & JSMN_PRI_CONTINUE)) {
     token = jsmn_alloc_token(parser, tokens, num_tokens);
-    if (token == NULL) {
+    if (token == JSMN_NEG) {
       parser->expected = expected;
       return JSMN_ERROR_NOMEM;
     }
-    jsmn_fill_token(token, type, parser->pos, pos);
+    r = jsmn_fill_token(parser, tokens, token, type, parser->pos, pos);
   } else {
-    token = &tokens[parser->toknext - 1];
-    jsmn_fill_token(token, type, token->start, pos);
+    token = parser->toknext - 1;
+    JSMN_TOK_TYPE(tokens, token) = type;
+    r = jsmn_token_end(parser, tokens, token, pos);
+  }
+  if (r != JSMN_SUCCESS) {
+    return r;
   }
   parser->pos = pos;
+  /* A continued token is already linked */
 #if defined(JSMN_PARENT_LINKS)
-  token->parent = parser->toksuper;
+  if (!(expected & JSMN_PRI_CONTINUE)) {
+    JSMN_TOK_PARENT(tokens, token) = parser->toksuper;
+  }
 #endif
 #if defined(JSMN_NEXT_SIBLING)
-  jsmn_next_sibling(parser, tokens);
+  if (!(expected & JSMN_PRI_CONTINUE)) {
+    jsmn_next_sibling(parser, tokens);
+  }
 #endif
 
   if (parser->toksuper != JSMN_NEG) {
     if (!(expected & JSMN_PRI_CONTINUE)) {
-      tokens[parser->toksuper].size++;
+      JSMN_TOK_SIZE(tokens, parser->toksuper)++;
     }
 
-    if (!(tokens[parser->toksuper].type & JSMN_CONTAINER)) {
+    if (!(JSMN_TOK_TYPE(tokens, parser->toksuper) & JSMN_CONTAINER)) {
 #if defined(JSMN_PARENT_LINKS)
-      parser->toksuper = tokens[parser->toksuper].parent;
+      parser->toksuper = JSMN_TOK_PARENT(tokens, parser->toksuper);
 #else
       jsmnint_t i;
       for (i = parser->toksuper; i != JSMN_NEG; i--) {
-        if (tokens[i].type & JSMN_CONTAINER && tokens[i].end == JSMN_NEG) {
+        if (JSMN_TOK_TYPE(tokens, i) & JSMN_CONTAINER &&
+            JSMN_TOK_END(tokens, i) == JSMN_NEG) {
           parser->toksuper = i;
           break;
         }
@@ -378,21 +675,38 @@ found:
  */
 static
 jsmnint_t jsmn_parse_string(jsmn_parser *parser, const char *js,
-                            const size_t len, jsmntok_t *tokens,
+                            const size_t len, jsmntokens_t *tokens,
                             const size_t num_tokens)
 {
   /* If a STRING wasn't expected */
-  if (!(parser->expected & JSMN_STRING)) {
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_STRING)) {
     return JSMN_ERROR_INVAL;
   }
 
-  jsmnint_t pos = parser->pos;
+  jsmnpos_t pos = parser->pos;
 
   /* Skip starting quote */
   pos++;
 
+  /* Bytes before slow are inside a word that has to be looked at byte by byte */
+  jsmnpos_t slow = pos;
   char c;
   for (; pos < len && js[pos] != '\0'; pos++) {
+    /* Skip a word at a time while there is no quote, backslash, or control character */
+    if (pos >= slow) {
+      while (len - pos >= sizeof(size_t)) {
+        size_t word = jsmn_swar_load(js + pos);
+        if (JSMN_SWAR_HAS(word, '"') | JSMN_SWAR_HAS(word, '\\') |
+            JSMN_SWAR_LESS(word, 0x20)) {
+          break;
+        }
+        pos += sizeof(size_t);
+      }
+      slow = pos + sizeof(size_t);
+      if (pos == len || js[pos] == '\0') {
+        break;
+      }
+    }
     c = js[pos];
 
     /* Quote: end of string */
@@ -423,36 +737,52 @@ jsmnint_t jsmn_parse_string(jsmn_parser *parser, const char *js,
         type = JSMN_STRING | JSMN_VALUE;
       }
 
+#if defined(JSMN_EVENTS)
+      parser->type = type;
+#endif
+#if defined(JSMN_PAIR_TOKENS)
+      /* Keys don't get a token, their value token stores them */
+      if (type & JSMN_KEY) {
+        parser->key_start = parser->pos + 1;
+        parser->key_end = pos;
+        parser->pos = pos;
+        return JSMN_SUCCESS;
+      }
+#endif
+
       if (tokens == NULL) {
         parser->pos = pos;
         parser->count++;
         return JSMN_SUCCESS;
       }
 
-      jsmntok_t *token = jsmn_alloc_token(parser, tokens, num_tokens);
-      if (token == NULL) {
+      jsmnint_t token = jsmn_alloc_token(parser, tokens, num_tokens);
+      if (token == JSMN_NEG) {
         parser->expected = expected;
         return JSMN_ERROR_NOMEM;
       }
-      jsmn_fill_token(token, type, parser->pos + 1, pos);
+      if (jsmn_fill_token(parser, tokens, token, type, parser->pos + 1, pos) != JSMN_SUCCESS) {
+        return JSMN_ERROR_LENGTH;
+      }
       parser->pos = pos;
 #if defined(JSMN_PARENT_LINKS)
-      token->parent = parser->toksuper;
+      JSMN_TOK_PARENT(tokens, token) = parser->toksuper;
 #endif
 #if defined(JSMN_NEXT_SIBLING)
       jsmn_next_sibling(parser, tokens);
 #endif
 
       if (parser->toksuper != JSMN_NEG) {
-        tokens[parser->toksuper].size++;
+        JSMN_TOK_SIZE(tokens, parser->toksuper)++;
 
-        if (!(tokens[parser->toksuper].type & JSMN_CONTAINER)) {
+        if (!(JSMN_TOK_TYPE(tokens, parser->toksuper) & JSMN_CONTAINER)) {
 #if defined(JSMN_PARENT_LINKS)
-          parser->toksuper = tokens[parser->toksuper].parent;
+          parser->toksuper = JSMN_TOK_PARENT(tokens, parser->toksuper);
 #else
           jsmnint_t i;
           for (i = parser->toksuper; i != JSMN_NEG; i--) {
-            if (tokens[i].type & JSMN_CONTAINER && tokens[i].end == JSMN_NEG) {
+            if (JSMN_TOK_TYPE(tokens, i) & JSMN_CONTAINER &&
+                JSMN_TOK_END(tokens, i) == JSMN_NEG) {
               parser->toksuper = i;
               break;
             }
@@ -472,6 +802,11 @@ jsmnint_t jsmn_parse_string(jsmn_parser *parser, const char *js,
     /* Backslash: Quoted symbol expected */
     if (c == '\\' && pos + 1 < len) {
       pos++;
+#if defined(JSMN_TRUSTED)
+      if (parser->trusted) {
+        continue;
+      }
+#endif
       switch (js[pos]) {
       /* Allowed escaped symbols */
       case '"':
@@ -486,7 +821,7 @@ jsmnint_t jsmn_parse_string(jsmn_parser *parser, const char *js,
       /* Allows escaped symbol \uhhhh */
       case 'u':
         pos++;
-        jsmnint_t i;
+        jsmnpos_t i;
         for (i = pos + 4; pos < i; pos++) {
           if (pos == len ||
               js[pos] == '\0') {
@@ -523,11 +858,12 @@ jsmnint_t jsmn_parse_string(jsmn_parser *parser, const char *js,
     }
 
     /* form feed, new line, carraige return, tab, and vertical tab not allowed */
-    else if (c == '\f' ||
-             c == '\n' ||
-             c == '\r' ||
-             c == '\t' ||
-             c == '\v') {
+    else if (JSMN_CHECKING(parser) &&
+             (c == '\f' ||
+              c == '\n' ||
+              c == '\r' ||
+              c == '\t' ||
+              c == '\v')) {
       return JSMN_ERROR_INVAL;
     }
   }
@@ -536,13 +872,14 @@ jsmnint_t jsmn_parse_string(jsmn_parser *parser, const char *js,
 
 static
 jsmnint_t jsmn_parse_container_open(jsmn_parser *parser, const char c,
-                                    jsmntok_t *tokens, const size_t num_tokens)
+                                    jsmntokens_t *tokens, const size_t num_tokens)
 {
   /* If an OBJECT or ARRAY wasn't expected */
-  if (!(parser->expected & JSMN_CONTAINER)) {
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_CONTAINER)) {
     return JSMN_ERROR_INVAL;
   }
 
+  jsmntype_t expected = parser->expected;
   jsmntype_t type;
   if (c == '{') {
     parser->expected = JSMN_OPEN_OBJECT;
@@ -562,144 +899,529 @@ jsmnint_t jsmn_parse_container_open(jsmn_parser *parser, const char c,
     return JSMN_SUCCESS;
   }
 
+#if !defined(JSMN_PAIR_TOKENS)
   if (parser->toksuper != JSMN_NEG &&
-      tokens[parser->toksuper].type & JSMN_INSD_OBJ) {
+      JSMN_TOK_TYPE(tokens, parser->toksuper) & JSMN_INSD_OBJ) {
+    type |= JSMN_INSD_OBJ;
+  }
+#else
+  /* toksuper is the object itself, there is no key token in between */
+  if (expected & JSMN_INSD_OBJ) {
     type |= JSMN_INSD_OBJ;
   }
+#endif
 
-  jsmntok_t *token = jsmn_alloc_token(parser, tokens, num_tokens);
-  if (token == NULL) {
+  jsmnint_t token = jsmn_alloc_token(parser, tokens, num_tokens);
+  if (token == JSMN_NEG) {
+    parser->expected = expected;
     return JSMN_ERROR_NOMEM;
   }
-  jsmn_fill_token(token, type, parser->pos, JSMN_NEG);
+  if (jsmn_fill_token(parser, tokens, token, type, parser->pos, JSMN_POS_NEG) != JSMN_SUCCESS) {
+    return JSMN_ERROR_LENGTH;
+  }
 #if defined(JSMN_PARENT_LINKS)
-  token->parent = parser->toksuper;
+  JSMN_TOK_PARENT(tokens, token) = parser->toksuper;
 #endif
 #if defined(JSMN_NEXT_SIBLING)
   jsmn_next_sibling(parser, tokens);
 #endif
 
   if (parser->toksuper != JSMN_NEG) {
-    tokens[parser->toksuper].size++;
+    JSMN_TOK_SIZE(tokens, parser->toksuper)++;
   }
   parser->toksuper = parser->toknext - 1;
 
+#if defined(JSMN_COMPACT_ARRAYS)
+  /* Every ARRAY starts out compact, with its element count in the table */
+  if ((type & JSMN_ARRAY) && parser->offnext < parser->num_offsets) {
+    JSMN_TOK_ELEMENTS(tokens, token) = parser->offnext;
+    parser->offsets[parser->offnext++] = 0;
+    parser->compact = token;
+  }
+#endif
+
   return JSMN_SUCCESS;
 }
 
+#if defined(JSMN_LAZY_TOKENS)
+/**
+ * Finds the bracket closing the container opened at *pos.
+ *
+ * Works a word at a time, only words holding a quote, backslash, bracket, or
+ * NUL are looked at byte by byte. Inner brackets are only counted, they are
+ * matched when the container is expanded.
+ */
 static
-jsmnint_t jsmn_parse_container_close(jsmn_parser *parser, const char c,
-                                     jsmntok_t *tokens)
+jsmnint_t jsmn_skip_container(const char *js, const size_t len, jsmnpos_t *pos)
 {
-  /* If an OBJECT or ARRAY CLOSE wasn't expected */
-  if (!(parser->expected & JSMN_CLOSE)) {
-    return JSMN_ERROR_INVAL;
-  }
-
-  if (tokens == NULL) {
-    if (parser->toksuper < (sizeof(jsmnint_t) * CHAR_BIT)) {
-      jsmntype_t type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
-      if ((((parser->toknext & (1 << parser->toksuper)) == 1) && !(type & JSMN_OBJECT)) ||
-          (((parser->toknext & (1 << parser->toksuper)) == 0) && !(type & JSMN_ARRAY))) {
-        return JSMN_ERROR_BRACKETS;
+  const char open = js[*pos];
+  size_t depth = 1;
+  jsmnbool in_string = JSMN_FALSE;
+  jsmnpos_t i = *pos + 1, stop;
+
+  while (i < len) {
+    if (len - i >= sizeof(size_t)) {
+      size_t word = jsmn_swar_load(js + i), hit;
+      hit = JSMN_SWAR_HAS(word, '"') | JSMN_SWAR_HAS(word, '\\') | JSMN_SWAR_HAS(word, '\0');
+      if (!in_string) {
+        hit |= JSMN_SWAR_HAS(word, '{') | JSMN_SWAR_HAS(word, '}') |
+               JSMN_SWAR_HAS(word, '[') | JSMN_SWAR_HAS(word, ']');
       }
-      parser->toknext &= ~(1 << parser->toksuper);
-    }
-    parser->toksuper--;
-  } else {
-#if defined(JSMN_PERMISSIVE_RULESET)
-    if (parser->toksuper == JSMN_NEG) {
-      return JSMN_ERROR_BRACKETS;
-    }
-#endif
-    jsmntype_t type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
-    jsmntok_t *token = &tokens[parser->toksuper];
-
-    if (!(token->type & type) ||
-        token->end != JSMN_NEG) {
-      return JSMN_ERROR_BRACKETS;
-    }
-    token->end = parser->pos + 1;
-#if defined(JSMN_PARENT_LINKS)
-    if (token->type & JSMN_INSD_OBJ &&
-        !(tokens[token->parent].type & JSMN_CONTAINER)) {
-      parser->toksuper = tokens[token->parent].parent;
+      if (hit == 0) {
+        i += sizeof(size_t);
+        continue;
+      }
+      stop = i + sizeof(size_t);
     } else {
-      parser->toksuper = token->parent;
+      stop = len;
     }
-#else
-    jsmnint_t i;
-    for (i = parser->toksuper - 1; i != JSMN_NEG; i--) {
-      if (tokens[i].type & JSMN_CONTAINER && tokens[i].end == JSMN_NEG) {
-        parser->toksuper = i;
-        break;
+
+    for (; i < stop; i++) {
+      char c = js[i];
+      if (c == '\0') {
+        return JSMN_ERROR_PART;
+      }
+      if (in_string) {
+        if (c == '\\') {
+          i++;
+        } else if (c == '"') {
+          in_string = JSMN_FALSE;
+        }
+        continue;
+      }
+      if (c == '"') {
+        in_string = JSMN_TRUE;
+      } else if (c == '{' || c == '[') {
+        depth++;
+      } else if ((c == '}' || c == ']') && --depth == 0) {
+        if ((open == '{') != (c == '}')) {
+          return JSMN_ERROR_BRACKETS;
+        }
+        *pos = i;
+        return JSMN_SUCCESS;
       }
     }
-    if (i == JSMN_NEG) {
-      parser->toksuper = i;
-    }
-#endif
-  }
-
-  if (parser->toksuper != JSMN_NEG) {
-    parser->expected = JSMN_AFTR_CLOSE;
-  } else {
-    parser->expected = JSMN_ROOT;
   }
-
-  return JSMN_SUCCESS;
+  return JSMN_ERROR_PART;
 }
 
+/**
+ * Fills next token with an OBJECT or ARRAY that is not expanded.
+ */
 static
-jsmnint_t jsmn_parse_colon(jsmn_parser *parser, jsmntok_t *tokens)
+jsmnint_t jsmn_parse_unexpanded(jsmn_parser *parser, const char *js,
+                                const size_t len, jsmntokens_t *tokens,
+                                const size_t num_tokens)
 {
-  /* If a COLON wasn't expected */
-  if (!(parser->expected & JSMN_COLON)) {
+  /* If an OBJECT or ARRAY wasn't expected */
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_CONTAINER)) {
     return JSMN_ERROR_INVAL;
   }
 
+  jsmnpos_t end = parser->pos;
+  jsmnint_t r = jsmn_skip_container(js, len, &end);
+  if (r != JSMN_SUCCESS) {
+    return r;
+  }
+
+  jsmntype_t expected = parser->expected;
   if (parser->toksuper != JSMN_NEG) {
-    parser->expected = JSMN_AFTR_COLON;
-#if defined(JSMN_PERMISSIVE_RULESET)
+    parser->expected = JSMN_AFTR_CLOSE;
   } else {
-    parser->expected = JSMN_AFTR_COLON_R;
-#endif
+    /* A closed OBJECT or ARRAY can't be a key */
+    parser->expected = JSMN_ROOT_AFTR_O;
   }
 
   if (tokens == NULL) {
+    parser->pos = end;
+    parser->count++;
     return JSMN_SUCCESS;
   }
 
-#if defined(JSMN_PERMISSIVE_RULESET)
-  tokens[parser->toknext - 1].type &= ~JSMN_VALUE;
-  tokens[parser->toknext - 1].type |= JSMN_KEY;
+  /* Same type as jsmn_parse_container_open would give it */
+  jsmntype_t type = (js[parser->pos] == '{' ? JSMN_OBJECT : JSMN_ARRAY) |
+                    JSMN_VALUE | JSMN_UNEXPANDED;
+#if !defined(JSMN_PAIR_TOKENS)
+  if (parser->toksuper != JSMN_NEG &&
+      JSMN_TOK_TYPE(tokens, parser->toksuper) & JSMN_INSD_OBJ) {
+    type |= JSMN_INSD_OBJ;
+  }
+#else
+  if (expected & JSMN_INSD_OBJ) {
+    type |= JSMN_INSD_OBJ;
+  }
 #endif
 
-  parser->toksuper = parser->toknext - 1;
-
-  return JSMN_SUCCESS;
-}
-
-static
-jsmnint_t jsmn_parse_comma(jsmn_parser *parser, jsmntok_t *tokens)
-{
-  /* If a COMMA wasn't expected */
-  if (!(parser->expected & JSMN_COMMA)) {
-    return JSMN_ERROR_INVAL;
+  jsmnint_t token = jsmn_alloc_token(parser, tokens, num_tokens);
+  if (token == JSMN_NEG) {
+    parser->expected = expected;
+    return JSMN_ERROR_NOMEM;
   }
-
-  jsmntype_t type = JSMN_UNDEFINED; /*!< parent's type */
-  if (tokens == NULL) {
-    if (parser->toksuper < (sizeof(jsmnint_t) * CHAR_BIT) &&
-        parser->toknext & (1 << parser->toksuper)) {
-      type = JSMN_OBJECT;
-    }
-  } else {
-    if (parser->toksuper != JSMN_NEG) {
-      type = tokens[parser->toksuper].type;
-    }
+  if (jsmn_fill_token(parser, tokens, token, type, parser->pos, end + 1) != JSMN_SUCCESS) {
+    return JSMN_ERROR_LENGTH;
   }
-
+  parser->pos = end;
+#if defined(JSMN_PARENT_LINKS)
+  JSMN_TOK_PARENT(tokens, token) = parser->toksuper;
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+  jsmn_next_sibling(parser, tokens);
+#endif
+
+  if (parser->toksuper != JSMN_NEG) {
+    JSMN_TOK_SIZE(tokens, parser->toksuper)++;
+
+    if (!(JSMN_TOK_TYPE(tokens, parser->toksuper) & JSMN_CONTAINER)) {
+#if defined(JSMN_PARENT_LINKS)
+      parser->toksuper = JSMN_TOK_PARENT(tokens, parser->toksuper);
+#else
+      jsmnint_t i;
+      for (i = parser->toksuper; i != JSMN_NEG; i--) {
+        if (JSMN_TOK_TYPE(tokens, i) & JSMN_CONTAINER &&
+            JSMN_TOK_END(tokens, i) == JSMN_NEG) {
+          parser->toksuper = i;
+          break;
+        }
+      }
+# if defined(JSMN_PERMISSIVE_RULESET)
+      if (i == JSMN_NEG) {
+        parser->toksuper = i;
+      }
+# endif
+#endif
+    }
+  }
+
+  return JSMN_SUCCESS;
+}
+#endif
+
+#if defined(JSMN_PROJECTION)
+/* Nonzero while values are checked against the parser's paths */
+#define JSMN_PROJECTING(parser) \
+  ((parser)->paths != NULL && (parser)->depth < (parser)->keep_depth)
+
+/**
+ * Finds component n of a JSON Pointer, NULL if the pointer is shorter.
+ */
+static
+const char *jsmn_path_component(const char *path, const jsmnint_t n, size_t *len)
+{
+  jsmnint_t i;
+  for (i = 0; ; i++) {
+    if (*path != '/') {
+      return NULL;
+    }
+    path++;
+    *len = 0;
+    while (path[*len] != '\0' && path[*len] != '/') {
+      (*len)++;
+    }
+    if (i == n) {
+      return path;
+    }
+    path += *len;
+  }
+}
+
+/**
+ * Number of components of a JSON Pointer.
+ */
+static
+size_t jsmn_path_length(const char *path)
+{
+  size_t n = 0;
+  for (; *path != '\0'; path++) {
+    if (*path == '/') {
+      n++;
+    }
+  }
+  return n;
+}
+
+/**
+ * Compares a JSON Pointer component with the key whose text starts at pos.
+ */
+static
+jsmnbool jsmn_path_key(const char *comp, const size_t comp_len,
+                       const char *js, const size_t len, jsmnpos_t pos)
+{
+  size_t i;
+  for (i = 0; i < comp_len; i++, pos++) {
+    char c = comp[i];
+    /* ~0 is '~' and ~1 is '/' */
+    if (c == '~' && i + 1 < comp_len) {
+      c = (comp[++i] == '1' ? '/' : '~');
+    }
+    if (pos >= len || js[pos] != c) {
+      return JSMN_FALSE;
+    }
+  }
+  return (pos < len && js[pos] == '"');
+}
+
+/**
+ * Compares a JSON Pointer component with an ARRAY index.
+ */
+static
+jsmnbool jsmn_path_index(const char *comp, const size_t comp_len,
+                         const jsmnint_t index)
+{
+  jsmnint_t value = 0, digit;
+  size_t i;
+
+  /* No leading zeros */
+  if (comp_len == 0 || (comp_len > 1 && comp[0] == '0')) {
+    return JSMN_FALSE;
+  }
+  for (i = 0; i < comp_len; i++) {
+    if (comp[i] < '0' || comp[i] > '9' || value > index / 10) {
+      return JSMN_FALSE;
+    }
+    value *= 10;
+    digit = comp[i] - '0';
+    if (digit > index - value) {
+      return JSMN_FALSE;
+    }
+    value += digit;
+  }
+  return (value == index);
+}
+
+/**
+ * Paths going through the key or ARRAY element starting at parser->pos.
+ */
+static
+unsigned long jsmn_project_member(const jsmn_parser *parser,
+                                  const char *js, const size_t len)
+{
+  const jsmnint_t depth = parser->depth - 1;
+  unsigned long mask = 0, bit;
+  const char *comp;
+  size_t comp_len;
+  jsmnint_t i;
+
+  for (i = 0; i < parser->num_paths; i++) {
+    bit = 1UL << i;
+    if (!(parser->match[depth] & bit)) {
+      continue;
+    }
+    comp = jsmn_path_component(parser->paths[i], depth, &comp_len);
+    if (comp == NULL) {
+      continue;
+    }
+    if (parser->expected & JSMN_KEY) {
+      if (jsmn_path_key(comp, comp_len, js, len, parser->pos + 1)) {
+        mask |= bit;
+      }
+    } else if (jsmn_path_index(comp, comp_len, parser->index[depth])) {
+      mask |= bit;
+    }
+  }
+  return mask;
+}
+
+/**
+ * Paths going through the value starting at parser->pos, 0 if it is skipped.
+ */
+static
+unsigned long jsmn_project_value(const jsmn_parser *parser,
+                                 const char *js, const size_t len)
+{
+  /* The root value is kept, it is the ancestor of every path */
+  if (parser->depth == 0) {
+    return (parser->num_paths == JSMN_PROJECT_PATHS ? ~0UL :
+            (1UL << parser->num_paths) - 1);
+  }
+  /* The key already decided for an object member */
+  if (parser->expected & JSMN_INSD_OBJ) {
+    return parser->member;
+  }
+  return jsmn_project_member(parser, js, len);
+}
+
+/**
+ * Sets up the container just opened with the paths going through it.
+ */
+static
+void jsmn_project_open(jsmn_parser *parser, const unsigned long mask)
+{
+  const jsmnint_t depth = parser->depth - 1;
+  jsmnint_t i;
+
+  /* A path ending here keeps everything inside */
+  for (i = 0; i < parser->num_paths; i++) {
+    if (mask & (1UL << i) && jsmn_path_length(parser->paths[i]) == depth) {
+      parser->keep_depth = parser->depth;
+      return;
+    }
+  }
+  parser->match[depth] = mask;
+  parser->index[depth] = 0;
+}
+
+/**
+ * Skips an OBJECT or ARRAY that is on none of the paths.
+ */
+static
+jsmnint_t jsmn_project_skip(jsmn_parser *parser, const char *js,
+                            const size_t len)
+{
+  /* If an OBJECT or ARRAY wasn't expected */
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_CONTAINER)) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  jsmnpos_t end = parser->pos;
+  jsmnint_t r = jsmn_skip_container(js, len, &end);
+  if (r != JSMN_SUCCESS) {
+    return r;
+  }
+  parser->pos = end;
+  parser->expected = JSMN_AFTR_CLOSE;
+
+  return JSMN_SUCCESS;
+}
+#endif
+
+static
+jsmnint_t jsmn_parse_container_close(jsmn_parser *parser, const char c,
+                                     jsmntokens_t *tokens)
+{
+  /* If an OBJECT or ARRAY CLOSE wasn't expected */
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_CLOSE)) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  if (tokens == NULL) {
+    if (parser->toksuper < (sizeof(jsmnint_t) * CHAR_BIT)) {
+      jsmntype_t type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
+      if ((((parser->toknext & (1 << parser->toksuper)) == 1) && !(type & JSMN_OBJECT)) ||
+          (((parser->toknext & (1 << parser->toksuper)) == 0) && !(type & JSMN_ARRAY))) {
+        return JSMN_ERROR_BRACKETS;
+      }
+      parser->toknext &= ~(1 << parser->toksuper);
+    }
+    parser->toksuper--;
+  } else {
+#if defined(JSMN_PERMISSIVE_RULESET) || defined(JSMN_TRUSTED)
+    if (parser->toksuper == JSMN_NEG) {
+      return JSMN_ERROR_BRACKETS;
+    }
+#endif
+    jsmntype_t type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
+    jsmnint_t token = parser->toksuper;
+
+    if ((JSMN_CHECKING(parser) && !(JSMN_TOK_TYPE(tokens, token) & type)) ||
+        JSMN_TOK_END(tokens, token) != JSMN_NEG) {
+      return JSMN_ERROR_BRACKETS;
+    }
+    if (jsmn_token_end(parser, tokens, token, parser->pos + 1) != JSMN_SUCCESS) {
+      return JSMN_ERROR_LENGTH;
+    }
+#if defined(JSMN_COMPACT_ARRAYS)
+    if (token == parser->compact) {
+      if (parser->offsets[JSMN_TOK_ELEMENTS(tokens, token)] != 0) {
+        JSMN_TOK_TYPE(tokens, token) |= JSMN_COMPACT;
+      } else {
+        /* An empty ARRAY is the same either way, give its entry back */
+        parser->offnext = JSMN_TOK_ELEMENTS(tokens, token);
+        JSMN_TOK_ELEMENTS(tokens, token) = JSMN_NEG;
+      }
+      parser->compact = JSMN_NEG;
+    }
+#endif
+#if defined(JSMN_PARENT_LINKS)
+    jsmnint_t parent = JSMN_TOK_PARENT(tokens, token);
+    if (JSMN_TOK_TYPE(tokens, token) & JSMN_INSD_OBJ &&
+        !(JSMN_TOK_TYPE(tokens, parent) & JSMN_CONTAINER)) {
+      parser->toksuper = JSMN_TOK_PARENT(tokens, parent);
+    } else {
+      parser->toksuper = parent;
+    }
+#else
+    jsmnint_t i;
+    for (i = parser->toksuper - 1; i != JSMN_NEG; i--) {
+      if (JSMN_TOK_TYPE(tokens, i) & JSMN_CONTAINER &&
+          JSMN_TOK_END(tokens, i) == JSMN_NEG) {
+        parser->toksuper = i;
+        break;
+      }
+    }
+    if (i == JSMN_NEG) {
+      parser->toksuper = i;
+    }
+#endif
+  }
+
+  if (parser->toksuper != JSMN_NEG) {
+    parser->expected = JSMN_AFTR_CLOSE;
+  } else {
+    /* A closed OBJECT or ARRAY can't be a key */
+    parser->expected = JSMN_ROOT_AFTR_O;
+  }
+
+  return JSMN_SUCCESS;
+}
+
+static
+jsmnint_t jsmn_parse_colon(jsmn_parser *parser, jsmntokens_t *tokens)
+{
+  /* If a COLON wasn't expected */
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_COLON)) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  if (parser->toksuper != JSMN_NEG) {
+    parser->expected = JSMN_AFTR_COLON;
+#if defined(JSMN_PERMISSIVE_RULESET)
+  } else {
+    parser->expected = JSMN_AFTR_COLON_R;
+#endif
+  }
+
+  if (tokens == NULL) {
+    return JSMN_SUCCESS;
+  }
+
+#if defined(JSMN_PERMISSIVE_RULESET)
+  JSMN_TOK_TYPE(tokens, parser->toknext - 1) &= ~JSMN_VALUE;
+  JSMN_TOK_TYPE(tokens, parser->toknext - 1) |= JSMN_KEY;
+#endif
+
+#if !defined(JSMN_PAIR_TOKENS)
+# if defined(JSMN_PROJECTION)
+  /* A skipped key has no token to hold its value */
+  if (JSMN_PROJECTING(parser) && parser->member == 0) {
+    return JSMN_SUCCESS;
+  }
+# endif
+  parser->toksuper = parser->toknext - 1;
+#endif
+
+  return JSMN_SUCCESS;
+}
+
+static
+jsmnint_t jsmn_parse_comma(jsmn_parser *parser, jsmntokens_t *tokens)
+{
+  /* If a COMMA wasn't expected */
+  if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_COMMA)) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  jsmntype_t type = JSMN_UNDEFINED; /*!< parent's type */
+  if (tokens == NULL) {
+    if (parser->toksuper < (sizeof(jsmnint_t) * CHAR_BIT) &&
+        parser->toknext & (1 << parser->toksuper)) {
+      type = JSMN_OBJECT;
+    }
+  } else {
+    if (parser->toksuper != JSMN_NEG) {
+      type = JSMN_TOK_TYPE(tokens, parser->toksuper);
+    }
+  }
+
   if (parser->toksuper != JSMN_NEG) {
     if (type & JSMN_OBJECT) {
       parser->expected = JSMN_AFTR_COMMA_O;
@@ -710,67 +1432,1030 @@ jsmnint_t jsmn_parse_comma(jsmn_parser *parser, jsmntok_t *tokens)
   } else {
     parser->expected = JSMN_AFTR_COMMA_R;
 #endif
-  }
+  }
+
+  if (tokens == NULL) {
+    return JSMN_SUCCESS;
+  }
+
+#if defined(JSMN_PERMISSIVE_RULESET)
+  JSMN_TOK_TYPE(tokens, parser->toknext - 1) |= JSMN_VALUE;
+#endif
+
+  return JSMN_SUCCESS;
+}
+
+#if defined(JSMN_STREAM_ELEMENTS)
+/**
+ * Hands the element of the root ARRAY that was just completed to the parser's
+ * callback and gives its tokens back.
+ */
+static
+jsmnint_t jsmn_stream_element(jsmn_parser *parser, const char *js,
+                              jsmntokens_t *tokens)
+{
+  if (parser->element == NULL || parser->toksuper != 0 || parser->toknext < 2 ||
+      !(JSMN_TOK_TYPE(tokens, 0) & JSMN_ARRAY)) {
+    return JSMN_SUCCESS;
+  }
+
+  if (parser->element(parser->data, js, tokens, parser->toknext) != 0) {
+    return JSMN_ERROR_INVAL;
+  }
+  /* The next element is the root's first child again, there is nothing to link */
+  parser->toknext = 1;
+#if defined(JSMN_COMPACT_ARRAYS)
+  parser->offnext = 0;
+#endif
+  return JSMN_SUCCESS;
+}
+#endif
+
+/**
+ * Parse JSON string and fill tokens.
+ */
+JSMN_API
+jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js,
+                     const size_t len, jsmntokens_t *tokens,
+                     const size_t num_tokens)
+{
+  if (((jsmnpos_t)-1 > 0 && len >= (jsmnpos_t)JSMN_ERROR_MAX) ||
+      len > JSMNPOS_MAX) {
+    return JSMN_ERROR_LENGTH;
+  }
+
+  jsmnint_t r;
+
+  for (; parser->pos < len; parser->pos++) {
+#if !defined(JSMN_MULTIPLE_JSON_FAIL)
+    if (parser->expected == JSMN_UNDEFINED) {
+      break;
+    }
+#endif
+#if defined(JSMN_SEGMENTED_TOKENS)
+    /* The input may hold more tokens than jsmnint_t can count */
+    if (parser->count >= (jsmnint_t)JSMN_ERROR_MAX - 1) {
+      return JSMN_ERROR_NOMEM;
+    }
+#endif
+    char c = js[parser->pos];
+#if defined(JSMN_PROJECTION)
+    const jsmnbool projecting = JSMN_PROJECTING(parser);
+    unsigned long paths = 0;
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+    /* Anything but a number ends a compact ARRAY */
+    if (parser->compact != JSMN_NEG &&
+        c != '-' && !(c >= '0' && c <= '9') &&
+        c != ',' && c != ']' && !isWhitespace(c)) {
+      r = jsmn_compact_expand(parser, js, tokens, num_tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+    }
+#endif
+    if (c == '{' || c == '[') {
+#if defined(JSMN_PROJECTION)
+      if (projecting) {
+        paths = jsmn_project_value(parser, js, len);
+        if (paths == 0 && parser->depth != 0) {
+          r = jsmn_project_skip(parser, js, len);
+          if (r != JSMN_SUCCESS) {
+            return r;
+          }
+          continue;
+        }
+      }
+#endif
+#if defined(JSMN_LAZY_TOKENS)
+      if (parser->depth >= parser->max_depth) {
+        r = jsmn_parse_unexpanded(parser, js, len, tokens, num_tokens);
+        if (r != JSMN_SUCCESS) {
+          return r;
+        }
+        continue;
+      }
+#endif
+      r = jsmn_parse_container_open(parser, c, tokens, num_tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+#if defined(JSMN_LAZY_TOKENS)
+      parser->depth++;
+#endif
+#if defined(JSMN_PROJECTION)
+      if (projecting) {
+        jsmn_project_open(parser, paths);
+      }
+#endif
+      continue;
+    }
+
+    if (c == '}' || c == ']') {
+#if defined(JSMN_STREAM_ELEMENTS)
+      if (tokens != NULL) {
+        r = jsmn_stream_element(parser, js, tokens);
+        if (r != JSMN_SUCCESS) {
+          return r;
+        }
+      }
+#endif
+#if defined(JSMN_COMMITTED)
+      const jsmnint_t closed = parser->toksuper;
+#endif
+      r = jsmn_parse_container_close(parser, c, tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+#if defined(JSMN_COMMITTED)
+      if (tokens != NULL && parser->close != NULL &&
+          parser->close(parser->close_data, js, tokens, closed) != 0) {
+        return JSMN_ERROR_INVAL;
+      }
+#endif
+#if defined(JSMN_LAZY_TOKENS)
+      parser->depth--;
+#endif
+#if defined(JSMN_PROJECTION)
+      if (parser->depth < parser->keep_depth) {
+        parser->keep_depth = JSMN_NEG;
+      }
+#endif
+      continue;
+    }
+
+    if (c == '"') {
+#if defined(JSMN_PROJECTION)
+      if (projecting && parser->depth != 0) {
+        if (parser->expected & JSMN_KEY) {
+          parser->member = paths = jsmn_project_member(parser, js, len);
+        } else {
+          paths = jsmn_project_value(parser, js, len);
+        }
+        if (paths == 0) {
+          jsmnint_t count = parser->count;
+          r = jsmn_parse_string(parser, js, len, NULL, 0);
+          parser->count = count;
+          if (r != JSMN_SUCCESS) {
+            return r;
+          }
+          continue;
+        }
+      }
+#endif
+      r = jsmn_parse_string(parser, js, len, tokens, num_tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+      continue;
+    }
+
+    if (c == ':') {
+      r = jsmn_parse_colon(parser, tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+      continue;
+    }
+
+    if (c == ',') {
+      r = jsmn_parse_comma(parser, tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+#if defined(JSMN_STREAM_ELEMENTS)
+      if (tokens != NULL) {
+        r = jsmn_stream_element(parser, js, tokens);
+        if (r != JSMN_SUCCESS) {
+          return r;
+        }
+      }
+#endif
+#if defined(JSMN_PROJECTION)
+      if (projecting && parser->depth != 0) {
+        parser->index[parser->depth - 1]++;
+      }
+#endif
+      continue;
+    }
+
+    /* Valid whitespace, it also ends a PRIMITIVE cut short by the last chunk */
+    if (isWhitespace(c)) {
+      parser->expected &= ~JSMN_PRI_CONTINUE;
+      continue;
+    }
+
+#if !defined(JSMN_PERMISSIVE_PRIMITIVE)
+    /* rfc8259: PRIMITIVEs are numbers and booleans */
+    if (c == '-' || (c >= '0' && c <= '9') ||
+        c == 'n' ||  c == 't' || c == 'f' ||
+        /* A number cut short at the end of the last chunk */
+        ((parser->expected & JSMN_PRI_CONTINUE) &&
+         (c == '.' || c == 'e' || c == 'E'))) {
+#else
+    /* In permissive mode every unquoted value is a PRIMITIVE */
+    if (isCharacter(c) || c == '\\') {
+#endif
+#if defined(JSMN_PROJECTION)
+      if (projecting && parser->depth != 0 &&
+          jsmn_project_value(parser, js, len) == 0) {
+        jsmnint_t count = parser->count;
+        r = jsmn_parse_primitive(parser, js, len, NULL, 0);
+        parser->count = count;
+        if (r != JSMN_SUCCESS) {
+          return r;
+        }
+        continue;
+      }
+#endif
+      r = jsmn_parse_primitive(parser, js, len, tokens, num_tokens);
+      if (r != JSMN_SUCCESS) {
+        return r;
+      }
+      continue;
+    }
+
+    /* Unexpected char */
+    return JSMN_ERROR_INVAL;
+  }
+
+  if (parser->toksuper != JSMN_NEG) {
+    return JSMN_ERROR_PART;
+  }
+
+  if (parser->count == 0) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  while (parser->pos < len && isWhitespace(js[parser->pos])) {
+    parser->pos++;
+  }
+
+  return parser->count;
+}
+
+/**
+ * Tells if jsmn_parse only stopped because the input ran out.
+ */
+JSMN_API
+jsmnbool jsmn_parse_more(const jsmn_parser *parser, const jsmnint_t r,
+                         const size_t len)
+{
+  if (r == (jsmnint_t)JSMN_ERROR_PART) {
+    return JSMN_TRUE;
+  }
+
+  /* Only whitespace so far */
+  if (r == (jsmnint_t)JSMN_ERROR_INVAL) {
+    return (parser->count == 0 && parser->toksuper == JSMN_NEG &&
+            parser->pos == len);
+  }
+
+  if (r >= (jsmnint_t)JSMN_ERROR_MAX) {
+    return JSMN_FALSE;
+  }
+
+#if !defined(JSMN_MULTIPLE_JSON_FAIL)
+  /* A root PRIMITIVE may go on, or another document may follow */
+  return (parser->expected != JSMN_UNDEFINED);
+#else
+  /* Anything but whitespace after the root is an error */
+  return JSMN_TRUE;
+#endif
+}
+
+#if defined(JSMN_CHECKPOINTS)
+/**
+ * Appends a token as it is now to the undo log.
+ */
+static
+jsmnint_t jsmn_undo_push(const jsmntokens_t *tokens, const jsmnint_t token,
+                         jsmn_state *state, const size_t num_log)
+{
+  if (state->num_log >= num_log) {
+    return JSMN_ERROR_NOMEM;
+  }
+
+  jsmn_undo *undo = &state->log[state->num_log++];
+  undo->token = token;
+  undo->type = JSMN_TOK_TYPE(tokens, token);
+  undo->end = JSMN_TOK_END(tokens, token);
+  undo->size = JSMN_TOK_SIZE(tokens, token);
+#if defined(JSMN_NEXT_SIBLING)
+  undo->next_sibling = JSMN_TOK_NEXT_SIBLING(tokens, token);
+#endif
+
+  return JSMN_SUCCESS;
+}
+
+#if defined(JSMN_NEXT_SIBLING)
+/**
+ * Appends the last child of a token (of the root for JSMN_NEG), it gets
+ * linked to the next one.
+ */
+static
+jsmnint_t jsmn_undo_last_child(const jsmn_parser *parser,
+                               const jsmntokens_t *tokens,
+                               const jsmnint_t container,
+                               jsmn_state *state, const size_t num_log)
+{
+  jsmnint_t child = (container != JSMN_NEG ? container + 1 : 0);
+  if (child >= parser->toknext) {
+    return JSMN_SUCCESS;
+  }
+
+  while (JSMN_TOK_NEXT_SIBLING(tokens, child) != JSMN_NEG) {
+    child = JSMN_TOK_NEXT_SIBLING(tokens, child);
+  }
+  return jsmn_undo_push(tokens, child, state, num_log);
+}
+#endif
+
+/**
+ * Remembers the parser and the tokens that may still change.
+ */
+JSMN_API
+jsmnint_t jsmn_checkpoint(const jsmn_parser *parser, const jsmntokens_t *tokens,
+                          jsmn_state *state, jsmn_undo *log, const size_t num_log)
+{
+  state->parser = *parser;
+  state->log = log;
+  state->num_log = 0;
+
+  if (tokens == NULL || parser->toknext == 0) {
+    return JSMN_SUCCESS;
+  }
+
+  /* A PRIMITIVE cut short, or a key waiting for its value */
+  if (jsmn_undo_push(tokens, parser->toknext - 1, state, num_log) != JSMN_SUCCESS) {
+    return JSMN_ERROR_NOMEM;
+  }
+#if defined(JSMN_NEXT_SIBLING)
+  if (jsmn_undo_last_child(parser, tokens, JSMN_NEG, state, num_log) != JSMN_SUCCESS) {
+    return JSMN_ERROR_NOMEM;
+  }
+#endif
+
+  /* Open containers, and keys, get children and are closed */
+  jsmnint_t i;
+#if defined(JSMN_PARENT_LINKS)
+  for (i = parser->toksuper; i != JSMN_NEG; i = JSMN_TOK_PARENT(tokens, i)) {
+#else
+  for (i = parser->toksuper; i != JSMN_NEG; i--) {
+    if (i != parser->toksuper &&
+        (!(JSMN_TOK_TYPE(tokens, i) & JSMN_CONTAINER) ||
+         JSMN_TOK_END(tokens, i) != JSMN_NEG)) {
+      continue;
+    }
+#endif
+    if (jsmn_undo_push(tokens, i, state, num_log) != JSMN_SUCCESS) {
+      return JSMN_ERROR_NOMEM;
+    }
+#if defined(JSMN_NEXT_SIBLING)
+    if (jsmn_undo_last_child(parser, tokens, i, state, num_log) != JSMN_SUCCESS) {
+      return JSMN_ERROR_NOMEM;
+    }
+#endif
+  }
+
+  return JSMN_SUCCESS;
+}
+
+/**
+ * Goes back to a checkpoint.
+ */
+JSMN_API
+void jsmn_rollback(jsmn_parser *parser, jsmntokens_t *tokens,
+                   const jsmn_state *state)
+{
+  *parser = state->parser;
+
+  if (tokens == NULL) {
+    return;
+  }
+
+  jsmnint_t i;
+  for (i = state->num_log; i != 0; i--) {
+    const jsmn_undo *undo = &state->log[i - 1];
+    JSMN_TOK_TYPE(tokens, undo->token) = undo->type;
+    JSMN_TOK_END(tokens, undo->token) = undo->end;
+    JSMN_TOK_SIZE(tokens, undo->token) = undo->size;
+#if defined(JSMN_NEXT_SIBLING)
+    JSMN_TOK_NEXT_SIBLING(tokens, undo->token) = undo->next_sibling;
+#endif
+  }
+}
+#endif
+
+#if defined(JSMN_RECOVERY)
+/**
+ * Takes the parser back to the start of a line and drops its tokens.
+ */
+static
+void jsmn_drop_line(jsmn_parser *parser, jsmntokens_t *tokens,
+                    const jsmn_parser *line)
+{
+  *parser = *line;
+#if defined(JSMN_NEXT_SIBLING)
+  /* The last root kept may have been linked to a dropped one */
+  if (tokens != NULL && parser->toknext != 0) {
+    jsmnint_t sibling = 0;
+    while (JSMN_TOK_NEXT_SIBLING(tokens, sibling) != JSMN_NEG &&
+           JSMN_TOK_NEXT_SIBLING(tokens, sibling) < parser->toknext) {
+      sibling = JSMN_TOK_NEXT_SIBLING(tokens, sibling);
+    }
+    JSMN_TOK_NEXT_SIBLING(tokens, sibling) = JSMN_NEG;
+  }
+#else
+  (void)tokens;
+#endif
+}
+
+/**
+ * Parse a newline delimited JSON string, skipping the lines that fail.
+ */
+JSMN_API
+jsmnint_t jsmn_parse_records(jsmn_parser *parser, const char *js,
+                             const size_t len, jsmntokens_t *tokens,
+                             const size_t num_tokens)
+{
+  if (((jsmnpos_t)-1 > 0 && len >= (jsmnpos_t)JSMN_ERROR_MAX) ||
+      len > JSMNPOS_MAX) {
+    return JSMN_ERROR_LENGTH;
+  }
+
+  jsmn_parser line;
+  jsmnpos_t end;
+  jsmnint_t r;
+
+  while (parser->pos < len) {
+    /* Blank lines hold no record */
+    if (isWhitespace(js[parser->pos])) {
+      parser->pos++;
+      continue;
+    }
+
+    line = *parser;
+    end = parser->pos;
+    while (end < len && js[end] != '\n') {
+      end++;
+    }
+
+    r = jsmn_parse(parser, js, (end < len ? end + 1 : len), tokens, num_tokens);
+    if (r < (jsmnint_t)JSMN_ERROR_MAX) {
+      continue;
+    }
+
+    /* The caller has to give more data or tokens */
+    if ((r == (jsmnint_t)JSMN_ERROR_PART && end == len) ||
+        r == (jsmnint_t)JSMN_ERROR_NOMEM ||
+        parser->bad == NULL || line.badnext >= line.num_bad) {
+      jsmn_drop_line(parser, tokens, &line);
+      return r;
+    }
+
+    jsmn_drop_line(parser, tokens, &line);
+    parser->bad[parser->badnext].start = line.pos;
+    parser->bad[parser->badnext].end = end;
+    parser->bad[parser->badnext].error = r;
+    parser->badnext++;
+    parser->pos = (end < len ? end + 1 : end);
+  }
+
+  return parser->count;
+}
+#endif
+
+#if defined(JSMN_STEPS)
+/**
+ * Parse about max_bytes of a JSON string and fill tokens.
+ */
+JSMN_API
+jsmnint_t jsmn_parse_step(jsmn_parser *parser, const char *js,
+                          const size_t len, jsmntokens_t *tokens,
+                          const size_t num_tokens, const size_t max_bytes)
+{
+  const jsmnpos_t start = parser->pos;
+  size_t step = (max_bytes != 0 ? max_bytes : 1);
+  jsmnint_t r;
+
+  for (;;) {
+    if (start > len || step >= len - start) {
+      return jsmn_parse(parser, js, len, tokens, num_tokens);
+    }
+
+    r = jsmn_parse(parser, js, start + step, tokens, num_tokens);
+    if (jsmn_parse_more(parser, r, start + step)) {
+      /* A value longer than the step is parsed again from its start */
+      if (parser->pos != start) {
+        return JSMN_ERROR_YIELD;
+      }
+      step *= 2;
+      continue;
+    }
+    return r;
+  }
+}
+#endif
+
+#if defined(JSMN_IOVEC)
+/**
+ * Finds the buffer holding position pos and the position it starts at.
+ */
+static
+int jsmn_iov_find(const jsmn_iovec *iov, const int iovcnt,
+                  const jsmnpos_t pos, jsmnpos_t *base)
+{
+  jsmnpos_t start = 0;
+  int k;
+  for (k = 0; k < iovcnt; k++) {
+    if (pos - start < iov[k].iov_len) {
+      break;
+    }
+    start += (jsmnpos_t)iov[k].iov_len;
+  }
+  *base = start;
+  return k;
+}
+
+/**
+ * Copies up to n bytes from position pos on, returns how many there were.
+ */
+static
+size_t jsmn_iov_read(const jsmn_iovec *iov, const int iovcnt,
+                     const jsmnpos_t pos, char *buf, const size_t n)
+{
+  jsmnpos_t base;
+  int k = jsmn_iov_find(iov, iovcnt, pos, &base);
+  size_t skip = pos - base, done = 0;
+  for (; k < iovcnt && done < n; k++, skip = 0) {
+    size_t part = iov[k].iov_len - skip;
+    if (part > n - done) {
+      part = n - done;
+    }
+    const char *src = (const char *)iov[k].iov_base + skip;
+    for (; part != 0; part--) {
+      buf[done++] = *src++;
+    }
+  }
+  return done;
+}
+
+/**
+ * Finds where the value the parser is in the middle of starts.
+ */
+static
+jsmnpos_t jsmn_iov_keep(const jsmn_parser *parser, const jsmn_iovec *iov,
+                        const int iovcnt, const jsmntokens_t *tokens)
+{
+  jsmnpos_t keep = parser->pos;
+
+  /* A PRIMITIVE cut short is parsed again from its start */
+  if (parser->expected & JSMN_PRI_CONTINUE) {
+    if (tokens != NULL) {
+      return JSMN_TOK_START(tokens, parser->toknext - 1);
+    }
+    char c;
+    while (keep != 0 &&
+           jsmn_iov_read(iov, iovcnt, keep - 1, &c, 1) == 1 &&
+           !isWhitespace(c) && !isSpecialChar(c) && isCharacter(c)) {
+      keep--;
+    }
+  }
+  return keep;
+}
+
+/**
+ * Runs jsmn_parse over one buffer that starts at position base.
+ */
+static
+jsmnint_t jsmn_iov_parse(jsmn_parser *parser, const char *js,
+                         const size_t len, const jsmnpos_t base,
+                         jsmntokens_t *tokens, const size_t num_tokens)
+{
+  const jsmnint_t top = parser->toksuper;
+  const jsmnint_t first = parser->toknext;
+  jsmnint_t cont = JSMN_NEG, i;
+
+  /* The PRIMITIVE cut short is read again from this buffer */
+  if (tokens != NULL && (parser->expected & JSMN_PRI_CONTINUE)) {
+    cont = first - 1;
+    JSMN_TOK_START(tokens, cont) -= base;
+    JSMN_TOK_END(tokens, cont) -= base;
+  }
+
+  parser->pos -= base;
+  jsmnint_t r = jsmn_parse(parser, js, len, tokens, num_tokens);
+  parser->pos += base;
+
+  if (tokens == NULL) {
+    return r;
+  }
+
+  if (cont != JSMN_NEG) {
+    JSMN_TOK_START(tokens, cont) += base;
+    JSMN_TOK_END(tokens, cont) += base;
+  }
+  for (i = first; i < parser->toknext; i++) {
+    JSMN_TOK_START(tokens, i) += base;
+    if (JSMN_TOK_END(tokens, i) != JSMN_NEG) {
+      JSMN_TOK_END(tokens, i) += base;
+    }
+  }
+  /* Containers closed in this buffer were all open around the last token */
+  for (i = top; i != JSMN_NEG && i < first; i = JSMN_TOK_PARENT(tokens, i)) {
+    if ((JSMN_TOK_TYPE(tokens, i) & JSMN_CONTAINER) &&
+        JSMN_TOK_END(tokens, i) != JSMN_NEG) {
+      JSMN_TOK_END(tokens, i) += base;
+    }
+  }
+
+  return r;
+}
+
+/**
+ * Parse a JSON string held in several buffers and fill tokens.
+ */
+JSMN_API
+jsmnint_t jsmn_parsev(jsmn_parser *parser, const jsmn_iovec *iov, const int iovcnt,
+                      jsmntokens_t *tokens, const size_t num_tokens,
+                      char *carry, const size_t carry_len)
+{
+  size_t total = 0;
+  int k;
+  for (k = 0; k < iovcnt; k++) {
+    total += iov[k].iov_len;
+  }
+  if (((jsmnpos_t)-1 > 0 && total >= (jsmnpos_t)JSMN_ERROR_MAX) ||
+      total > JSMNPOS_MAX) {
+    return JSMN_ERROR_LENGTH;
+  }
+
+  jsmnbool in_place = JSMN_TRUE;
+  jsmnint_t r;
+  for (;;) {
+    const jsmnpos_t keep = jsmn_iov_keep(parser, iov, iovcnt, tokens);
+    jsmnpos_t base;
+    k = jsmn_iov_find(iov, iovcnt, keep, &base);
+
+    if (k == iovcnt) {
+      /* Everything is read, let jsmn_parse report how it ended */
+      return jsmn_iov_parse(parser, "", 0, (jsmnpos_t)total, tokens, num_tokens);
+    }
+
+    const jsmnpos_t end = base + (jsmnpos_t)iov[k].iov_len;
+    if (in_place && parser->pos < end) {
+      /* The value being parsed resumes in this buffer, parse it in place */
+      r = jsmn_iov_parse(parser, (const char *)iov[k].iov_base, iov[k].iov_len,
+                         base, tokens, num_tokens);
+      /* Cut short by the end of the buffer */
+      in_place = (r != (jsmnint_t)JSMN_ERROR_PART);
+      /* Only whitespace so far, the first token may be in the next buffer */
+      if (r == (jsmnint_t)JSMN_ERROR_INVAL && end < total &&
+          jsmn_parse_more(parser, r, end)) {
+        continue;
+      }
+    } else {
+      /* The value being parsed runs into the next buffer, copy it to carry */
+      size_t want = parser->pos - keep + 64, n;
+      if (carry_len <= parser->pos - keep) {
+        return JSMN_ERROR_NOMEM;
+      }
+      for (;;) {
+        n = jsmn_iov_read(iov, iovcnt, keep, carry,
+                          (want < carry_len ? want : carry_len));
+        r = jsmn_iov_parse(parser, carry, n, keep, tokens, num_tokens);
+        if (r == (jsmnint_t)JSMN_ERROR_PART &&
+            jsmn_iov_keep(parser, iov, iovcnt, tokens) < end &&
+            keep + n < total) {
+          if (n == carry_len) {
+            return JSMN_ERROR_NOMEM;
+          }
+          want *= 2;
+          continue;
+        }
+        break;
+      }
+      if (keep + n == total) {
+        return r;
+      }
+      in_place = JSMN_TRUE;
+    }
+
+    if (parser->pos >= total) {
+      return r;
+    }
+    if (r >= (jsmnint_t)JSMN_ERROR_MAX && r != (jsmnint_t)JSMN_ERROR_PART) {
+      return r;
+    }
+#if !defined(JSMN_MULTIPLE_JSON_FAIL)
+    if (parser->expected == JSMN_UNDEFINED) {
+      return r;
+    }
+#endif
+  }
+}
+
+/**
+ * Copies a token's text out of the buffers.
+ */
+JSMN_API
+jsmnint_t jsmn_iov_copy(const jsmn_iovec *iov, const int iovcnt,
+                        const jsmntokens_t *tokens, const jsmnint_t token,
+                        char *buf, const size_t size)
+{
+  const jsmnint_t len = JSMN_TOK_END(tokens, token) - JSMN_TOK_START(tokens, token);
+  if (len >= size) {
+    return JSMN_ERROR_NOMEM;
+  }
+  jsmn_iov_read(iov, iovcnt, JSMN_TOK_START(tokens, token), buf, len);
+  buf[len] = '\0';
+  return len;
+}
+
+/**
+ * Compares a token's text in the buffers to a string.
+ */
+JSMN_API
+jsmnbool jsmn_iov_equal(const jsmn_iovec *iov, const int iovcnt,
+                        const jsmntokens_t *tokens, const jsmnint_t token,
+                        const char *s, const size_t len)
+{
+  if (JSMN_TOK_END(tokens, token) - JSMN_TOK_START(tokens, token) != len) {
+    return JSMN_FALSE;
+  }
+
+  jsmnpos_t base;
+  int k = jsmn_iov_find(iov, iovcnt, JSMN_TOK_START(tokens, token), &base);
+  size_t skip = JSMN_TOK_START(tokens, token) - base, done = 0;
+  for (; k < iovcnt && done < len; k++, skip = 0) {
+    size_t part = iov[k].iov_len - skip;
+    if (part > len - done) {
+      part = len - done;
+    }
+    const char *src = (const char *)iov[k].iov_base + skip;
+    for (; part != 0; part--) {
+      if (*src++ != s[done++]) {
+        return JSMN_FALSE;
+      }
+    }
+  }
+  return JSMN_TRUE;
+}
+#endif
+
+/**
+ * Checks a JSON string with the rules jsmn_parse uses, without any tokens.
+ */
+JSMN_API
+jsmnint_t jsmn_validate(const char *js, const size_t len, jsmnpos_t *error)
+{
+  unsigned char objects[(JSMN_VALIDATE_DEPTH + CHAR_BIT - 1) / CHAR_BIT]; /*!< bit set for each open OBJECT */
+  size_t depth = 0;
+  jsmn_parser parser;
+  jsmnint_t r = JSMN_SUCCESS;
+
+  jsmn_init(&parser);
+#if defined(JSMN_TRUSTED)
+  parser.trusted = JSMN_FALSE;
+#endif
+  if (((jsmnpos_t)-1 > 0 && len >= (jsmnpos_t)JSMN_ERROR_MAX) ||
+      len > JSMNPOS_MAX) {
+    r = JSMN_ERROR_LENGTH;
+    goto done;
+  }
+
+  /* Unlike jsmn_parse, anything but whitespace after the root is an error */
+  for (; parser.pos < len; parser.pos++) {
+    char c = js[parser.pos];
+    if (c == '{' || c == '[') {
+      if (!(parser.expected & JSMN_CONTAINER)) {
+        r = JSMN_ERROR_INVAL;
+        goto done;
+      }
+      if (depth == JSMN_VALIDATE_DEPTH) {
+        r = JSMN_ERROR_NOMEM;
+        goto done;
+      }
+      if (c == '{') {
+        objects[depth / CHAR_BIT] |= (unsigned char)(1 << (depth % CHAR_BIT));
+        parser.expected = JSMN_OPEN_OBJECT;
+      } else {
+        objects[depth / CHAR_BIT] &= (unsigned char)~(1 << (depth % CHAR_BIT));
+        parser.expected = JSMN_OPEN_ARRAY;
+      }
+      depth++;
+      parser.toksuper = 0;
+      parser.count++;
+      continue;
+    }
+
+    if (c == '}' || c == ']') {
+      if (!(parser.expected & JSMN_CLOSE)) {
+        r = JSMN_ERROR_INVAL;
+        goto done;
+      }
+      if (depth == 0 ||
+          ((objects[(depth - 1) / CHAR_BIT] >> ((depth - 1) % CHAR_BIT)) & 1) != (c == '}')) {
+        r = JSMN_ERROR_BRACKETS;
+        goto done;
+      }
+      depth--;
+      if (depth != 0) {
+        parser.expected = JSMN_AFTR_CLOSE;
+      } else {
+        parser.toksuper = JSMN_NEG;
+#if !defined(JSMN_PERMISSIVE_RULESET)
+        /* Not even another root value with JSMN_MULTIPLE_JSON */
+        parser.expected = JSMN_UNDEFINED;
+#else
+        parser.expected = JSMN_ROOT_AFTR_O;
+#endif
+      }
+      continue;
+    }
+
+    if (c == '"') {
+      r = jsmn_parse_string(&parser, js, len, NULL, 0);
+      if (r != JSMN_SUCCESS) {
+        goto done;
+      }
+#if !defined(JSMN_PERMISSIVE_RULESET)
+      if (depth == 0) {
+        parser.expected = JSMN_UNDEFINED;
+      }
+#endif
+      continue;
+    }
+
+    if (c == ':') {
+      r = jsmn_parse_colon(&parser, NULL);
+      if (r != JSMN_SUCCESS) {
+        goto done;
+      }
+      continue;
+    }
+
+    if (c == ',') {
+      if (!(parser.expected & JSMN_COMMA)) {
+        r = JSMN_ERROR_INVAL;
+        goto done;
+      }
+      if (depth != 0) {
+        if ((objects[(depth - 1) / CHAR_BIT] >> ((depth - 1) % CHAR_BIT)) & 1) {
+          parser.expected = JSMN_AFTR_COMMA_O;
+        } else {
+          parser.expected = JSMN_AFTR_COMMA_A;
+        }
+#if defined(JSMN_PERMISSIVE_RULESET)
+      } else {
+        parser.expected = JSMN_AFTR_COMMA_R;
+#endif
+      }
+      continue;
+    }
+
+    /* Valid whitespace, indentation is skipped a word at a time */
+    if (isWhitespace(c)) {
+      while (len - parser.pos > sizeof(size_t) &&
+             jsmn_swar_load(js + parser.pos + 1) == JSMN_SWAR_ONES * ' ') {
+        parser.pos += sizeof(size_t);
+      }
+      continue;
+    }
+
+#if !defined(JSMN_PERMISSIVE_PRIMITIVE)
+    /* rfc8259: PRIMITIVEs are numbers and booleans */
+    if (c == '-' || (c >= '0' && c <= '9') ||
+        c == 'n' ||  c == 't' || c == 'f') {
+#else
+    /* In permissive mode every unquoted value is a PRIMITIVE */
+    if (isCharacter(c) || c == '\\') {
+#endif
+      r = jsmn_parse_primitive(&parser, js, len, NULL, 0);
+      if (r != JSMN_SUCCESS) {
+        goto done;
+      }
+#if !defined(JSMN_PERMISSIVE_RULESET)
+      if (depth == 0) {
+        parser.expected = JSMN_UNDEFINED;
+      }
+#endif
+      continue;
+    }
 
-  if (tokens == NULL) {
-    return JSMN_SUCCESS;
+    /* Unexpected char */
+    r = JSMN_ERROR_INVAL;
+    goto done;
   }
 
+  if (depth != 0) {
+    r = JSMN_ERROR_PART;
 #if defined(JSMN_PERMISSIVE_RULESET)
-  tokens[parser->toknext - 1].type |= JSMN_VALUE;
+  /* A root KEY still waiting for its VALUE */
+  } else if (parser.expected == JSMN_AFTR_COLON_R) {
+    r = JSMN_ERROR_PART;
 #endif
+  } else if (parser.count == 0) {
+    r = JSMN_ERROR_INVAL;
+  }
 
-  return JSMN_SUCCESS;
+done:
+  if (error != NULL) {
+    *error = (r == (jsmnint_t)JSMN_ERROR_PART ? (jsmnpos_t)len : parser.pos);
+  }
+  return r;
 }
 
+#if defined(JSMN_EVENTS)
 /**
- * Parse JSON string and fill tokens.
+ * Parses up to the next value, key, or end of a container and describes it in event.
  */
-JSMN_API
-jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js,
-                     const size_t len, jsmntok_t *tokens,
-                     const size_t num_tokens)
+static
+jsmnint_t jsmn_parse_event(jsmn_parser *parser, const char *js,
+                           const size_t len, jsmn_event *event)
 {
-  if (((jsmnint_t)-1 > 0 && len >= (jsmnint_t)JSMN_ERROR_MAX) ||
-      len > JSMNINT_MAX) {
+  if (((jsmnpos_t)-1 > 0 && len >= (jsmnpos_t)JSMN_ERROR_MAX) ||
+      len > JSMNPOS_MAX) {
     return JSMN_ERROR_LENGTH;
   }
 
   jsmnint_t r;
 
+  /* Without tokens toksuper is the depth of the innermost open container */
   for (; parser->pos < len; parser->pos++) {
 #if !defined(JSMN_MULTIPLE_JSON_FAIL)
     if (parser->expected == JSMN_UNDEFINED) {
       break;
     }
 #endif
+    const jsmnint_t depth = parser->toksuper + 1;
     char c = js[parser->pos];
     if (c == '{' || c == '[') {
-      r = jsmn_parse_container_open(parser, c, tokens, num_tokens);
-      if (r != JSMN_SUCCESS) {
-        return r;
+      if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_CONTAINER)) {
+        return JSMN_ERROR_INVAL;
       }
-      continue;
+      if (depth == JSMN_EVENT_DEPTH) {
+        return JSMN_ERROR_NOMEM;
+      }
+      event->type = JSMN_VALUE | (parser->expected & JSMN_INSD_OBJ);
+      if (c == '{') {
+        parser->objects[depth / CHAR_BIT] |= (unsigned char)(1 << (depth % CHAR_BIT));
+        parser->expected = JSMN_OPEN_OBJECT;
+        event->type |= JSMN_OBJECT;
+      } else {
+        parser->objects[depth / CHAR_BIT] &= (unsigned char)~(1 << (depth % CHAR_BIT));
+        parser->expected = JSMN_OPEN_ARRAY;
+        event->type |= JSMN_ARRAY;
+      }
+      parser->toksuper = depth;
+      parser->count++;
+      event->start = parser->pos;
+      event->end = JSMN_POS_NEG;
+      parser->pos++;
+      return JSMN_SUCCESS;
     }
 
     if (c == '}' || c == ']') {
-      r = jsmn_parse_container_close(parser, c, tokens);
-      if (r != JSMN_SUCCESS) {
-        return r;
+      if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_CLOSE)) {
+        return JSMN_ERROR_INVAL;
       }
-      continue;
+      if (depth == 0) {
+        return JSMN_ERROR_BRACKETS;
+      }
+      if ((parser->objects[(depth - 1) / CHAR_BIT] >> ((depth - 1) % CHAR_BIT)) & 1) {
+        event->type = JSMN_OBJECT | JSMN_CLOSE;
+      } else {
+        event->type = JSMN_ARRAY  | JSMN_CLOSE;
+      }
+      if (JSMN_CHECKING(parser) && ((event->type & JSMN_OBJECT) != 0) != (c == '}')) {
+        return JSMN_ERROR_BRACKETS;
+      }
+      parser->toksuper--;
+      if (parser->toksuper != JSMN_NEG) {
+        parser->expected = JSMN_AFTR_CLOSE;
+      } else {
+        parser->expected = JSMN_ROOT_AFTR_O;
+      }
+      event->start = JSMN_POS_NEG;
+      event->end = ++parser->pos;
+      return JSMN_SUCCESS;
     }
 
     if (c == '"') {
-      r = jsmn_parse_string(parser, js, len, tokens, num_tokens);
+      const jsmnpos_t start = parser->pos + 1;
+      r = jsmn_parse_string(parser, js, len, NULL, 0);
       if (r != JSMN_SUCCESS) {
         return r;
       }
-      continue;
+      event->type = parser->type;
+      event->start = start;
+      event->end = parser->pos++;
+      return JSMN_SUCCESS;
     }
 
     if (c == ':') {
-      r = jsmn_parse_colon(parser, tokens);
+      r = jsmn_parse_colon(parser, NULL);
       if (r != JSMN_SUCCESS) {
         return r;
       }
@@ -778,9 +2463,14 @@ jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js,
     }
 
     if (c == ',') {
-      r = jsmn_parse_comma(parser, tokens);
-      if (r != JSMN_SUCCESS) {
-        return r;
+      if (JSMN_CHECKING(parser) && !(parser->expected & JSMN_COMMA)) {
+        return JSMN_ERROR_INVAL;
+      }
+      if (depth != 0 &&
+          ((parser->objects[(depth - 1) / CHAR_BIT] >> ((depth - 1) % CHAR_BIT)) & 1)) {
+        parser->expected = JSMN_AFTR_COMMA_O;
+      } else {
+        parser->expected = JSMN_AFTR_COMMA_A;
       }
       continue;
     }
@@ -798,11 +2488,25 @@ jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js,
     /* In permissive mode every unquoted value is a PRIMITIVE */
     if (isCharacter(c) || c == '\\') {
 #endif
-      r = jsmn_parse_primitive(parser, js, len, tokens, num_tokens);
+      const jsmnpos_t start = parser->pos;
+      const jsmntype_t expected = parser->expected;
+      r = jsmn_parse_primitive(parser, js, len, NULL, 0);
       if (r != JSMN_SUCCESS) {
         return r;
       }
-      continue;
+      if (parser->pos + 1 == len &&
+          (parser->toksuper != JSMN_NEG || !parser->final)) {
+        /* It may go on in the next chunk, parse it again then */
+        parser->pos = start;
+        parser->expected = expected;
+        parser->count--;
+        return JSMN_ERROR_PART;
+      }
+      parser->expected &= ~JSMN_PRI_CONTINUE;
+      event->type = parser->type;
+      event->start = start;
+      event->end = ++parser->pos;
+      return JSMN_SUCCESS;
     }
 
     /* Unexpected char */
@@ -813,16 +2517,96 @@ jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js,
     return JSMN_ERROR_PART;
   }
 
+  /* Nothing but whitespace so far is the start of a stream, not an error */
   if (parser->count == 0) {
-    return JSMN_ERROR_INVAL;
+    return (parser->final ? JSMN_ERROR_INVAL : JSMN_ERROR_PART);
   }
 
-  while (parser->pos < len && isWhitespace(js[parser->pos])) {
-    parser->pos++;
+  event->type = JSMN_UNDEFINED;
+  event->start = event->end = parser->pos;
+  return JSMN_SUCCESS;
+}
+
+/**
+ * Parses a JSON string and calls handler for each value instead of filling tokens.
+ */
+JSMN_API
+jsmnint_t jsmn_parse_events(jsmn_parser *parser, const char *js,
+                            const size_t len, const jsmn_handler *handler)
+{
+  jsmn_event event;
+  jsmnint_t r;
+  int stop;
+
+  for (;;) {
+    r = jsmn_parse_event(parser, js, len, &event);
+    if (r != JSMN_SUCCESS) {
+      return r;
+    }
+
+    if (event.type & JSMN_CLOSE) {
+      stop = (handler->end != NULL &&
+              handler->end(handler->data, event.type & JSMN_CONTAINER, event.end));
+    } else if (event.type & JSMN_CONTAINER) {
+      stop = (handler->begin != NULL &&
+              handler->begin(handler->data, event.type, event.start));
+    } else if (event.type & JSMN_KEY) {
+      stop = (handler->key != NULL &&
+              handler->key(handler->data, js, event.start, event.end));
+    } else if (event.type & JSMN_STRING) {
+      stop = (handler->string != NULL &&
+              handler->string(handler->data, js, event.start, event.end));
+    } else if (event.type & JSMN_PRIMITIVE) {
+      stop = (handler->primitive != NULL &&
+              handler->primitive(handler->data, event.type, js, event.start, event.end));
+    } else {
+      return parser->count;
+    }
+    if (stop) {
+      return JSMN_ERROR_INVAL;
+    }
   }
+}
 
-  return parser->count;
+/**
+ * Starts an iterator with no input.
+ */
+JSMN_API
+void jsmn_iterator_init(jsmn_iterator *it)
+{
+  jsmn_init(&it->parser);
+  it->js = NULL;
+  it->len = 0;
+  it->offset = 0;
+}
+
+/**
+ * Gives the iterator its next chunk, starting with the bytes it has not read,
+ * or tells it that the input is over.
+ */
+JSMN_API
+void jsmn_feed(jsmn_iterator *it, const char *js, const size_t len)
+{
+  if (js == NULL) {
+    it->parser.final = JSMN_TRUE;
+    return;
+  }
+
+  it->offset += it->parser.pos;
+  it->parser.pos = 0;
+  it->js = js;
+  it->len = len;
+}
+
+/**
+ * Describes the next value, key, or end of a container in the input fed so far.
+ */
+JSMN_API
+jsmnint_t jsmn_next_event(jsmn_iterator *it, jsmn_event *event)
+{
+  return jsmn_parse_event(&it->parser, it->js, it->len, event);
 }
+#endif
 
 /**
  * Creates a new parser based over a given buffer with an array of tokens
@@ -836,4 +2620,339 @@ void jsmn_init(jsmn_parser *parser)
   parser->toksuper = JSMN_NEG;
   parser->count = 0;
   parser->expected = JSMN_ROOT_INIT;
+#if defined(JSMN_TRUSTED)
+  parser->trusted = JSMN_TRUE;
+#endif
+#if defined(JSMN_LAZY_TOKENS)
+  parser->depth = 0;
+  parser->max_depth = JSMN_NEG;
+#endif
+#if defined(JSMN_PAIR_TOKENS)
+  parser->key_start = parser->key_end = JSMN_NEG;
+#endif
+#if defined(JSMN_PROJECTION)
+  parser->paths = NULL;
+  parser->num_paths = 0;
+  parser->keep_depth = JSMN_NEG;
+  parser->member = 0;
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+  parser->offsets = NULL;
+  parser->num_offsets = 0;
+  parser->offnext = 0;
+  parser->compact = JSMN_NEG;
+#endif
+#if defined(JSMN_EVENTS)
+  parser->type = JSMN_UNDEFINED;
+  parser->final = JSMN_FALSE;
+#endif
+#if defined(JSMN_WINDOW)
+  parser->base = 0;
+#endif
+#if defined(JSMN_STREAM_ELEMENTS)
+  parser->element = NULL;
+  parser->data = NULL;
+#endif
+#if defined(JSMN_COMMITTED)
+  parser->close = NULL;
+  parser->close_data = NULL;
+#endif
+#if defined(JSMN_RECOVERY)
+  parser->bad = NULL;
+  parser->num_bad = 0;
+  parser->badnext = 0;
+#endif
+#if defined(JSMN_SEGMENTED_TOKENS)
+  parser->segment = 0;
+  parser->segments[0] = 0;
+#endif
+}
+
+#if defined(JSMN_LAZY_TOKENS)
+/**
+ * Tokenizes an unexpanded OBJECT or ARRAY into a separate token array.
+ */
+JSMN_API
+jsmnint_t jsmn_expand(jsmn_parser *parser, const char *js,
+                      const jsmntokens_t *tokens, const jsmnint_t token,
+                      jsmntokens_t *subtokens, const size_t num_subtokens)
+{
+  if (!(JSMN_TOK_TYPE(tokens, token) & JSMN_UNEXPANDED)) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  /* A fresh parser starts at the opening bracket, a resumed one continues */
+  if (parser->pos < JSMN_TOK_START(tokens, token)) {
+    parser->pos = JSMN_TOK_START(tokens, token);
+  }
+
+  return jsmn_parse(parser, js, JSMN_TOK_END(tokens, token), subtokens, num_subtokens);
+}
+#endif
+
+#if defined(JSMN_PROJECTION)
+/**
+ * Restricts the tokens of the following parse to a set of JSON Pointers.
+ */
+JSMN_API
+jsmnint_t jsmn_project(jsmn_parser *parser, const char *const *paths,
+                       const size_t num_paths)
+{
+  size_t i;
+
+  if (num_paths > JSMN_PROJECT_PATHS) {
+    return JSMN_ERROR_INVAL;
+  }
+  for (i = 0; i < num_paths; i++) {
+    if ((paths[i][0] != '\0' && paths[i][0] != '/') ||
+        jsmn_path_length(paths[i]) > JSMN_PROJECT_DEPTH) {
+      return JSMN_ERROR_INVAL;
+    }
+  }
+
+  parser->paths = paths;
+  parser->num_paths = (jsmnint_t)num_paths;
+  parser->keep_depth = JSMN_NEG;
+
+  return JSMN_SUCCESS;
+}
+#endif
+
+#if defined(JSMN_WINDOW)
+/**
+ * Moves a position down by n, positions before the window become 0.
+ */
+static
+jsmnint_t jsmn_slide_pos(const jsmnint_t pos, const jsmnpos_t n)
+{
+  if (pos == JSMN_NEG) {
+    return pos;
+  }
+  return (pos >= n ? pos - n : 0);
+}
+
+/**
+ * Drops up to drop bytes the parser is done with and rebases onto the rest.
+ */
+JSMN_API
+jsmnpos_t jsmn_slide(jsmn_parser *parser, const char *js,
+                     jsmntokens_t *tokens, const jsmnpos_t drop)
+{
+  jsmnpos_t keep = parser->pos;
+
+  /* A PRIMITIVE cut short is parsed again from its start */
+  if (parser->expected & JSMN_PRI_CONTINUE) {
+    if (tokens != NULL) {
+      keep = JSMN_TOK_START(tokens, parser->toknext - 1);
+    } else {
+      while (keep != 0 &&
+             !isWhitespace(js[keep - 1]) &&
+             !isSpecialChar(js[keep - 1]) &&
+             isCharacter(js[keep - 1])) {
+        keep--;
+      }
+    }
+  }
+#if defined(JSMN_COMPACT_ARRAYS)
+  /* Expanding an open compact ARRAY reads its elements again */
+  if (parser->compact != JSMN_NEG &&
+      JSMN_TOK_START(tokens, parser->compact) < keep) {
+    keep = JSMN_TOK_START(tokens, parser->compact);
+  }
+#endif
+
+  const jsmnpos_t n = (drop < keep ? drop : keep);
+  if (n == 0) {
+    return 0;
+  }
+  parser->pos -= n;
+  parser->base += n;
+#if defined(JSMN_PAIR_TOKENS)
+  parser->key_start = jsmn_slide_pos(parser->key_start, n);
+  parser->key_end = jsmn_slide_pos(parser->key_end, n);
+#endif
+
+  if (tokens == NULL) {
+    return n;
+  }
+
+  jsmnint_t i;
+  for (i = 0; i < parser->toknext; i++) {
+    JSMN_TOK_START(tokens, i) = jsmn_slide_pos(JSMN_TOK_START(tokens, i), n);
+    JSMN_TOK_END(tokens, i) = jsmn_slide_pos(JSMN_TOK_END(tokens, i), n);
+#if defined(JSMN_PAIR_TOKENS)
+    JSMN_TOK_KEY_START(tokens, i) = jsmn_slide_pos(JSMN_TOK_KEY_START(tokens, i), n);
+    JSMN_TOK_KEY_END(tokens, i) = jsmn_slide_pos(JSMN_TOK_KEY_END(tokens, i), n);
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+    if (JSMN_TOK_ELEMENTS(tokens, i) != JSMN_NEG) {
+      jsmnint_t *offset = parser->offsets + JSMN_TOK_ELEMENTS(tokens, i);
+      jsmnint_t j;
+      for (j = offset[0]; j != 0; j--) {
+        offset[j] = jsmn_slide_pos(offset[j], n);
+      }
+    }
+#endif
+  }
+
+  return n;
+}
+#endif
+
+#if defined(JSMN_COMMITTED)
+/**
+ * Counts the leading tokens that will not change any more.
+ */
+JSMN_API
+jsmnint_t jsmn_committed(const jsmn_parser *parser, const jsmntokens_t *tokens)
+{
+  jsmnint_t committed = parser->toknext;
+  if (committed == 0) {
+    return committed;
+  }
+
+  /* A PRIMITIVE at the end of the input may go on in the next chunk */
+  if (parser->expected & JSMN_PRI_CONTINUE) {
+    committed--;
+#if !defined(JSMN_PAIR_TOKENS)
+  /* A key is sized once its value is found */
+  } else if ((JSMN_TOK_TYPE(tokens, committed - 1) & JSMN_KEY) &&
+             JSMN_TOK_SIZE(tokens, committed - 1) == 0) {
+    committed--;
+#endif
+  }
+
+  return committed;
+}
+
+/**
+ * Sets the callback for each container closed.
+ */
+JSMN_API
+void jsmn_on_close(jsmn_parser *parser, jsmn_close_cb close, void *data)
+{
+  parser->close = close;
+  parser->close_data = data;
+}
+#endif
+
+#if defined(JSMN_RECOVERY)
+/**
+ * Gives the parser a table for the lines jsmn_parse_records skips.
+ */
+JSMN_API
+void jsmn_recover(jsmn_parser *parser, jsmn_bad_record *bad,
+                  const size_t num_bad)
+{
+  parser->bad = bad;
+  parser->num_bad = (jsmnint_t)num_bad;
+  parser->badnext = 0;
+}
+#endif
+
+#if defined(JSMN_STREAM_ELEMENTS)
+/**
+ * Sets the callback for the elements of the root ARRAY.
+ */
+JSMN_API
+void jsmn_stream(jsmn_parser *parser, jsmn_element_cb element, void *data)
+{
+  parser->element = element;
+  parser->data = data;
+}
+#endif
+
+#if defined(JSMN_COMPACT_ARRAYS)
+/**
+ * Gives the parser a table for the elements of arrays of numbers.
+ */
+JSMN_API
+void jsmn_compact(jsmn_parser *parser, jsmnint_t *offsets,
+                  const size_t num_offsets)
+{
+  parser->offsets = offsets;
+  parser->num_offsets = (jsmnint_t)num_offsets;
+  parser->offnext = 0;
+  parser->compact = JSMN_NEG;
+}
+
+/**
+ * Counts the elements of an ARRAY whether they have tokens or not.
+ */
+JSMN_API
+jsmnint_t jsmn_array_size(const jsmn_parser *parser,
+                          const jsmntokens_t *tokens, const jsmnint_t array)
+{
+  if (JSMN_TOK_TYPE(tokens, array) & JSMN_COMPACT) {
+    return parser->offsets[JSMN_TOK_ELEMENTS(tokens, array)];
+  }
+  return JSMN_TOK_SIZE(tokens, array);
+}
+
+/**
+ * Describes an ARRAY element whether it has a token or not.
+ */
+JSMN_API
+jsmnint_t jsmn_array_element(const jsmn_parser *parser, const char *js,
+                             const jsmntokens_t *tokens, const jsmnint_t array,
+                             const jsmnint_t index, jsmntok_t *element)
+{
+  jsmnint_t child, i;
+
+  element->type = JSMN_UNDEFINED;
+  element->start = element->end = JSMN_NEG;
+  element->size = 0;
+#if defined(JSMN_PAIR_TOKENS)
+  element->key_start = element->key_end = JSMN_NEG;
+#endif
+#if defined(JSMN_PARENT_LINKS)
+  element->parent = JSMN_NEG;
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+  element->next_sibling = JSMN_NEG;
+#endif
+  element->elements = JSMN_NEG;
+
+  if (index >= jsmn_array_size(parser, tokens, array)) {
+    return JSMN_NEG;
+  }
+
+  if (JSMN_TOK_TYPE(tokens, array) & JSMN_COMPACT) {
+    jsmntype_t type;
+    element->start = parser->offsets[JSMN_TOK_ELEMENTS(tokens, array) + 1 + index];
+    element->end = jsmn_compact_number(js, element->start, &type);
+    element->type = type;
+    return JSMN_NEG;
+  }
+
+  /* Step over the elements before it, and everything beneath them */
+  child = array + 1;
+  for (i = 0; i < index; i++) {
+#if defined(JSMN_NEXT_SIBLING)
+    child = JSMN_TOK_NEXT_SIBLING(tokens, child);
+#else
+    jsmnint_t remaining = 1;
+    for (; remaining != 0; remaining--, child++) {
+      remaining += JSMN_TOK_SIZE(tokens, child);
+    }
+#endif
+  }
+
+  element->type = JSMN_TOK_TYPE(tokens, child);
+  element->start = JSMN_TOK_START(tokens, child);
+  element->end = JSMN_TOK_END(tokens, child);
+  element->size = JSMN_TOK_SIZE(tokens, child);
+#if defined(JSMN_PAIR_TOKENS)
+  element->key_start = JSMN_TOK_KEY_START(tokens, child);
+  element->key_end = JSMN_TOK_KEY_END(tokens, child);
+#endif
+#if defined(JSMN_PARENT_LINKS)
+  element->parent = JSMN_TOK_PARENT(tokens, child);
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+  element->next_sibling = JSMN_TOK_NEXT_SIBLING(tokens, child);
+#endif
+  element->elements = JSMN_TOK_ELEMENTS(tokens, child);
+  return child;
 }
+#endif
@@ -49,6 +49,112 @@ typedef unsigned int jsmnint_t;
 #endif
 #define JSMN_NEG ((jsmnint_t)-1)
 
+#if !defined(JSMN_VALIDATE_DEPTH)
+# define JSMN_VALIDATE_DEPTH 1024
+#endif
+
+#if !defined(JSMN_SEGMENTED_TOKENS)
+typedef jsmnint_t jsmnpos_t;
+# define JSMNPOS_MAX JSMNINT_MAX
+#else
+typedef unsigned int jsmnpos_t;
+# define JSMNPOS_MAX UINT_MAX
+# if !defined(JSMN_SEGMENTS)
+#  define JSMN_SEGMENTS 256
+# endif
+# if defined(JSMN_SOA_TOKENS)
+#  error "JSMN_SEGMENTED_TOKENS does not support JSMN_SOA_TOKENS"
+# endif
+#endif
+#define JSMN_POS_NEG ((jsmnpos_t)-1)
+
+#if defined(JSMN_PAIR_TOKENS)
+# if defined(JSMN_PERMISSIVE_RULESET) || defined(JSMN_PERMISSIVE_KEY)
+#  error "JSMN_PAIR_TOKENS does not support JSMN_PERMISSIVE_RULESET or JSMN_PERMISSIVE_KEY"
+# endif
+# if defined(JSMN_SEGMENTED_TOKENS)
+#  error "JSMN_PAIR_TOKENS does not support JSMN_SEGMENTED_TOKENS"
+# endif
+#endif
+
+#if defined(JSMN_LAZY_TOKENS) && defined(JSMN_SEGMENTED_TOKENS)
+# error "JSMN_LAZY_TOKENS does not support JSMN_SEGMENTED_TOKENS"
+#endif
+
+#if defined(JSMN_TRUSTED) && defined(JSMN_PERMISSIVE_RULESET)
+# error "JSMN_TRUSTED does not support JSMN_PERMISSIVE_RULESET"
+#endif
+
+#if defined(JSMN_PROJECTION)
+# if defined(JSMN_PERMISSIVE_RULESET) || defined(JSMN_PERMISSIVE_KEY)
+#  error "JSMN_PROJECTION does not support JSMN_PERMISSIVE_RULESET or JSMN_PERMISSIVE_KEY"
+# endif
+# if !defined(JSMN_PROJECT_DEPTH)
+#  define JSMN_PROJECT_DEPTH 16
+# endif
+# define JSMN_PROJECT_PATHS (sizeof(unsigned long) * CHAR_BIT)
+#endif
+
+#if defined(JSMN_COMPACT_ARRAYS)
+# if defined(JSMN_PERMISSIVE_RULESET) || defined(JSMN_PERMISSIVE_PRIMITIVE)
+#  error "JSMN_COMPACT_ARRAYS does not support JSMN_PERMISSIVE_RULESET or JSMN_PERMISSIVE_PRIMITIVE"
+# endif
+# if defined(JSMN_SEGMENTED_TOKENS)
+#  error "JSMN_COMPACT_ARRAYS does not support JSMN_SEGMENTED_TOKENS"
+# endif
+#endif
+
+#if defined(JSMN_CHECKPOINTS)
+# if defined(JSMN_COMPACT_ARRAYS) || defined(JSMN_STREAM_ELEMENTS) || defined(JSMN_SEGMENTED_TOKENS)
+#  error "JSMN_CHECKPOINTS does not support JSMN_COMPACT_ARRAYS, JSMN_STREAM_ELEMENTS or JSMN_SEGMENTED_TOKENS"
+# endif
+#endif
+
+#if defined(JSMN_RECOVERY)
+# if !defined(JSMN_MULTIPLE_JSON)
+#  error "JSMN_RECOVERY requires JSMN_MULTIPLE_JSON"
+# endif
+# if defined(JSMN_STREAM_ELEMENTS)
+#  error "JSMN_RECOVERY does not support JSMN_STREAM_ELEMENTS"
+# endif
+#endif
+
+#if defined(JSMN_IOVEC)
+# if !defined(JSMN_PARENT_LINKS)
+#  error "JSMN_IOVEC requires JSMN_PARENT_LINKS"
+# endif
+# if defined(JSMN_PAIR_TOKENS) || defined(JSMN_COMPACT_ARRAYS) || defined(JSMN_SEGMENTED_TOKENS)
+#  error "JSMN_IOVEC does not support JSMN_PAIR_TOKENS, JSMN_COMPACT_ARRAYS or JSMN_SEGMENTED_TOKENS"
+# endif
+#endif
+
+#if defined(JSMN_WINDOW)
+# include <stdint.h>
+typedef uint64_t jsmnoff_t;
+# if defined(JSMN_SEGMENTED_TOKENS)
+#  error "JSMN_WINDOW does not support JSMN_SEGMENTED_TOKENS"
+# endif
+#endif
+
+#if defined(JSMN_EVENTS)
+# if defined(JSMN_PERMISSIVE_RULESET)
+#  error "JSMN_EVENTS does not support JSMN_PERMISSIVE_RULESET"
+# endif
+# if !defined(JSMN_EVENT_DEPTH)
+#  define JSMN_EVENT_DEPTH 1024
+# endif
+#endif
+
+#if defined(JSMN_BLOCK_TOKENS)
+# if !defined(JSMN_BLOCK_SHIFT)
+#  define JSMN_BLOCK_SHIFT 10
+# endif
+# define JSMN_BLOCK_SIZE ((jsmnint_t)1 << JSMN_BLOCK_SHIFT)
+# if defined(JSMN_SOA_TOKENS)
+#  error "JSMN_BLOCK_TOKENS does not support JSMN_SOA_TOKENS"
+# endif
+#endif
+
 /**
  * JSON type identifier. Basic types are:
  */
@@ -95,6 +201,12 @@ typedef enum {
   JSMN_COLON        = 0x2000,   /*!< Colon ':' expected after KEY */
   JSMN_COMMA        = 0x4000,   /*!< Comma ',' expected after VALUE */
   JSMN_INSD_OBJ     = 0x8000,   /*!< Inside an OBJECT */
+#if defined(JSMN_LAZY_TOKENS)
+  JSMN_UNEXPANDED   = 0x10000,  /*!< OBJECT or ARRAY below max_depth, contents not tokenized */
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+  JSMN_COMPACT      = 0x20000,  /*!< ARRAY of numbers, elements are in the parser's offsets */
+#endif
 
   /* Parsing rules */
 #if !defined(JSMN_PERMISSIVE_RULESET)
@@ -104,6 +216,7 @@ typedef enum {
 # else
   JSMN_ROOT         = JSMN_VAL_TYPE | JSMN_VALUE,
 # endif
+  JSMN_ROOT_AFTR_O  = JSMN_ROOT,
   JSMN_OPEN_OBJECT  = JSMN_KEY_TYPE | JSMN_KEY   | JSMN_CLOSE | JSMN_INSD_OBJ,
   JSMN_AFTR_OBJ_KEY =                 JSMN_VALUE |              JSMN_INSD_OBJ | JSMN_COLON,
   JSMN_AFTR_OBJ_VAL =                              JSMN_CLOSE | JSMN_INSD_OBJ |              JSMN_COMMA,
@@ -148,8 +261,14 @@ typedef enum jsmnerr {
   JSMN_ERROR_INVAL      = -3,   /*!< Invalid character inside JSON string */
   JSMN_ERROR_PART       = -4,   /*!< The string is not a full JSON packet, more bytes expected */
   JSMN_ERROR_BRACKETS   = -5,   /*!< The JSON string has unmatched brackets */
+#if defined(JSMN_STEPS)
+  JSMN_ERROR_YIELD      = -6,   /*!< jsmn_parse_step used up its budget, call it again to go on */
+
+  JSMN_ERROR_MAX        = -6,   /*!< "MAX" value to be tested against when checking for errors */
+#else
 
   JSMN_ERROR_MAX        = -5,   /*!< "MAX" value to be tested against when checking for errors */
+#endif
 } jsmnerr;
 
 /*!
@@ -164,18 +283,195 @@ typedef enum jsmnbool {
  * JSON token description.
  */
 typedef struct jsmntok_t {
+#if !defined(JSMN_SEGMENTED_TOKENS)
   jsmntype_t type;              /*!< type (object, array, string etc.) */
+#else
+  unsigned short type;          /*!< type (object, array, string etc.) */
+  unsigned char start_segment;  /*!< parser segment start is relative to */
+  unsigned char end_segment;    /*!< parser segment end is relative to */
+#endif
   jsmnint_t start;              /*!< start position in JSON data string */
   jsmnint_t end;                /*!< end position in JSON data string */
   jsmnint_t size;               /*!< number of children */
+#if defined(JSMN_PAIR_TOKENS)
+  jsmnint_t key_start;          /*!< start position of the member's key */
+  jsmnint_t key_end;            /*!< end position of the member's key */
+#endif
 #if defined(JSMN_PARENT_LINKS)
   jsmnint_t parent;             /*!< parent id */
 #endif
 #if defined(JSMN_NEXT_SIBLING)
   jsmnint_t next_sibling;       /*!< next sibling id */
 #endif
+#if defined(JSMN_COMPACT_ARRAYS)
+  jsmnint_t elements;           /*!< where a JSMN_COMPACT array's elements are in the parser's offsets */
+#endif
 } jsmntok_t;
 
+#if defined(JSMN_SOA_TOKENS)
+/**
+ * JSON token storage as a structure of arrays.
+ *
+ * Every array is supplied by the caller and must hold at least num_tokens
+ * entries, token i is described by types[i], starts[i], ends[i], etc.
+ */
+typedef struct jsmntok_soa_t {
+  jsmntype_t *types;            /*!< type (object, array, string etc.) */
+  jsmnint_t *starts;            /*!< start position in JSON data string */
+  jsmnint_t *ends;              /*!< end position in JSON data string */
+  jsmnint_t *sizes;             /*!< number of children */
+#if defined(JSMN_PAIR_TOKENS)
+  jsmnint_t *key_starts;        /*!< start position of the member's key */
+  jsmnint_t *key_ends;          /*!< end position of the member's key */
+#endif
+#if defined(JSMN_PARENT_LINKS)
+  jsmnint_t *parents;           /*!< parent id */
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+  jsmnint_t *siblings;          /*!< next sibling id */
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+  jsmnint_t *elements;          /*!< where a JSMN_COMPACT array's elements are in the parser's offsets */
+#endif
+} jsmntok_soa_t;
+
+typedef jsmntok_soa_t jsmntokens_t;
+
+# define JSMN_TOK_TYPE(tokens, i)         ((tokens)->types[i])
+# define JSMN_TOK_START(tokens, i)        ((tokens)->starts[i])
+# define JSMN_TOK_END(tokens, i)          ((tokens)->ends[i])
+# define JSMN_TOK_SIZE(tokens, i)         ((tokens)->sizes[i])
+# define JSMN_TOK_KEY_START(tokens, i)    ((tokens)->key_starts[i])
+# define JSMN_TOK_KEY_END(tokens, i)      ((tokens)->key_ends[i])
+# define JSMN_TOK_PARENT(tokens, i)       ((tokens)->parents[i])
+# define JSMN_TOK_NEXT_SIBLING(tokens, i) ((tokens)->siblings[i])
+# define JSMN_TOK_ELEMENTS(tokens, i)     ((tokens)->elements[i])
+#else
+# if defined(JSMN_BLOCK_TOKENS)
+/**
+ * JSON token storage as a directory of fixed size blocks.
+ *
+ * Token i lives in blocks[i >> JSMN_BLOCK_SHIFT] at slot
+ * i & (JSMN_BLOCK_SIZE - 1), so appending a block never moves the tokens
+ * already parsed. When jsmn_parse needs a token past the last block it calls
+ * grow (if set), which must append a block to the directory and return
+ * nonzero, otherwise jsmn_parse returns JSMN_ERROR_NOMEM and can be resumed
+ * once a block has been appended.
+ */
+typedef struct jsmntok_blocks_t {
+  jsmntok_t **blocks;           /*!< directory of JSMN_BLOCK_SIZE token blocks */
+  size_t num_blocks;            /*!< number of blocks in the directory */
+  int (*grow)(struct jsmntok_blocks_t *tokens); /*!< appends a block, may be NULL */
+  void *data;                   /*!< free for use by grow */
+} jsmntok_blocks_t;
+
+typedef jsmntok_blocks_t jsmntokens_t;
+
+#  define JSMN_TOK(tokens, i) \
+  ((tokens)->blocks[(i) >> JSMN_BLOCK_SHIFT][(i) & (JSMN_BLOCK_SIZE - 1)])
+# else
+typedef jsmntok_t jsmntokens_t;
+
+#  define JSMN_TOK(tokens, i) ((tokens)[i])
+# endif
+
+# define JSMN_TOK_TYPE(tokens, i)         (JSMN_TOK(tokens, i).type)
+# define JSMN_TOK_START(tokens, i)        (JSMN_TOK(tokens, i).start)
+# define JSMN_TOK_END(tokens, i)          (JSMN_TOK(tokens, i).end)
+# define JSMN_TOK_SIZE(tokens, i)         (JSMN_TOK(tokens, i).size)
+# define JSMN_TOK_KEY_START(tokens, i)    (JSMN_TOK(tokens, i).key_start)
+# define JSMN_TOK_KEY_END(tokens, i)      (JSMN_TOK(tokens, i).key_end)
+# define JSMN_TOK_PARENT(tokens, i)       (JSMN_TOK(tokens, i).parent)
+# define JSMN_TOK_NEXT_SIBLING(tokens, i) (JSMN_TOK(tokens, i).next_sibling)
+# define JSMN_TOK_ELEMENTS(tokens, i)     (JSMN_TOK(tokens, i).elements)
+#endif
+
+#if defined(JSMN_SEGMENTED_TOKENS)
+/* Absolute positions of a closed token, resolved through the parser's segments */
+# define JSMN_TOK_POS_START(parser, tokens, i) \
+  ((parser)->segments[JSMN_TOK(tokens, i).start_segment] + JSMN_TOK(tokens, i).start)
+# define JSMN_TOK_POS_END(parser, tokens, i) \
+  ((parser)->segments[JSMN_TOK(tokens, i).end_segment] + JSMN_TOK(tokens, i).end)
+#else
+# define JSMN_TOK_POS_START(parser, tokens, i) ((jsmnpos_t)JSMN_TOK_START(tokens, i))
+# define JSMN_TOK_POS_END(parser, tokens, i)   ((jsmnpos_t)JSMN_TOK_END(tokens, i))
+#endif
+
+#if defined(JSMN_EVENTS)
+/**
+ * Callbacks for jsmn_parse_events.
+ *
+ * Any callback may be NULL. Positions are offsets in the JSON data string,
+ * string boundaries exclude the quotes like a STRING token's do. A callback
+ * returning nonzero stops jsmn_parse_events.
+ */
+typedef struct jsmn_handler {
+  int (*begin)(void *data, const jsmntype_t type, const jsmnpos_t start); /*!< OBJECT or ARRAY opened */
+  int (*end)(void *data, const jsmntype_t type, const jsmnpos_t end);     /*!< OBJECT or ARRAY closed */
+  int (*key)(void *data, const char *js,
+             const jsmnpos_t start, const jsmnpos_t end);                  /*!< OBJECT key */
+  int (*string)(void *data, const char *js,
+                const jsmnpos_t start, const jsmnpos_t end);               /*!< STRING value */
+  int (*primitive)(void *data, const jsmntype_t type, const char *js,
+                   const jsmnpos_t start, const jsmnpos_t end);            /*!< PRIMITIVE value with its JSMN_PRI_* bits */
+  void *data;                   /*!< passed to every callback */
+} jsmn_handler;
+
+/**
+ * A value, key, or end of a container found by jsmn_next_event.
+ */
+typedef struct jsmn_event {
+  jsmntype_t type;              /*!< type a token would have, with JSMN_CLOSE for the end of an OBJECT or ARRAY, JSMN_UNDEFINED once the input is complete */
+  jsmnpos_t start;              /*!< start position in the current chunk, JSMN_POS_NEG for the end of an OBJECT or ARRAY */
+  jsmnpos_t end;                /*!< end position in the current chunk, JSMN_POS_NEG for the start of an OBJECT or ARRAY */
+} jsmn_event;
+#endif
+
+#if defined(JSMN_IOVEC)
+/**
+ * One buffer of a JSON string held in several, laid out like POSIX's struct
+ * iovec so an array of those can be passed as is.
+ */
+typedef struct jsmn_iovec {
+  const void *iov_base;         /*!< start of the buffer */
+  size_t iov_len;               /*!< length of the buffer */
+} jsmn_iovec;
+#endif
+
+#if defined(JSMN_STREAM_ELEMENTS)
+/**
+ * Called by jsmn_parse with each element of a root ARRAY once it is complete.
+ *
+ * tokens[0] is the root ARRAY, the element is tokens[1] and its subtree runs to
+ * num_tokens - 1. The tokens are reused for the next element when the
+ * callback returns, returning nonzero stops jsmn_parse.
+ */
+typedef int (*jsmn_element_cb)(void *data, const char *js,
+                               const jsmntokens_t *tokens, const jsmnint_t num_tokens);
+#endif
+
+#if defined(JSMN_COMMITTED)
+/**
+ * Called by jsmn_parse with each OBJECT or ARRAY as soon as it is closed.
+ *
+ * tokens[token] and its subtree up to tokens[parser->toknext - 1] are final,
+ * returning nonzero stops jsmn_parse.
+ */
+typedef int (*jsmn_close_cb)(void *data, const char *js,
+                             const jsmntokens_t *tokens, const jsmnint_t token);
+#endif
+
+#if defined(JSMN_RECOVERY)
+/**
+ * A line of a JSMN_MULTIPLE_JSON stream that jsmn_parse_records skipped.
+ */
+typedef struct jsmn_bad_record {
+  jsmnpos_t start;              /*!< offset of the first byte of the record */
+  jsmnpos_t end;                /*!< offset of the newline ending it, or of the end of the input */
+  jsmnint_t error;              /*!< error jsmn_parse returned for it */
+} jsmn_bad_record;
+#endif
+
 /**
  * JSON parser
  *
@@ -183,15 +479,112 @@ typedef struct jsmntok_t {
  * the string being parsed now and current position in that string.
  */
 typedef struct jsmn_parser {
-  jsmnint_t pos;            /*!< offset in the JSON string */
+  jsmnpos_t pos;            /*!< offset in the JSON string */
   jsmnint_t toknext;        /*!< next token to allocate */
                             /*!< when tokens == NULL, keeps track of container types to a depth of (sizeof(jsmnint_t) * 8) */
   jsmnint_t toksuper;       /*!< superior token node, e.g. parent object or array */
                             /*!< when tokens == NULL, toksuper represents container depth */
   jsmnint_t count;          /*!< useful to have in the parser when you are continuing a failed parse with NULL tokens */
   jsmntype_t expected;      /*!< Expected jsmn type(s) */
+#if defined(JSMN_TRUSTED)
+  jsmnbool trusted;         /*!< skip grammar checks, jsmn_init sets it */
+#endif
+#if defined(JSMN_LAZY_TOKENS)
+  jsmnint_t depth;          /*!< number of open containers */
+  jsmnint_t max_depth;      /*!< containers opened at this depth are left unexpanded, JSMN_NEG for no limit */
+#endif
+#if defined(JSMN_PAIR_TOKENS)
+  jsmnint_t key_start;      /*!< start of the key waiting for its value */
+  jsmnint_t key_end;        /*!< end of the key waiting for its value */
+#endif
+#if defined(JSMN_PROJECTION)
+  const char *const *paths; /*!< JSON Pointers of the values to keep, NULL keeps everything */
+  jsmnint_t num_paths;      /*!< number of paths */
+  jsmnint_t keep_depth;     /*!< containers opened at this depth and below are kept whole, JSMN_NEG if none */
+  unsigned long member;     /*!< paths going through the member whose key was parsed last */
+  unsigned long match[JSMN_PROJECT_DEPTH]; /*!< paths going through the open container at each depth */
+  jsmnint_t index[JSMN_PROJECT_DEPTH];     /*!< index of the current element of the open ARRAY at each depth */
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+  jsmnint_t *offsets;       /*!< element counts and offsets of JSMN_COMPACT arrays, NULL for none */
+  jsmnint_t num_offsets;    /*!< number of offsets */
+  jsmnint_t offnext;        /*!< next offset to use */
+  jsmnint_t compact;        /*!< open ARRAY holding only numbers so far, JSMN_NEG if none */
+#endif
+#if defined(JSMN_WINDOW)
+  jsmnoff_t base;           /*!< offset of js[0] in the whole stream */
+#endif
+#if defined(JSMN_STREAM_ELEMENTS)
+  jsmn_element_cb element;  /*!< called with each element of a root ARRAY, NULL keeps every token */
+  void *data;               /*!< passed to element */
+#endif
+#if defined(JSMN_RECOVERY)
+  jsmn_bad_record *bad;     /*!< lines skipped by jsmn_parse_records, NULL for none */
+  jsmnint_t num_bad;        /*!< number of bad records */
+  jsmnint_t badnext;        /*!< next bad record to use */
+#endif
+#if defined(JSMN_COMMITTED)
+  jsmn_close_cb close;      /*!< called with each OBJECT or ARRAY closed, NULL for none */
+  void *close_data;         /*!< passed to close */
+#endif
+#if defined(JSMN_EVENTS)
+  jsmntype_t type;          /*!< type of the last STRING or PRIMITIVE found */
+  jsmnbool final;           /*!< no more data follows, a PRIMITIVE at the end of it is complete, jsmn_init clears it */
+  unsigned char objects[(JSMN_EVENT_DEPTH + CHAR_BIT - 1) / CHAR_BIT]; /*!< bit set for each open OBJECT in jsmn_parse_events */
+#endif
+#if defined(JSMN_SEGMENTED_TOKENS)
+  unsigned char segment;    /*!< current segment */
+  jsmnpos_t segments[JSMN_SEGMENTS]; /*!< base offset of each segment */
+#endif
 } jsmn_parser;
 
+#if defined(JSMN_EVENTS)
+/**
+ * Pull parser over a series of chunks.
+ *
+ * Bytes before parser.pos have been reported. After JSMN_ERROR_PART the next
+ * chunk passed to jsmn_feed must start with the bytes from parser.pos to len
+ * (a value cut short is parsed again), so the input never has to be held in
+ * memory all at once.
+ */
+typedef struct jsmn_iterator {
+  jsmn_parser parser;           /*!< parser state, positions are relative to js */
+  const char *js;               /*!< current chunk */
+  size_t len;                   /*!< current chunk length */
+  size_t offset;                /*!< offset of js in the whole input */
+} jsmn_iterator;
+#endif
+
+#if defined(JSMN_CHECKPOINTS)
+/**
+ * A token as it was when a checkpoint was taken, only the fields that
+ * parsing on can change.
+ */
+typedef struct jsmn_undo {
+  jsmnint_t token;              /*!< id of the token */
+  jsmntype_t type;              /*!< type as it was */
+  jsmnint_t end;                /*!< end as it was */
+  jsmnint_t size;               /*!< size as it was */
+#if defined(JSMN_NEXT_SIBLING)
+  jsmnint_t next_sibling;       /*!< next sibling id as it was */
+#endif
+} jsmn_undo;
+
+/**
+ * Everything jsmn_rollback needs to go back to a checkpoint.
+ *
+ * Tokens from parser.toknext on are simply handed out again, only the
+ * tokens that existed already and may still change are kept in log: the
+ * open containers, a key waiting for its value, the last token, and with
+ * JSMN_NEXT_SIBLING the last child of each open container.
+ */
+typedef struct jsmn_state {
+  jsmn_parser parser;           /*!< parser as it was */
+  jsmn_undo *log;               /*!< undo log supplied to jsmn_checkpoint */
+  jsmnint_t num_log;            /*!< number of entries used in log */
+} jsmn_state;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -214,14 +607,437 @@ void jsmn_init(jsmn_parser *parser);
  * @param[in] js JSON data string
  * @param[in] len JSON data string length
  * @param[in,out] tokens pointer to memory allocated for tokens or NULL
+ *                       (a jsmntok_soa_t descriptor with JSMN_SOA_TOKENS)
  * @param[in] num_tokens number of tokens allocated
  * @return jsmnint_t number of tokens found or ERRNO
  */
 JSMN_API
 jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js,
-                     const size_t len, jsmntok_t *tokens,
+                     const size_t len, jsmntokens_t *tokens,
                      const size_t num_tokens);
 
+/**
+ * @brief Check if a parse stopped only because the input ran out
+ *
+ * For callers that read the input a chunk at a time: true after
+ * JSMN_ERROR_PART, after nothing but whitespace, and after a root value that
+ * a PRIMITIVE or another document may still go on from (with
+ * JSMN_MULTIPLE_JSON_FAIL, after any root value, so what follows is checked).
+ * Call jsmn_parse again with more input in those cases.
+ *
+ * @param[in] parser jsmn parser
+ * @param[in] r what jsmn_parse returned
+ * @param[in] len JSON data string length jsmn_parse was given
+ * @return jsmnbool JSMN_TRUE if more input may change the result
+ */
+JSMN_API
+jsmnbool jsmn_parse_more(const jsmn_parser *parser, const jsmnint_t r,
+                         const size_t len);
+
+#if defined(JSMN_CHECKPOINTS)
+/**
+ * @brief Remember the parser and tokens so a parse can be undone
+ *
+ * The log needs one entry for the last token and one for each open
+ * container and key above it, two with JSMN_NEXT_SIBLING. Without
+ * JSMN_PARENT_LINKS the open containers are found by looking through the
+ * tokens before the current one.
+ *
+ * @param[in] parser jsmn parser
+ * @param[in] tokens jsmn tokens or NULL
+ * @param[out] state checkpoint to fill
+ * @param[out] log undo log for the tokens that may still change
+ * @param[in] num_log number of entries in log
+ * @return jsmnint_t JSMN_SUCCESS or JSMN_ERROR_NOMEM if log is too small
+ */
+JSMN_API
+jsmnint_t jsmn_checkpoint(const jsmn_parser *parser, const jsmntokens_t *tokens,
+                          jsmn_state *state, jsmn_undo *log, const size_t num_log);
+
+/**
+ * @brief Undo everything parsed since a checkpoint
+ *
+ * Afterwards the parser goes on from where the checkpoint was taken, e.g.
+ * with other data, or with more tokens after JSMN_ERROR_NOMEM (copy the
+ * tokens over first).
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in,out] tokens the tokens given to jsmn_checkpoint
+ * @param[in] state checkpoint filled by jsmn_checkpoint
+ */
+JSMN_API
+void jsmn_rollback(jsmn_parser *parser, jsmntokens_t *tokens,
+                   const jsmn_state *state);
+#endif
+
+#if defined(JSMN_RECOVERY)
+/**
+ * @brief Run JSON parser over newline delimited records, skipping bad ones
+ *
+ * Parses like jsmn_parse one line at a time. A line that fails to parse, or
+ * that ends inside a value, is added to the table given to jsmn_recover, its
+ * tokens are dropped, and parsing goes on with the next line, so one bad
+ * record does not cost the rest of the batch. JSMN_ERROR_PART and
+ * JSMN_ERROR_NOMEM take the parser back to the start of the line they were
+ * found in, call again with more data or tokens. When the table is full the
+ * error of the line that did not fit is returned the same way.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] js JSON data string
+ * @param[in] len JSON data string length
+ * @param[in,out] tokens pointer to memory allocated for tokens or NULL
+ * @param[in] num_tokens number of tokens allocated
+ * @return jsmnint_t number of tokens found or ERRNO
+ */
+JSMN_API
+jsmnint_t jsmn_parse_records(jsmn_parser *parser, const char *js,
+                             const size_t len, jsmntokens_t *tokens,
+                             const size_t num_tokens);
+
+/**
+ * @brief Give the parser a table for the records jsmn_parse_records skips
+ *
+ * Call after jsmn_init; parser->badnext counts the entries in use.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[out] bad table of bad records or NULL
+ * @param[in] num_bad number of entries in bad
+ */
+JSMN_API
+void jsmn_recover(jsmn_parser *parser, jsmn_bad_record *bad,
+                  const size_t num_bad);
+#endif
+
+#if defined(JSMN_STEPS)
+/**
+ * @brief Run JSON parser over at most about max_bytes of a JSON string
+ *
+ * Parses from parser->pos on like jsmn_parse, but stops once max_bytes have
+ * been read and returns JSMN_ERROR_YIELD; call it again with the same
+ * arguments to go on, so a long parse can be interleaved with other work. A
+ * single value longer than max_bytes is read whole.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] js JSON data string
+ * @param[in] len JSON data string length
+ * @param[in,out] tokens pointer to memory allocated for tokens or NULL
+ * @param[in] num_tokens number of tokens allocated
+ * @param[in] max_bytes number of bytes to read in this call
+ * @return jsmnint_t number of tokens found, JSMN_ERROR_YIELD or ERRNO
+ */
+JSMN_API
+jsmnint_t jsmn_parse_step(jsmn_parser *parser, const char *js,
+                          const size_t len, jsmntokens_t *tokens,
+                          const size_t num_tokens, const size_t max_bytes);
+#endif
+
+#if defined(JSMN_IOVEC)
+/**
+ * @brief Run JSON parser over a JSON string held in several buffers
+ *
+ * Each buffer is parsed in place, token positions are offsets in the whole
+ * string (the buffers one after the other). Only a value that runs from one
+ * buffer into the next is copied, into carry, so carry has to hold the
+ * longest such value (a skipped container with JSMN_LAZY_TOKENS or
+ * JSMN_PROJECTION counts as one value). On JSMN_ERROR_PART call again with
+ * the same buffers followed by more, like jsmn_parse.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] iov buffers of the JSON data string
+ * @param[in] iovcnt number of buffers
+ * @param[in,out] tokens pointer to memory allocated for tokens or NULL
+ * @param[in] num_tokens number of tokens allocated
+ * @param[out] carry scratch buffer for values that span buffers
+ * @param[in] carry_len length of carry
+ * @return jsmnint_t number of tokens found or ERRNO, JSMN_ERROR_NOMEM if a
+ *                   value that spans buffers does not fit in carry
+ */
+JSMN_API
+jsmnint_t jsmn_parsev(jsmn_parser *parser, const jsmn_iovec *iov, const int iovcnt,
+                      jsmntokens_t *tokens, const size_t num_tokens,
+                      char *carry, const size_t carry_len);
+
+/**
+ * @brief Copy a token's text out of the buffers jsmn_parsev parsed
+ *
+ * @param[in] iov buffers of the JSON data string
+ * @param[in] iovcnt number of buffers
+ * @param[in] tokens jsmn tokens
+ * @param[in] token id of the token
+ * @param[out] buf destination, the text is followed by a '\0'
+ * @param[in] size size of buf
+ * @return jsmnint_t length of the text or JSMN_ERROR_NOMEM if buf is too small
+ */
+JSMN_API
+jsmnint_t jsmn_iov_copy(const jsmn_iovec *iov, const int iovcnt,
+                        const jsmntokens_t *tokens, const jsmnint_t token,
+                        char *buf, const size_t size);
+
+/**
+ * @brief Compare a token's text in the buffers jsmn_parsev parsed to a string
+ *
+ * @param[in] iov buffers of the JSON data string
+ * @param[in] iovcnt number of buffers
+ * @param[in] tokens jsmn tokens
+ * @param[in] token id of the token
+ * @param[in] s string to compare to
+ * @param[in] len length of s
+ * @return jsmnbool JSMN_TRUE if the text is s
+ */
+JSMN_API
+jsmnbool jsmn_iov_equal(const jsmn_iovec *iov, const int iovcnt,
+                        const jsmntokens_t *tokens, const jsmnint_t token,
+                        const char *s, const size_t len);
+#endif
+
+/**
+ * @brief Check that a JSON string is well formed
+ *
+ * Applies the rules jsmn_parse does without producing or counting tokens, open
+ * containers take a bit each so nesting is only limited by JSMN_VALIDATE_DEPTH
+ * (default 1024). Anything but whitespace after the root value is an error,
+ * with JSMN_MULTIPLE_JSON too. JSMN_PERMISSIVE_RULESET keeps its own rules for
+ * what may follow a root value.
+ *
+ * @param[in] js JSON data string
+ * @param[in] len JSON data string length
+ * @param[out] error offset where the error was found (len for
+ *                   JSMN_ERROR_PART), or NULL
+ * @return jsmnint_t JSMN_SUCCESS or ERRNO, JSMN_ERROR_NOMEM if nesting is
+ *                   deeper than JSMN_VALIDATE_DEPTH
+ */
+JSMN_API
+jsmnint_t jsmn_validate(const char *js, const size_t len, jsmnpos_t *error);
+
+#if defined(JSMN_EVENTS)
+/**
+ * @brief Run JSON parser without tokens, reporting each value as it is found
+ *
+ * Follows the rules jsmn_parse does, but instead of filling tokens it calls
+ * handler's callbacks in document order. Memory use does not depend on the
+ * size of the input, open containers take a bit each in the parser so nesting
+ * is limited by JSMN_EVENT_DEPTH (default 1024). On JSMN_ERROR_PART call again
+ * with the same parser and more data: a value cut short is reported once the
+ * rest of it has arrived. A root PRIMITIVE that reaches the end of the data may
+ * go on too, so it is only reported once parser->final is set for the last of
+ * the input. When a callback stops the parse the parser is left after the
+ * value it was called for, calling again carries on from there.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] js JSON data string
+ * @param[in] len JSON data string length
+ * @param[in] handler callbacks and their data
+ * @return jsmnint_t number of tokens jsmn_parse would have used or ERRNO,
+ *                   JSMN_ERROR_NOMEM if nesting is deeper than
+ *                   JSMN_EVENT_DEPTH, JSMN_ERROR_INVAL if a callback stopped
+ *                   the parse
+ */
+JSMN_API
+jsmnint_t jsmn_parse_events(jsmn_parser *parser, const char *js,
+                            const size_t len, const jsmn_handler *handler);
+
+/**
+ * @brief Start a pull parser
+ *
+ * @param[out] it jsmn iterator, without input until jsmn_feed
+ */
+JSMN_API
+void jsmn_iterator_init(jsmn_iterator *it);
+
+/**
+ * @brief Give a pull parser its next chunk of input
+ *
+ * @param[in,out] it jsmn iterator
+ * @param[in] js chunk, starting with the bytes of the previous chunk from
+ *               it->parser.pos on, or NULL at the end of the input to keep
+ *               parsing the current chunk knowing nothing follows it
+ * @param[in] len chunk length
+ */
+JSMN_API
+void jsmn_feed(jsmn_iterator *it, const char *js, const size_t len);
+
+/**
+ * @brief Get the next event from a pull parser
+ *
+ * Uses the same rules and state as jsmn_parse_events. Event positions are
+ * relative to the current chunk, add it->offset for positions in the whole
+ * input.
+ *
+ * @param[in,out] it jsmn iterator
+ * @param[out] event the value, key, or end of a container found, of type
+ *                   JSMN_UNDEFINED once the input is complete
+ * @return jsmnint_t JSMN_SUCCESS or ERRNO, JSMN_ERROR_PART when the chunk is
+ *                   used up and jsmn_feed should give the next one, or NULL
+ *                   if there is none
+ */
+JSMN_API
+jsmnint_t jsmn_next_event(jsmn_iterator *it, jsmn_event *event);
+#endif
+
+#if defined(JSMN_LAZY_TOKENS)
+/**
+ * @brief Tokenize an unexpanded OBJECT or ARRAY
+ *
+ * Parses the contents of token into subtokens, positions stay relative to js.
+ * The parser must be initialized with jsmn_init (max_depth may be set to
+ * expand lazily again) and can be passed again after JSMN_ERROR_NOMEM.
+ *
+ * @param[in,out] parser jsmn parser for the subtree
+ * @param[in] js JSON data string the tokens were parsed from
+ * @param[in] tokens tokens holding the unexpanded token
+ * @param[in] token id of the JSMN_UNEXPANDED token
+ * @param[in,out] subtokens pointer to memory allocated for the subtree's tokens or NULL
+ * @param[in] num_subtokens number of subtokens allocated
+ * @return jsmnint_t number of tokens found or ERRNO
+ */
+JSMN_API
+jsmnint_t jsmn_expand(jsmn_parser *parser, const char *js,
+                      const jsmntokens_t *tokens, const jsmnint_t token,
+                      jsmntokens_t *subtokens, const size_t num_subtokens);
+#endif
+
+#if defined(JSMN_PROJECTION)
+/**
+ * @brief Restrict the tokens jsmn_parse produces to a set of paths
+ *
+ * Each path is a JSON Pointer, e.g. "/items/0/id", "" is the whole document.
+ * Call after jsmn_init and before parsing, the paths must outlive the parse.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] paths JSON Pointers of the values to keep
+ * @param[in] num_paths number of paths, at most JSMN_PROJECT_PATHS
+ * @return jsmnint_t JSMN_SUCCESS or JSMN_ERROR_INVAL if there are too many
+ *                   paths, one is not a JSON Pointer, or one is deeper than
+ *                   JSMN_PROJECT_DEPTH
+ */
+JSMN_API
+jsmnint_t jsmn_project(jsmn_parser *parser, const char *const *paths,
+                       const size_t num_paths);
+#endif
+
+#if defined(JSMN_WINDOW)
+/**
+ * @brief Drop consumed input from the front of the parser's window
+ *
+ * Between calls to jsmn_parse the caller may discard input it is done with.
+ * Only bytes the parser will not read again are dropped: never past
+ * parser->pos, nor into a PRIMITIVE cut short or an open JSMN_COMPACT array.
+ * Positions in the parser and in tokens move down by the number of bytes
+ * dropped and parser->base goes up by the same amount, so base + position is
+ * the offset in the whole stream of any position still in the window. A
+ * position that falls before the window, such as the start of an open
+ * container or of a finished token, is clamped to 0 and no longer gives a
+ * valid stream offset; read what is needed from such tokens before dropping
+ * their input. The caller then moves js[dropped..len) to the front of its
+ * buffer and appends new input after it.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] js JSON data string the parser has been given so far
+ * @param[in,out] tokens tokens filled by the parser, or NULL
+ * @param[in] drop number of bytes the caller would like to drop
+ * @return jsmnpos_t number of bytes dropped, at most drop
+ */
+JSMN_API
+jsmnpos_t jsmn_slide(jsmn_parser *parser, const char *js,
+                     jsmntokens_t *tokens, const jsmnpos_t drop);
+#endif
+
+#if defined(JSMN_STREAM_ELEMENTS)
+/**
+ * @brief Reuse the tokens of each element of a root ARRAY
+ *
+ * Call after jsmn_init and before parsing. Whenever an element of the root
+ * ARRAY is complete (at the following ',' or ']'), jsmn_parse passes its
+ * tokens to element and then hands them out again for the next element, so
+ * num_tokens only has to cover the root and the largest element. jsmn_parse
+ * still returns the number of tokens used in all.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] element callback for each element, NULL keeps every token
+ * @param[in] data passed to element
+ */
+JSMN_API
+void jsmn_stream(jsmn_parser *parser, jsmn_element_cb element, void *data);
+#endif
+
+#if defined(JSMN_COMMITTED)
+/**
+ * @brief Find the tokens that will not change any more
+ *
+ * Valid after any call to jsmn_parse, JSMN_ERROR_PART included. Every token
+ * before the one returned is final, except for the OBJECTs and ARRAYs still
+ * open around the parse position (their end and size) and, with
+ * JSMN_NEXT_SIBLING, the link to a sibling not found yet.
+ *
+ * @param[in] parser jsmn parser
+ * @param[in] tokens jsmn tokens
+ * @return jsmnint_t number of leading tokens that are final
+ */
+JSMN_API
+jsmnint_t jsmn_committed(const jsmn_parser *parser, const jsmntokens_t *tokens);
+
+/**
+ * @brief Get a callback for each OBJECT and ARRAY as soon as it is closed
+ *
+ * Call after jsmn_init and before parsing, so the first records of a large
+ * document can be used while the rest of it is still arriving.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[in] close callback for each container closed, NULL for none
+ * @param[in] data passed to close
+ */
+JSMN_API
+void jsmn_on_close(jsmn_parser *parser, jsmn_close_cb close, void *data);
+#endif
+
+#if defined(JSMN_COMPACT_ARRAYS)
+/**
+ * @brief Store arrays of numbers in a table of offsets instead of tokens
+ *
+ * Call after jsmn_init and before parsing. Each JSMN_COMPACT array takes one
+ * entry for its element count and one per element.
+ *
+ * @param[in,out] parser jsmn parser
+ * @param[out] offsets table for the element counts and offsets
+ * @param[in] num_offsets number of entries in offsets
+ */
+JSMN_API
+void jsmn_compact(jsmn_parser *parser, jsmnint_t *offsets,
+                  const size_t num_offsets);
+
+/**
+ * @brief Number of elements of an ARRAY, JSMN_COMPACT or not
+ *
+ * @param[in] parser jsmn parser that parsed tokens
+ * @param[in] tokens jsmn tokens
+ * @param[in] array id of the ARRAY token
+ * @return jsmnint_t number of elements
+ */
+JSMN_API
+jsmnint_t jsmn_array_size(const jsmn_parser *parser,
+                          const jsmntokens_t *tokens, const jsmnint_t array);
+
+/**
+ * @brief Find an element of an ARRAY, JSMN_COMPACT or not
+ *
+ * Elements of a JSMN_COMPACT array are described as the PRIMITIVE token they
+ * would have had, without a parent or sibling.
+ *
+ * @param[in] parser jsmn parser that parsed tokens
+ * @param[in] js JSON data string
+ * @param[in] tokens jsmn tokens
+ * @param[in] array id of the ARRAY token
+ * @param[in] index index of the element
+ * @param[out] element type, boundaries, and size of the element, its type is
+ *                     JSMN_UNDEFINED if index is out of range
+ * @return jsmnint_t id of the element's token, JSMN_NEG if it has none
+ */
+JSMN_API
+jsmnint_t jsmn_array_element(const jsmn_parser *parser, const char *js,
+                             const jsmntokens_t *tokens, const jsmnint_t array,
+                             const jsmnint_t index, jsmntok_t *element);
+#endif
+
 #if !defined(JSMN_HEADER)
 #include "jsmn.c"
 #endif /* JSMN_HEADER */
@@ -50,6 +50,176 @@
  *   jsmnerr (JSMN_ERROR_MAX).
  */
 
+/*! @def JSMN_SOA_TOKENS
+ * @brief Stores tokens as a structure of arrays
+ *
+ * jsmn_parse writes into the parallel arrays of a caller supplied
+ *   jsmntok_soa_t descriptor instead of an array of jsmntok_t. Passes that only
+ *   look at a token's type or boundaries then walk dense arrays. Use the
+ *   JSMN_TOK_* accessors to read tokens independently of the storage layout.
+ */
+
+/*! @def JSMN_BLOCK_TOKENS
+ * @brief Stores tokens in a directory of fixed size blocks
+ *
+ * jsmn_parse writes into a caller supplied jsmntok_blocks_t descriptor whose
+ *   blocks hold JSMN_BLOCK_SIZE (1 << JSMN_BLOCK_SHIFT, default 1024) tokens
+ *   each. Running out of blocks calls the descriptor's grow callback, so the
+ *   token storage grows without reallocating or copying parsed tokens. Use the
+ *   JSMN_TOK_* accessors to read tokens independently of the storage layout.
+ */
+
+/*! @def JSMN_PAIR_TOKENS
+ * @brief Stores object keys on their value's token
+ *
+ * Object members use a single token: the value's token gets JSMN_INSD_OBJ and
+ *   its key's boundaries in key_start and key_end (JSMN_TOK_KEY_START and
+ *   JSMN_TOK_KEY_END), and the object is the value's parent. Keys do not get a
+ *   token of their own and are not counted. NOTE: Not compatible with
+ *   JSMN_PERMISSIVE_RULESET, JSMN_PERMISSIVE_KEY, or JSMN_SEGMENTED_TOKENS.
+ */
+
+/*! @def JSMN_LAZY_TOKENS
+ * @brief Leaves containers below a depth limit untokenized
+ *
+ * An OBJECT or ARRAY opened while parser->max_depth containers are already
+ *   open becomes a single token with JSMN_UNEXPANDED set, a size of 0, and its
+ *   full start and end. Its contents are skipped a word at a time, tracking
+ *   only strings and brackets, and are not validated until jsmn_expand()
+ *   tokenizes them. jsmn_init sets max_depth to JSMN_NEG (no limit).
+ */
+
+/*! @def JSMN_PROJECTION
+ * @brief Only tokenizes the values on a set of paths
+ *
+ * jsmn_project() gives the parser a set of JSON Pointers (RFC 6901). Values
+ *   on those paths are tokenized with all of their contents, their ancestors
+ *   are tokenized with only the members leading to them, and every other
+ *   member is skipped without a token (containers a word at a time, as with
+ *   JSMN_LAZY_TOKENS, which this implies). Keys are compared as they appear in
+ *   the json string, escapes are not decoded. NOTE: Not compatible with
+ *   JSMN_PERMISSIVE_RULESET or JSMN_PERMISSIVE_KEY.
+ */
+
+/*! @def JSMN_TRUSTED
+ * @brief Skips grammar checks on input that is known to be valid
+ *
+ * While parser->trusted is set (jsmn_init sets it) the parser only finds token
+ *   boundaries and links: the expected type checks, escape and control
+ *   character checks in strings, bracket type matching, and the number and
+ *   literal checks in primitives are skipped. Valid JSON gets the same tokens
+ *   as without JSMN_TRUSTED, tokens for invalid JSON are unspecified.
+ *   jsmn_validate always checks.
+ */
+
+/*! @def JSMN_COMPACT_ARRAYS
+ * @brief Stores arrays of numbers as a single token
+ *
+ * Once jsmn_compact() gives the parser a table of offsets, an ARRAY whose
+ *   elements are all numbers gets no token per element: its token is flagged
+ *   JSMN_COMPACT, has a size of 0 like a JSMN_UNEXPANDED token, and the
+ *   number of elements and the offset of each one are kept in the table. An
+ *   ARRAY stops being compact (its elements get their tokens after all) as
+ *   soon as anything but a number is found in it, or the table is full. Use
+ *   jsmn_array_size() and jsmn_array_element() to read arrays of either kind.
+ *   The count from a NULL tokens parse is for the tokens without compaction.
+ *   NOTE: Not compatible with JSMN_PERMISSIVE_RULESET,
+ *   JSMN_PERMISSIVE_PRIMITIVE, or JSMN_SEGMENTED_TOKENS.
+ */
+
+/*! @def JSMN_CHECKPOINTS
+ * @brief Adds jsmn_checkpoint() and jsmn_rollback() to undo a parse
+ *
+ * A checkpoint is a copy of the parser and a short undo log of the tokens
+ *   that may still change (about one per open container), so a speculative
+ *   parse or one that ran out of tokens can be undone without parsing again
+ *   from the start. NOTE: Not compatible with JSMN_COMPACT_ARRAYS,
+ *   JSMN_STREAM_ELEMENTS or JSMN_SEGMENTED_TOKENS.
+ */
+
+/*! @def JSMN_RECOVERY
+ * @brief Skips malformed records of a newline delimited stream
+ *
+ * jsmn_parse_records() parses a JSMN_MULTIPLE_JSON buffer a line at a time;
+ *   a line that does not parse is logged in the table given to jsmn_recover()
+ *   with its range and error, its tokens are dropped, and parsing resumes on
+ *   the next line. NOTE: Requires JSMN_MULTIPLE_JSON, not compatible with
+ *   JSMN_STREAM_ELEMENTS.
+ */
+
+/*! @def JSMN_STEPS
+ * @brief Adds jsmn_parse_step(), parsing a json string a few bytes at a time
+ *
+ * Each call reads about max_bytes from parser->pos on and returns
+ *   JSMN_ERROR_YIELD if there is more to read, so the time spent in one call
+ *   is bounded. NOTE: JSMN_ERROR_MAX becomes -6.
+ */
+
+/*! @def JSMN_IOVEC
+ * @brief Adds jsmn_parsev(), parsing a json string held in several buffers
+ *
+ * Each buffer is parsed where it is and token positions are offsets in the
+ *   buffers taken one after the other, jsmn_iov_copy() and jsmn_iov_equal()
+ *   read a token's text across buffers. Only values that span two buffers are
+ *   copied, into a scratch buffer the caller provides. NOTE: Requires
+ *   JSMN_PARENT_LINKS, not compatible with JSMN_PAIR_TOKENS,
+ *   JSMN_COMPACT_ARRAYS or JSMN_SEGMENTED_TOKENS.
+ */
+
+/*! @def JSMN_WINDOW
+ * @brief Lets a stream be parsed in a buffer of constant size
+ *
+ * jsmn_slide() drops input the parser is done with from the front of the
+ *   buffer and rebases the parser and its tokens onto what is left, keeping
+ *   the offset of the buffer in the whole stream in a 64 bit parser->base.
+ *   Rebasing touches every token in use, pair it with JSMN_STREAM_ELEMENTS or
+ *   MULTIPLE_JSON and a fresh jsmn_init per document to keep that small.
+ *   NOTE: Not compatible with JSMN_SEGMENTED_TOKENS.
+ */
+
+/*! @def JSMN_COMMITTED
+ * @brief Reports which tokens are final while a document is still arriving
+ *
+ * jsmn_committed() tells how many leading tokens will not change any more
+ *   after a call to jsmn_parse, JSMN_ERROR_PART included, and jsmn_on_close()
+ *   sets a callback run each time an OBJECT or ARRAY is closed.
+ */
+
+/*! @def JSMN_STREAM_ELEMENTS
+ * @brief Parses a root ARRAY one element at a time in the same tokens
+ *
+ * Once jsmn_stream() gives the parser a callback, each element of a root
+ *   ARRAY is passed to it as soon as the ',' or ']' after it is found, and the
+ *   element's tokens are then reused for the next one. Token 0 stays the root
+ *   ARRAY, its size keeps counting the elements. Memory is bounded by the
+ *   largest element rather than the whole document; a NOMEM error means one
+ *   element does not fit.
+ */
+
+/*! @def JSMN_EVENTS
+ * @brief Adds jsmn_parse_events() and jsmn_next_event(), interfaces that use no tokens
+ *
+ * jsmn_parse_events() walks the json string with the same rules as
+ *   jsmn_parse() and calls a jsmn_handler for every container opened and
+ *   closed, every key, and every value. jsmn_next_event() returns the same
+ *   events one at a time from a jsmn_iterator that is fed the input in
+ *   chunks. Only the bit per open container kept in the parser grows with the
+ *   input, nesting is limited to JSMN_EVENT_DEPTH (default 1024) levels.
+ *   NOTE: Not compatible with JSMN_PERMISSIVE_RULESET.
+ */
+
+/*! @def JSMN_SEGMENTED_TOKENS
+ * @brief Keeps JSMN_SHORT_TOKENS sized tokens on json strings over 64 KB
+ *
+ * Token start and end are stored relative to one of up to JSMN_SEGMENTS
+ *   (at most 256) base offsets kept in the parser, each token records which
+ *   segment its start and end belong to. A new segment is started whenever a
+ *   position is out of reach of the current one, so every segment covers at
+ *   least 64 KB of input. Use JSMN_TOK_POS_START and JSMN_TOK_POS_END to get
+ *   absolute positions. NOTE: Token ids, sizes, and counts are still limited to
+ *   jsmnint_t. Not compatible with jsmn_utils.
+ */
+
 /*! @def JSMN_PERMISSIVE
  * @brief Enables all PERMISSIVE definitions
  *
@@ -120,6 +290,14 @@
 
 #endif
 
+#if defined(JSMN_PROJECTION) && !defined(JSMN_LAZY_TOKENS)
+# define JSMN_LAZY_TOKENS
+#endif
+
+#if defined(JSMN_SEGMENTED_TOKENS) && !defined(JSMN_SHORT_TOKENS)
+# define JSMN_SHORT_TOKENS
+#endif
+
 #if defined(JSMN_PERMISSIVE)
 # if !defined(JSMN_PERMISSIVE_RULESET)
 #  define JSMN_PERMISSIVE_RULESET
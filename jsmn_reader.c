@@ -0,0 +1,807 @@
+/* pthreads, clock_gettime and pread */
+#define _DEFAULT_SOURCE
+
+#include "jsmn_reader.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(JSMN_HAVE_ZLIB)
+# include <zlib.h>
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+# include <zstd.h>
+#endif
+
+#if defined(__linux__) && !defined(JSMN_NO_IO_URING)
+# define JSMN_IO_URING
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+#endif
+
+/**
+ * Blocks in flight and the backend reading them
+ */
+struct jsmn_reader_io {
+  int fd;
+  size_t block_size;
+  int depth;
+  int next;                         /* next block to take, blocks are taken in order */
+  char *blocks;                     /* depth blocks of block_size */
+  long done[JSMN_READER_DEPTH];     /* bytes read into each block, -errno on error */
+  int full[JSMN_READER_DEPTH];      /* the read of each block has finished */
+
+  /* reader thread */
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t filled;
+  pthread_cond_t emptied;
+  int stop;
+  unsigned long long in;            /* bytes read */
+  double read_time;                 /* seconds spent reading */
+  double decode_time;               /* seconds spent decompressing */
+  unsigned long long shown_in;      /* the three above as of the last block finished */
+  double shown_read_time;
+  double shown_decode_time;
+
+  /* compressed input */
+  jsmn_compression format;
+  char *input;                      /* block_size of input read ahead of the decoder */
+  size_t in_pos;                    /* input used */
+  size_t in_len;                    /* input held */
+  int in_eof;                       /* the file descriptor is at its end */
+  int in_frame;                     /* a gzip member or zstd frame has begun and not ended */
+  int decoder;                      /* the decoder for format is set up */
+#if defined(JSMN_HAVE_ZLIB)
+  z_stream gzip;
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+  ZSTD_DStream *zstd;
+#endif
+
+#if defined(JSMN_IO_URING)
+  int ring;
+  size_t ring_size;
+  void *ring_map;
+  struct io_uring_sqe *sqes;
+  unsigned sq_entries;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+  off_t size;                       /* size of the file */
+  off_t offset;                     /* where the next read queued starts */
+  off_t start[JSMN_READER_DEPTH];   /* where each block starts */
+  size_t want[JSMN_READER_DEPTH];   /* bytes asked for each block, 0 past the end */
+#endif
+};
+
+static double jsmn_reader_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Reads from the file descriptor, a read blocked on a pipe can be cancelled.
+ */
+static long jsmn_reader_read(struct jsmn_reader_io *io, char *buf, const size_t size)
+{
+    const double start = jsmn_reader_now();
+    int error;
+    long n;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    do {
+        n = (long)read(io->fd, buf, size);
+    } while (n < 0 && errno == EINTR);
+    error = errno;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+    io->read_time += jsmn_reader_now() - start;
+    if (n < 0) {
+        return -error;
+    }
+    io->in += n;
+    return n;
+}
+
+#if defined(JSMN_HAVE_ZLIB) || defined(JSMN_HAVE_ZSTD)
+/**
+ * Makes sure some compressed input is held, 0 at its end.
+ */
+static long jsmn_reader_input(struct jsmn_reader_io *io)
+{
+    long n;
+
+    if (io->in_pos < io->in_len) {
+        return (long)(io->in_len - io->in_pos);
+    }
+    if (io->in_eof) {
+        return 0;
+    }
+    n = jsmn_reader_read(io, io->input, io->block_size);
+    if (n <= 0) {
+        io->in_eof = (n == 0);
+        return n;
+    }
+    io->in_pos = 0;
+    io->in_len = (size_t)n;
+    return n;
+}
+#endif
+
+/**
+ * Tells the compression from the first bytes and sets up its decoder.
+ */
+static long jsmn_reader_decoder(struct jsmn_reader_io *io)
+{
+    const unsigned char *magic = (const unsigned char *)io->input;
+    long n;
+
+    if (io->format == JSMN_READ_AUTO) {
+        while (io->in_len < 4 && io->in_len < io->block_size && !io->in_eof) {
+            n = jsmn_reader_read(io, io->input + io->in_len, io->block_size - io->in_len);
+            if (n < 0) {
+                return n;
+            }
+            io->in_eof = (n == 0);
+            io->in_len += (size_t)n;
+        }
+        if (io->in_len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+            io->format = JSMN_READ_GZIP;
+        } else if (io->in_len >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+                   magic[2] == 0x2f && magic[3] == 0xfd) {
+            io->format = JSMN_READ_ZSTD;
+        } else {
+            io->format = JSMN_READ_PLAIN;
+        }
+    }
+
+    switch (io->format) {
+#if defined(JSMN_HAVE_ZLIB)
+    case JSMN_READ_GZIP:
+        /* 32 takes a gzip or a zlib header */
+        if (inflateInit2(&io->gzip, 15 + 32) != Z_OK) {
+            return -ENOMEM;
+        }
+        break;
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+    case JSMN_READ_ZSTD:
+        io->zstd = ZSTD_createDStream();
+        if (io->zstd == NULL) {
+            return -ENOMEM;
+        }
+        ZSTD_initDStream(io->zstd);
+        break;
+#endif
+    case JSMN_READ_PLAIN:
+        break;
+    default:
+        return -ENOTSUP;
+    }
+    io->decoder = 1;
+
+    return 0;
+}
+
+#if defined(JSMN_HAVE_ZLIB)
+/**
+ * Inflates gzip members one after the other into a block.
+ */
+static long jsmn_reader_gunzip(struct jsmn_reader_io *io, char *out, const size_t size)
+{
+    double start;
+    long n;
+    int r;
+
+    io->gzip.next_out = (Bytef *)out;
+    io->gzip.avail_out = (uInt)size;
+    while (io->gzip.avail_out != 0) {
+        n = jsmn_reader_input(io);
+        if (n < 0) {
+            return n;
+        }
+        if (n == 0) {
+            /* A member cut short */
+            if (io->in_frame && io->gzip.avail_out == size) {
+                return -EIO;
+            }
+            break;
+        }
+
+        io->gzip.next_in = (Bytef *)io->input + io->in_pos;
+        io->gzip.avail_in = (uInt)n;
+        start = jsmn_reader_now();
+        r = inflate(&io->gzip, Z_NO_FLUSH);
+        io->decode_time += jsmn_reader_now() - start;
+        io->in_pos = io->in_len - io->gzip.avail_in;
+        io->in_frame = 1;
+
+        if (r == Z_STREAM_END) {
+            inflateReset(&io->gzip);
+            io->in_frame = 0;
+        } else if (r != Z_OK && r != Z_BUF_ERROR) {
+            return -EIO;
+        }
+    }
+
+    return (long)(size - io->gzip.avail_out);
+}
+#endif
+
+#if defined(JSMN_HAVE_ZSTD)
+/**
+ * Decompresses zstd frames one after the other into a block.
+ */
+static long jsmn_reader_unzstd(struct jsmn_reader_io *io, char *out, const size_t size)
+{
+    ZSTD_outBuffer output;
+    ZSTD_inBuffer input;
+    double start;
+    size_t r;
+    long n;
+
+    output.dst = out;
+    output.size = size;
+    output.pos = 0;
+    while (output.pos < output.size) {
+        n = jsmn_reader_input(io);
+        if (n < 0) {
+            return n;
+        }
+        if (n == 0) {
+            /* A frame cut short */
+            if (io->in_frame && output.pos == 0) {
+                return -EIO;
+            }
+            break;
+        }
+
+        input.src = io->input;
+        input.size = io->in_len;
+        input.pos = io->in_pos;
+        start = jsmn_reader_now();
+        r = ZSTD_decompressStream(io->zstd, &output, &input);
+        io->decode_time += jsmn_reader_now() - start;
+        if (ZSTD_isError(r)) {
+            return -EIO;
+        }
+        io->in_pos = input.pos;
+        io->in_frame = (r != 0);
+    }
+
+    return (long)output.pos;
+}
+#endif
+
+/**
+ * Fills a block with the next stretch of the input.
+ */
+static long jsmn_reader_produce(struct jsmn_reader_io *io, char *out, const size_t size)
+{
+    size_t n;
+
+    if (!io->decoder) {
+        long r = jsmn_reader_decoder(io);
+        if (r != 0) {
+            return r;
+        }
+    }
+
+    switch (io->format) {
+#if defined(JSMN_HAVE_ZLIB)
+    case JSMN_READ_GZIP:
+        return jsmn_reader_gunzip(io, out, size);
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+    case JSMN_READ_ZSTD:
+        return jsmn_reader_unzstd(io, out, size);
+#endif
+    default:
+        break;
+    }
+
+    /* What was read to tell the format goes first */
+    if (io->in_pos < io->in_len) {
+        n = (io->in_len - io->in_pos < size ? io->in_len - io->in_pos : size);
+        memcpy(out, io->input + io->in_pos, n);
+        io->in_pos += n;
+        return (long)n;
+    }
+    return jsmn_reader_read(io, out, size);
+}
+
+/**
+ * Reads blocks in order ahead of the consumer until the end of the input.
+ */
+static void *jsmn_reader_thread(void *arg)
+{
+    struct jsmn_reader_io *io = arg;
+    int slot = 0;
+    long n;
+
+    /* Only a read blocked on a pipe is cancelled, never a held lock */
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+    for (;;) {
+        pthread_mutex_lock(&io->lock);
+        while (io->full[slot] && !io->stop) {
+            pthread_cond_wait(&io->emptied, &io->lock);
+        }
+        if (io->stop) {
+            pthread_mutex_unlock(&io->lock);
+            break;
+        }
+        pthread_mutex_unlock(&io->lock);
+
+        n = jsmn_reader_produce(io, io->blocks + slot * io->block_size, io->block_size);
+
+        pthread_mutex_lock(&io->lock);
+        io->done[slot] = n;
+        io->full[slot] = 1;
+        io->shown_in = io->in;
+        io->shown_read_time = io->read_time;
+        io->shown_decode_time = io->decode_time;
+        pthread_cond_signal(&io->filled);
+        pthread_mutex_unlock(&io->lock);
+
+        if (n <= 0) {
+            break;
+        }
+        slot = (slot + 1) % io->depth;
+    }
+
+    return NULL;
+}
+
+#if defined(JSMN_IO_URING)
+/**
+ * Sets up a ring with an entry for each block.
+ */
+static int jsmn_uring_setup(struct jsmn_reader_io *io)
+{
+    struct io_uring_params p;
+    size_t sq_size, cq_size;
+    char *map;
+
+    memset(&p, 0, sizeof(p));
+    io->ring = (int)syscall(__NR_io_uring_setup, (unsigned)io->depth, &p);
+    if (io->ring < 0) {
+        return -1;
+    }
+    /* One mapping for both rings needs Linux 5.4, reads need 5.6 */
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        close(io->ring);
+        return -1;
+    }
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    io->ring_size = (sq_size > cq_size ? sq_size : cq_size);
+    io->ring_map = mmap(NULL, io->ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, io->ring, IORING_OFF_SQ_RING);
+    if (io->ring_map == MAP_FAILED) {
+        close(io->ring);
+        return -1;
+    }
+    io->sq_entries = p.sq_entries;
+    io->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, io->ring, IORING_OFF_SQES);
+    if (io->sqes == MAP_FAILED) {
+        munmap(io->ring_map, io->ring_size);
+        close(io->ring);
+        return -1;
+    }
+
+    map = io->ring_map;
+    io->sq_tail = (unsigned *)(map + p.sq_off.tail);
+    io->sq_mask = (unsigned *)(map + p.sq_off.ring_mask);
+    io->sq_array = (unsigned *)(map + p.sq_off.array);
+    io->cq_head = (unsigned *)(map + p.cq_off.head);
+    io->cq_tail = (unsigned *)(map + p.cq_off.tail);
+    io->cq_mask = (unsigned *)(map + p.cq_off.ring_mask);
+    io->cqes = (struct io_uring_cqe *)(map + p.cq_off.cqes);
+
+    return 0;
+}
+
+/**
+ * Queues the read of the next stretch of the file into a block.
+ */
+static int jsmn_uring_queue(struct jsmn_reader_io *io, const int slot)
+{
+    struct io_uring_sqe *sqe;
+    unsigned tail, index;
+
+    io->full[slot] = 0;
+    io->start[slot] = io->offset;
+    io->want[slot] = 0;
+    if (io->offset >= io->size) {
+        return 0;
+    }
+    io->want[slot] = ((off_t)io->block_size < io->size - io->offset ?
+                      io->block_size : (size_t)(io->size - io->offset));
+    io->offset += io->want[slot];
+
+    tail = *io->sq_tail;
+    index = tail & *io->sq_mask;
+    sqe = &io->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = io->fd;
+    sqe->addr = (unsigned long)(io->blocks + slot * io->block_size);
+    sqe->len = (unsigned)io->want[slot];
+    sqe->off = (unsigned long long)io->start[slot];
+    sqe->user_data = (unsigned long long)slot;
+    io->sq_array[index] = index;
+    __atomic_store_n(io->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    if (syscall(__NR_io_uring_enter, io->ring, 1, 0, 0, NULL, 0) < 0) {
+        /* Nothing was submitted, so there is no read to wait for */
+        __atomic_store_n(io->sq_tail, tail, __ATOMIC_RELEASE);
+        io->want[slot] = 0;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Waits until the read of a block has finished, -errno if the ring can't be
+ * waited on, the read is then still in flight.
+ */
+static int jsmn_uring_wait(struct jsmn_reader_io *io, const int slot)
+{
+    struct io_uring_cqe *cqe;
+    unsigned head;
+
+    while (!io->full[slot]) {
+        head = *io->cq_head;
+        if (head == __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE)) {
+            if (syscall(__NR_io_uring_enter, io->ring, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+                errno != EINTR) {
+                return -errno;
+            }
+            continue;
+        }
+        /* Reads may finish in any order */
+        while (head != __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE)) {
+            cqe = &io->cqes[head & *io->cq_mask];
+            io->done[cqe->user_data] = cqe->res;
+            io->full[cqe->user_data] = 1;
+            head++;
+        }
+        __atomic_store_n(io->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+#endif
+
+/**
+ * Makes room in js for n more bytes.
+ */
+static int jsmn_reader_grow(jsmn_reader *rd, const size_t n)
+{
+    size_t cap = (rd->cap != 0 ? rd->cap : n);
+    char *js;
+
+    if (rd->len + n <= rd->cap) {
+        return 0;
+    }
+    while (cap < rd->len + n) {
+        cap *= 2;
+    }
+    js = realloc(rd->js, cap);
+    if (js == NULL) {
+        return -1;
+    }
+    rd->js = js;
+    rd->cap = cap;
+    return 0;
+}
+
+/**
+ * Allocates the blocks.
+ */
+static struct jsmn_reader_io *jsmn_reader_alloc(jsmn_reader *rd, const int fd,
+                                                const size_t block_size, const int depth)
+{
+    struct jsmn_reader_io *io;
+
+    memset(rd, 0, sizeof(*rd));
+    if (depth < 1 || depth > JSMN_READER_DEPTH || block_size == 0) {
+        return NULL;
+    }
+
+    io = calloc(1, sizeof(*io));
+    if (io == NULL) {
+        return NULL;
+    }
+    io->fd = fd;
+    io->block_size = block_size;
+    io->depth = depth;
+    io->format = JSMN_READ_PLAIN;
+    io->blocks = malloc(depth * block_size);
+    if (io->blocks == NULL) {
+        free(io);
+        return NULL;
+    }
+    rd->io = io;
+    return io;
+}
+
+/**
+ * Starts the reader thread.
+ */
+static int jsmn_reader_start(jsmn_reader *rd)
+{
+    struct jsmn_reader_io *io = rd->io;
+
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_cond_init(&io->filled, NULL);
+    pthread_cond_init(&io->emptied, NULL);
+    if (pthread_create(&io->thread, NULL, jsmn_reader_thread, io) != 0) {
+        pthread_cond_destroy(&io->emptied);
+        pthread_cond_destroy(&io->filled);
+        pthread_mutex_destroy(&io->lock);
+        free(io->input);
+        free(io->blocks);
+        free(io);
+        rd->io = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+JSMN_EXPORT
+int jsmn_reader_open(jsmn_reader *rd, const int fd, const size_t block_size, const int depth)
+{
+    struct jsmn_reader_io *io = jsmn_reader_alloc(rd, fd, block_size, depth);
+
+    if (io == NULL) {
+        return -1;
+    }
+    rd->format = JSMN_READ_PLAIN;
+
+#if defined(JSMN_IO_URING)
+    /* Reads at an offset only make sense on a regular file */
+    {
+        struct stat st;
+        int i;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && jsmn_uring_setup(io) == 0) {
+            io->size = st.st_size;
+            io->offset = lseek(fd, 0, SEEK_CUR);
+            if (io->offset < 0) {
+                io->offset = 0;
+            }
+            rd->uring = 1;
+            for (i = 0; i < depth; i++) {
+                if (jsmn_uring_queue(io, i) != 0) {
+                    jsmn_reader_close(rd);
+                    return -1;
+                }
+            }
+            return 0;
+        }
+    }
+#endif
+
+    return jsmn_reader_start(rd);
+}
+
+JSMN_EXPORT
+int jsmn_reader_open_compressed(jsmn_reader *rd, const int fd, const jsmn_compression format,
+                                const size_t block_size, const int depth)
+{
+    struct jsmn_reader_io *io;
+
+    switch (format) {
+    case JSMN_READ_AUTO:
+    case JSMN_READ_PLAIN:
+#if defined(JSMN_HAVE_ZLIB)
+    case JSMN_READ_GZIP:
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+    case JSMN_READ_ZSTD:
+#endif
+        break;
+    default:
+        memset(rd, 0, sizeof(*rd));
+        return -1;
+    }
+
+    io = jsmn_reader_alloc(rd, fd, block_size, depth);
+    if (io == NULL) {
+        return -1;
+    }
+    io->format = format;
+    io->input = malloc(block_size);
+    if (io->input == NULL) {
+        free(io->blocks);
+        free(io);
+        rd->io = NULL;
+        return -1;
+    }
+
+    return jsmn_reader_start(rd);
+}
+
+JSMN_EXPORT
+long jsmn_reader_fill(jsmn_reader *rd)
+{
+    struct jsmn_reader_io *io = rd->io;
+    const int slot = io->next;
+    const char *block = io->blocks + slot * io->block_size;
+    double start;
+    long n;
+
+    if (rd->eof) {
+        return 0;
+    }
+    if (rd->error) {
+        return -1;
+    }
+
+    start = jsmn_reader_now();
+#if defined(JSMN_IO_URING)
+    if (rd->uring) {
+        if (io->want[slot] == 0) {
+            rd->eof = 1;
+            return 0;
+        }
+        n = jsmn_uring_wait(io, slot);
+        if (n == 0) {
+            n = io->done[slot];
+        }
+        /* Finish a short read in place */
+        while (n >= 0 && (size_t)n < io->want[slot]) {
+            long more = (long)pread(io->fd, (char *)block + n, io->want[slot] - n, io->start[slot] + n);
+            if (more < 0 && errno == EINTR) {
+                continue;
+            }
+            if (more <= 0) {
+                n = (more < 0 ? -errno : n);
+                break;
+            }
+            n += more;
+        }
+        rd->in += (n > 0 ? n : 0);
+    } else
+#endif
+    {
+        pthread_mutex_lock(&io->lock);
+        while (!io->full[slot]) {
+            pthread_cond_wait(&io->filled, &io->lock);
+        }
+        n = io->done[slot];
+        rd->format = io->format;
+        rd->in = io->shown_in;
+        rd->read_time = io->shown_read_time;
+        rd->decode_time = io->shown_decode_time;
+        pthread_mutex_unlock(&io->lock);
+    }
+    rd->wait += jsmn_reader_now() - start;
+
+    if (n < 0) {
+        rd->error = (int)-n;
+        return -1;
+    }
+    if (n == 0) {
+        rd->eof = 1;
+        return 0;
+    }
+    if (jsmn_reader_grow(rd, (size_t)n) != 0) {
+        rd->error = ENOMEM;
+        return -1;
+    }
+    memcpy(rd->js + rd->len, block, (size_t)n);
+    rd->len += (size_t)n;
+
+    /* Hand the block back for the next read */
+#if defined(JSMN_IO_URING)
+    if (rd->uring) {
+        if (jsmn_uring_queue(io, slot) != 0) {
+            rd->error = errno;
+        }
+    } else
+#endif
+    {
+        pthread_mutex_lock(&io->lock);
+        io->full[slot] = 0;
+        pthread_cond_signal(&io->emptied);
+        pthread_mutex_unlock(&io->lock);
+    }
+    io->next = (slot + 1) % io->depth;
+
+    return n;
+}
+
+JSMN_EXPORT
+void jsmn_reader_drop(jsmn_reader *rd, const size_t n)
+{
+    const size_t drop = (n < rd->len ? n : rd->len);
+    memmove(rd->js, rd->js + drop, rd->len - drop);
+    rd->len -= drop;
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_reader_parse(jsmn_reader *rd, jsmn_parser *parser,
+                            jsmntokens_t *tokens, const size_t num_tokens)
+{
+    jsmnint_t r;
+
+    for (;;) {
+        r = jsmn_parse(parser, rd->js, rd->len, tokens, num_tokens);
+        if (rd->eof || !jsmn_parse_more(parser, r, rd->len)) {
+            return r;
+        }
+
+        if (jsmn_reader_fill(rd) < 0) {
+            return JSMN_ERROR_INVAL;
+        }
+    }
+}
+
+JSMN_EXPORT
+void jsmn_reader_close(jsmn_reader *rd)
+{
+    struct jsmn_reader_io *io = rd->io;
+
+    if (io != NULL) {
+#if defined(JSMN_IO_URING)
+        if (rd->uring) {
+            int i;
+            /* The blocks are freed below, let the reads in flight finish */
+            for (i = 0; i < io->depth; i++) {
+                if (io->want[i] != 0 && jsmn_uring_wait(io, i) != 0) {
+                    /* The kernel may still write to them, better leak them */
+                    io->blocks = NULL;
+                    break;
+                }
+            }
+            munmap(io->sqes, io->sq_entries * sizeof(struct io_uring_sqe));
+            munmap(io->ring_map, io->ring_size);
+            close(io->ring);
+        } else
+#endif
+        {
+            pthread_mutex_lock(&io->lock);
+            io->stop = 1;
+            pthread_cond_signal(&io->emptied);
+            pthread_mutex_unlock(&io->lock);
+            pthread_cancel(io->thread);
+            pthread_join(io->thread, NULL);
+            pthread_cond_destroy(&io->emptied);
+            pthread_cond_destroy(&io->filled);
+            pthread_mutex_destroy(&io->lock);
+        }
+#if defined(JSMN_HAVE_ZLIB)
+        if (io->decoder && io->format == JSMN_READ_GZIP) {
+            inflateEnd(&io->gzip);
+        }
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+        if (io->decoder && io->format == JSMN_READ_ZSTD) {
+            ZSTD_freeDStream(io->zstd);
+        }
+#endif
+        free(io->input);
+        free(io->blocks);
+        free(io);
+    }
+
+    free(rd->js);
+    memset(rd, 0, sizeof(*rd));
+}
@@ -0,0 +1,137 @@
+#ifndef JSMN_READER_H_
+#define JSMN_READER_H_
+
+#include <stddef.h>
+
+#include "jsmn_defines.h"
+
+#define JSMN_HEADER
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(JSMN_READER_DEPTH)
+/*! Most blocks a jsmn_reader keeps in flight */
+# define JSMN_READER_DEPTH 8
+#endif
+
+/**
+ * Formats jsmn_reader_open_compressed can read
+ */
+typedef enum {
+  JSMN_READ_AUTO = 0,           /*!< tell from the first bytes, plain if neither below */
+  JSMN_READ_PLAIN = 1,          /*!< not compressed */
+  JSMN_READ_GZIP = 2,           /*!< gzip or zlib, needs JSMN_HAVE_ZLIB */
+  JSMN_READ_ZSTD = 3,           /*!< zstd, needs JSMN_HAVE_ZSTD */
+} jsmn_compression;
+
+/**
+ * Reads a file or pipe ahead of the parser
+ *
+ * Up to depth blocks are read in the background, with io_uring for regular
+ *   files on Linux and with a reader thread otherwise, while the blocks
+ *   already read are parsed. js holds the input from the start of the
+ *   document (or from what jsmn_reader_drop left) to the end of the last
+ *   block taken.
+ */
+typedef struct jsmn_reader {
+  char *js;                     /*!< input taken so far and not dropped */
+  size_t len;                   /*!< bytes in js */
+  size_t cap;                   /*!< size of the js allocation */
+  int eof;                      /*!< the end of the input has been taken */
+  int error;                    /*!< errno of a failed read, 0 if none */
+  int uring;                    /*!< blocks are read with io_uring rather than a thread */
+  jsmn_compression format;      /*!< compression of the input, known once a block is taken */
+  double wait;                  /*!< seconds spent waiting for a block */
+  unsigned long long in;        /*!< bytes read from the file descriptor so far */
+  double read_time;             /*!< seconds the reader thread has spent reading */
+  double decode_time;           /*!< seconds the reader thread has spent decompressing */
+  struct jsmn_reader_io *io;    /*!< blocks in flight */
+} jsmn_reader;
+
+/**
+ * @brief Start reading ahead from a file descriptor
+ *
+ * @param[out] rd Reader to set up, release with jsmn_reader_close()
+ * @param[in] fd File or pipe open for reading, left open
+ * @param[in] block_size Size of each read
+ * @param[in] depth Number of blocks in flight, at most JSMN_READER_DEPTH
+ * @return 0 on success, -1 when out of memory or threads
+ */
+int jsmn_reader_open(jsmn_reader *rd, const int fd, const size_t block_size, const int depth);
+
+/**
+ * @brief Start decompressing from a file descriptor
+ *
+ * A thread reads the compressed input and decompresses it into the blocks
+ *   while the blocks already decompressed are parsed; concatenated gzip
+ *   members and zstd frames are read one after the other, as in rotated log
+ *   archives. The decoders are optional, built with JSMN_HAVE_ZLIB and
+ *   JSMN_HAVE_ZSTD.
+ *
+ * @param[out] rd Reader to set up, release with jsmn_reader_close()
+ * @param[in] fd File or pipe open for reading, left open
+ * @param[in] format Compression of the input
+ * @param[in] block_size Size of each decompressed block
+ * @param[in] depth Number of blocks in flight, at most JSMN_READER_DEPTH
+ * @return 0 on success, -1 when out of memory or threads, or if format is
+ *         not built in
+ */
+int jsmn_reader_open_compressed(jsmn_reader *rd, const int fd, const jsmn_compression format,
+                                const size_t block_size, const int depth);
+
+/**
+ * @brief Append the next block to js
+ *
+ * Waits for the block if it is not there yet, and queues another read in its
+ *   place.
+ *
+ * @param[in,out] rd Reader
+ * @return long bytes appended, 0 at the end of the input, -1 on a read or
+ *         decompression error (see rd->error) or when out of memory
+ */
+long jsmn_reader_fill(jsmn_reader *rd);
+
+/**
+ * @brief Drop input from the front of js
+ *
+ * Use with the number of bytes jsmn_slide() dropped, so a stream larger than
+ *   memory can be parsed with JSMN_WINDOW.
+ *
+ * @param[in,out] rd Reader
+ * @param[in] n Number of bytes to drop
+ */
+void jsmn_reader_drop(jsmn_reader *rd, const size_t n);
+
+/**
+ * @brief Run jsmn_parse over the input as it is read
+ *
+ * Parses what has been taken so far, and takes another block whenever
+ *   jsmn_parse needs more input (JSMN_ERROR_PART, a number at the end of the
+ *   input, or more documents with JSMN_MULTIPLE_JSON), so reading and parsing
+ *   overlap. After JSMN_ERROR_NOMEM call again with more tokens.
+ *
+ * @param[in,out] rd Reader
+ * @param[in,out] parser jsmn parser, initialized
+ * @param[out] tokens Tokens or NULL
+ * @param[in] num_tokens Number of Tokens
+ * @return jsmnint_t number of tokens found or ERRNO, JSMN_ERROR_INVAL on a
+ *         read error
+ */
+jsmnint_t jsmn_reader_parse(jsmn_reader *rd, jsmn_parser *parser,
+                            jsmntokens_t *tokens, const size_t num_tokens);
+
+/**
+ * @brief Stop reading and release the reader
+ *
+ * @param[in,out] rd Reader
+ */
+void jsmn_reader_close(jsmn_reader *rd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_READER_H_ */
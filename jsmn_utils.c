@@ -1,3 +1,11 @@
+#if defined(__unix__) || defined(__APPLE__)
+/* mmap, madvise and their flags */
+# define _DEFAULT_SOURCE
+# if !defined(JSMN_NO_MMAP)
+#  define JSMN_MMAP
+# endif
+#endif
+
 #include "jsmn_utils.h"
 
 #ifdef UNIT_TESTING
@@ -11,6 +19,17 @@
 #include <stdarg.h>
 #include <stdint.h>
 
+#if defined(JSMN_MMAP)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 JSMN_EXPORT
 const char *jsmn_strerror(jsmnerr errno)
 {
@@ -27,16 +46,141 @@ const char *jsmn_strerror(jsmnerr errno)
             return "The string is not a full JSON packet, more bytes expected.";
         case JSMN_ERROR_BRACKETS:
             return "The JSON string has unmatched brackets.";
+#if defined(JSMN_STEPS)
+        case JSMN_ERROR_YIELD:
+            return "The step is over, call again to go on.";
+#endif
     }
 
     return NULL;
 }
 
+#if defined(JSMN_BLOCK_TOKENS)
+JSMN_EXPORT
+int jsmn_tokens_grow(jsmntok_blocks_t *tokens)
+{
+    jsmntok_t **blocks = realloc(tokens->blocks, (tokens->num_blocks + 1) * sizeof(*blocks));
+    if (blocks == NULL) {
+        return 0;
+    }
+    tokens->blocks = blocks;
+
+    blocks[tokens->num_blocks] = malloc(JSMN_BLOCK_SIZE * sizeof(jsmntok_t));
+    if (blocks[tokens->num_blocks] == NULL) {
+        return 0;
+    }
+    tokens->num_blocks++;
+
+    return 1;
+}
+#endif
+
+JSMN_EXPORT
+jsmntokens_t *jsmn_tokens_alloc(const size_t num_tokens)
+{
+#if defined(JSMN_BLOCK_TOKENS)
+    jsmntok_blocks_t *tokens = calloc(1, sizeof(jsmntok_blocks_t));
+    if (tokens == NULL) {
+        return NULL;
+    }
+    tokens->grow = jsmn_tokens_grow;
+
+    while ((tokens->num_blocks << JSMN_BLOCK_SHIFT) < num_tokens) {
+        if (!jsmn_tokens_grow(tokens)) {
+            jsmn_tokens_free(tokens);
+            return NULL;
+        }
+    }
+
+    return tokens;
+#elif !defined(JSMN_SOA_TOKENS)
+    return calloc(num_tokens, sizeof(jsmntok_t));
+#else
+    size_t fields = 3;
+# if defined(JSMN_PAIR_TOKENS)
+    fields += 2;
+# endif
+# if defined(JSMN_PARENT_LINKS)
+    fields++;
+# endif
+# if defined(JSMN_NEXT_SIBLING)
+    fields++;
+# endif
+# if defined(JSMN_COMPACT_ARRAYS)
+    fields++;
+# endif
+
+    /* descriptor, then types, then every jsmnint_t array back to back */
+    jsmntok_soa_t *tokens = calloc(1, sizeof(jsmntok_soa_t) +
+                                      num_tokens * (sizeof(jsmntype_t) + fields * sizeof(jsmnint_t)));
+    if (tokens == NULL) {
+        return NULL;
+    }
+
+    jsmnint_t *field = (jsmnint_t *)((jsmntype_t *)(tokens + 1) + num_tokens);
+    tokens->types = (jsmntype_t *)(tokens + 1);
+    tokens->starts = field; field += num_tokens;
+    tokens->ends = field; field += num_tokens;
+    tokens->sizes = field; field += num_tokens;
+# if defined(JSMN_PAIR_TOKENS)
+    tokens->key_starts = field; field += num_tokens;
+    tokens->key_ends = field; field += num_tokens;
+# endif
+# if defined(JSMN_PARENT_LINKS)
+    tokens->parents = field; field += num_tokens;
+# endif
+# if defined(JSMN_NEXT_SIBLING)
+    tokens->siblings = field; field += num_tokens;
+# endif
+# if defined(JSMN_COMPACT_ARRAYS)
+    tokens->elements = field;
+# endif
+
+    return tokens;
+#endif
+}
+
+JSMN_EXPORT
+void jsmn_tokens_free(jsmntokens_t *tokens)
+{
+#if defined(JSMN_BLOCK_TOKENS)
+    if (tokens == NULL) {
+        return;
+    }
+
+    size_t i;
+    for (i = 0; i < tokens->num_blocks; i++) {
+        free(tokens->blocks[i]);
+    }
+    free(tokens->blocks);
+#endif
+    free(tokens);
+}
+
 JSMN_EXPORT
-jsmntok_t *jsmn_tokenize(const char *json, const size_t json_len, jsmnint_t *rv)
+jsmntokens_t *jsmn_tokenize(const char *json, const size_t json_len, jsmnint_t *rv)
 {
     jsmn_parser p;
 
+#if defined(JSMN_BLOCK_TOKENS)
+    /* Blocks are appended as needed, so a single pass is enough */
+    jsmntokens_t *tokens = jsmn_tokens_alloc(0);
+    if (tokens == NULL) {
+        *rv = (jsmnint_t)JSMN_ERROR_NOMEM;
+        return NULL;
+    }
+
+    jsmn_init(&p);
+    *rv = jsmn_parse(&p, json, json_len, tokens, (size_t)-1);
+
+    if (*rv >= (jsmnint_t)JSMN_ERROR_MAX) {
+        fprintf(stderr, "jsmn_parse error: %s\n", jsmn_strerror(*rv));
+        jsmn_tokens_free(tokens);
+        return NULL;
+    }
+
+    return tokens;
+#else
     jsmn_init(&p);
     *rv = jsmn_parse(&p, json, json_len, NULL, 0);
 
@@ -48,16 +192,17 @@ jsmntok_t *jsmn_tokenize(const char *json, const size_t json_len, jsmnint_t *rv)
 
 /*  fprintf(stderr, "jsmn_parse: %d tokens found.\n", *rv); */
 
-    jsmntok_t *tokens = calloc(*rv, sizeof(jsmntok_t));
+    jsmntokens_t *tokens = jsmn_tokens_alloc(*rv);
 
     jsmn_init(&p);
     *rv = jsmn_parse(&p, json, json_len, tokens, *rv);
 
     return tokens;
+#endif
 }
 
 JSMN_EXPORT
-jsmnint_t jsmn_tokenize_noalloc(jsmntok_t *tokens, const uint32_t num_tokens, const char *json, const size_t json_len)
+jsmnint_t jsmn_tokenize_noalloc(jsmntokens_t *tokens, const uint32_t num_tokens, const char *json, const size_t json_len)
 {
     jsmn_parser p;
     jsmn_init(&p);
@@ -87,18 +232,42 @@ int jsmn_streq(const char *json, const jsmntok_t *tok, const char *s)
     return -1;
 }
 
+#if !defined(JSMN_PAIR_TOKENS)
+static
+int jsmn_streq_id(const char *json, const jsmntokens_t *tokens, const jsmnint_t t, const char *s)
+{
+    jsmnint_t len = JSMN_TOK_END(tokens, t) - JSMN_TOK_START(tokens, t);
+    if ((JSMN_TOK_TYPE(tokens, t) & JSMN_STRING) && strlen(s) == len &&
+            strncmp(json + JSMN_TOK_START(tokens, t), s, len) == 0) {
+        return JSMN_SUCCESS;
+    }
+    return -1;
+}
+#else
+static
+int jsmn_keyeq_id(const char *json, const jsmntokens_t *tokens, const jsmnint_t t, const char *s)
+{
+    jsmnint_t len = JSMN_TOK_KEY_END(tokens, t) - JSMN_TOK_KEY_START(tokens, t);
+    if ((JSMN_TOK_TYPE(tokens, t) & JSMN_INSD_OBJ) && strlen(s) == len &&
+            strncmp(json + JSMN_TOK_KEY_START(tokens, t), s, len) == 0) {
+        return JSMN_SUCCESS;
+    }
+    return -1;
+}
+#endif
+
 JSMN_EXPORT
-jsmnint_t jsmn_get_prev_sibling(const jsmntok_t *tokens, const jsmnint_t t)
+jsmnint_t jsmn_get_prev_sibling(const jsmntokens_t *tokens, const jsmnint_t t)
 {
 #if defined(JSMN_NEXT_SIBLING) && defined(JSMN_PARENT_LINKS)
     jsmnint_t sibling;
 
     /* Start with parent's first child */
-    if (tokens[t].parent == JSMN_NEG) {
+    if (JSMN_TOK_PARENT(tokens, t) == JSMN_NEG) {
         return JSMN_NEG;
     }
 
-    sibling = tokens[t].parent + 1;
+    sibling = JSMN_TOK_PARENT(tokens, t) + 1;
 
     /* If the first child is the current token */
     if (sibling == t) {
@@ -106,36 +275,36 @@ jsmnint_t jsmn_get_prev_sibling(const jsmntok_t *tokens, const jsmnint_t t)
     }
 
     /* Loop until we find previous sibling */
-    while (tokens[sibling].next_sibling != t) {
-        sibling = tokens[sibling].next_sibling;
+    while (JSMN_TOK_NEXT_SIBLING(tokens, sibling) != t) {
+        sibling = JSMN_TOK_NEXT_SIBLING(tokens, sibling);
     }
 
     return sibling;
 #else
     jsmnint_t remaining, sibling = t;
     for (remaining = JSMN_NEG; remaining != 1 && sibling != JSMN_NEG; remaining++, sibling--) {
-        remaining -= tokens[sibling]->size;
+        remaining -= JSMN_TOK_SIZE(tokens, sibling);
     }
     return sibling;
 #endif
 }
 
 JSMN_EXPORT
-jsmnint_t jsmn_get_next_sibling(const jsmntok_t *tokens, const jsmnint_t t)
+jsmnint_t jsmn_get_next_sibling(const jsmntokens_t *tokens, const jsmnint_t t)
 {
 #if defined(JSMN_NEXT_SIBLING)
-    return tokens[t].next_sibling;
+    return JSMN_TOK_NEXT_SIBLING(tokens, t);
 #else
     jsmnint_t remaining, sibling = t;
     for (remaining = 1; remaining != JSMN_NEG; remaining--, sibling++) {
-        remaining += tokens[sibling]->size;
+        remaining += JSMN_TOK_SIZE(tokens, sibling);
     }
     return sibling;
 #endif
 }
 
 static
-jsmnint_t jsmn_lookup_object(const char *json, const jsmntok_t *tokens, const jsmnint_t parent, const char *key)
+jsmnint_t jsmn_lookup_object(const char *json, const jsmntokens_t *tokens, const jsmnint_t parent, const char *key)
 {
     /* first child is the first token after the parent */
     jsmnint_t child = parent + 1;
@@ -143,7 +312,11 @@ jsmnint_t jsmn_lookup_object(const char *json, const jsmntok_t *tokens, const js
     /* loop through children */
     while (child != JSMN_NEG) {
         /* if child's string is equal to key */
-        if (jsmn_streq(json, &tokens[child], key) == JSMN_SUCCESS) {
+#if !defined(JSMN_PAIR_TOKENS)
+        if (jsmn_streq_id(json, tokens, child, key) == JSMN_SUCCESS) {
+#else
+        if (jsmn_keyeq_id(json, tokens, child, key) == JSMN_SUCCESS) {
+#endif
             /* return current child */
             return child;
         }
@@ -157,10 +330,10 @@ jsmnint_t jsmn_lookup_object(const char *json, const jsmntok_t *tokens, const js
 }
 
 static
-jsmnint_t jsmn_lookup_array(const jsmntok_t *tokens, const jsmnint_t parent, const jsmnint_t key)
+jsmnint_t jsmn_lookup_array(const jsmntokens_t *tokens, const jsmnint_t parent, const jsmnint_t key)
 {
     /* if parent's children is less than or equal to key, key is bad */
-    if (tokens[parent].size <= key)
+    if (JSMN_TOK_SIZE(tokens, parent) <= key)
         return JSMN_NEG;
 
     /* first child is the first token after the parent */
@@ -175,7 +348,7 @@ jsmnint_t jsmn_lookup_array(const jsmntok_t *tokens, const jsmnint_t parent, con
 }
 
 JSMN_EXPORT
-jsmnint_t jsmn_lookup(const char *json, const jsmntok_t *tokens, const size_t num_keys, ...)
+jsmnint_t jsmn_lookup(const char *json, const jsmntokens_t *tokens, const size_t num_keys, ...)
 {
     jsmnint_t i, pos;
 
@@ -186,15 +359,29 @@ jsmnint_t jsmn_lookup(const char *json, const jsmntok_t *tokens, const size_t nu
     /* start at position zero */
     pos = 0;
     for (i = 0; i < num_keys; i++) {
-        if (tokens[pos].type & JSMN_OBJECT) {
+#if defined(JSMN_LAZY_TOKENS)
+        /* children of an unexpanded token are not in tokens */
+        if (JSMN_TOK_TYPE(tokens, pos) & JSMN_UNEXPANDED) {
+            pos = JSMN_NEG;
+            break;
+        }
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+        /* neither are the elements of a compact array */
+        if (JSMN_TOK_TYPE(tokens, pos) & JSMN_COMPACT) {
+            pos = JSMN_NEG;
+            break;
+        }
+#endif
+        if (JSMN_TOK_TYPE(tokens, pos) & JSMN_OBJECT) {
             /* if `pos`.type is an object, treat key as a const char * */
             pos = jsmn_lookup_object(json, tokens, pos, va_arg(keys, void *));
             if (pos == JSMN_NEG) { break; }
             /* move position to current key's value (with check) */
-            if (tokens[pos].type & JSMN_KEY) {
+            if (JSMN_TOK_TYPE(tokens, pos) & JSMN_KEY) {
                 pos++;
             }
-        } else if (tokens[pos].type & JSMN_ARRAY) {
+        } else if (JSMN_TOK_TYPE(tokens, pos) & JSMN_ARRAY) {
             /* if `pos`.type is an array, treat key as a jsmnint_t (by way of uintptr_t) */
             pos = jsmn_lookup_array(tokens, pos, (uintptr_t)va_arg(keys, void *));
         } else {
@@ -213,14 +400,1013 @@ jsmnint_t jsmn_lookup(const char *json, const jsmntok_t *tokens, const size_t nu
     return pos;
 }
 
+/* Decimal form of a JSON number, mantissa holds up to 19 significant digits */
+typedef struct jsmn_decimal {
+    uint64_t mantissa;
+    int digits;                 /* significant digits in mantissa */
+    int exponent;               /* power of ten mantissa is scaled by */
+    jsmnbool negative;
+    jsmnbool integer;           /* no fraction or exponent */
+    jsmnbool truncated;         /* digits were dropped from mantissa */
+} jsmn_decimal;
+
+#define JSMN_DECIMAL_DIGITS 19
+
+/* 8 bytes of s with s[0] in the low byte, whatever the host's byte order */
+static
+uint64_t jsmn_load8(const char *s)
+{
+    uint64_t word = 0;
+    int i;
+    for (i = 7; i >= 0; i--) {
+        word = word << 8 | (unsigned char)s[i];
+    }
+    return word;
+}
+
+/* Nonzero if every byte of word is '0' - '9' */
+static
+int jsmn_eight_digits(const uint64_t word)
+{
+    return (word & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL &&
+           ((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL;
+}
+
+/* Value of 8 digits loaded with jsmn_load8, combining pairs, then quads, then halves */
+static
+uint32_t jsmn_eight_digits_value(uint64_t word)
+{
+    word -= 0x3030303030303030ULL;
+    word = (word * 10) + (word >> 8);
+    word = (((word & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+            (((word >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return (uint32_t)word;
+}
+
+/**
+ * Read a run of digits into d, 8 at a time while the mantissa has room.
+ *   Fraction digits scale the exponent down, dropped integer digits scale it up.
+ */
+static
+const char *jsmn_decimal_digits(const char *p, const char *end, jsmn_decimal *d, const jsmnbool fraction)
+{
+    while (end - p >= 8 && d->digits + 8 <= JSMN_DECIMAL_DIGITS && jsmn_eight_digits(jsmn_load8(p))) {
+        d->mantissa = d->mantissa * 100000000 + jsmn_eight_digits_value(jsmn_load8(p));
+        if (d->mantissa != 0) {
+            d->digits += 8;
+        }
+        if (fraction) {
+            d->exponent -= 8;
+        }
+        p += 8;
+    }
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (d->digits < JSMN_DECIMAL_DIGITS) {
+            d->mantissa = d->mantissa * 10 + (*p - '0');
+            if (d->mantissa != 0) {
+                d->digits++;
+            }
+            if (fraction) {
+                d->exponent--;
+            }
+        } else {
+            if (*p != '0') {
+                d->truncated = JSMN_TRUE;
+            }
+            if (!fraction) {
+                d->exponent++;
+            }
+        }
+    }
+    return p;
+}
+
+/**
+ * Scan a JSON number at p into d
+ *
+ * @return the character after the number, NULL if p isn't a number
+ */
+static
+const char *jsmn_decimal_scan(const char *p, const char *end, jsmn_decimal *d)
+{
+    const char *digits;
+    int exponent = 0;
+
+    memset(d, 0, sizeof(*d));
+    d->integer = JSMN_TRUE;
+
+    if (p < end && *p == '-') {
+        d->negative = JSMN_TRUE;
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    if (*p == '0') {
+        p++;
+    } else {
+        p = jsmn_decimal_digits(p, end, d, JSMN_FALSE);
+    }
+
+    if (p < end && *p == '.') {
+        d->integer = JSMN_FALSE;
+        digits = ++p;
+        p = jsmn_decimal_digits(p, end, d, JSMN_TRUE);
+        if (p == digits) {
+            return NULL;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        jsmnbool negative = JSMN_FALSE;
+        d->integer = JSMN_FALSE;
+        p++;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+        for (digits = p; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (exponent < 100000) {
+                exponent = exponent * 10 + (*p - '0');
+            }
+        }
+        if (p == digits) {
+            return NULL;
+        }
+        d->exponent += negative ? -exponent : exponent;
+    }
+
+    return p;
+}
+
+/* Powers of ten that are exact as doubles */
+static const double jsmn_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* Significant digits passed on to strtod, enough to round any double correctly */
+#define JSMN_STRTOD_DIGITS 768
+
+/**
+ * strtod for the JSON number between s and end, whatever the locale. The
+ *   number is rewritten as an integer with an exponent, so no decimal point is
+ *   left for the locale to disagree on. Digits past JSMN_STRTOD_DIGITS only
+ *   matter in being zero or not, they become a single trailing 1 if not.
+ */
+static
+double jsmn_strtod(const char *s, const char *end)
+{
+    char buf[JSMN_STRTOD_DIGITS + 32];
+    long exponent = 0, e = 0;
+    size_t n = 0, digits = 0;
+    jsmnbool fraction = JSMN_FALSE, sticky = JSMN_FALSE, negative = JSMN_FALSE;
+
+    if (*s == '-') {
+        buf[n++] = *s++;
+    }
+    for (; s < end && *s != 'e' && *s != 'E'; s++) {
+        if (*s == '.') {
+            fraction = JSMN_TRUE;
+        } else if (digits == 0 && *s == '0') {
+            /* leading zeros are not significant */
+            if (fraction) {
+                exponent--;
+            }
+        } else if (digits < JSMN_STRTOD_DIGITS) {
+            buf[n++] = *s;
+            digits++;
+            if (fraction) {
+                exponent--;
+            }
+        } else {
+            if (*s != '0') {
+                sticky = JSMN_TRUE;
+            }
+            if (!fraction) {
+                exponent++;
+            }
+        }
+    }
+    if (digits == 0) {
+        buf[n++] = '0';
+    }
+    if (sticky) {
+        buf[n++] = '1';
+        exponent--;
+    }
+
+    if (s < end) {
+        s++;
+        if (*s == '-' || *s == '+') {
+            negative = (*s++ == '-');
+        }
+        for (; s < end && e < 100000; s++) {
+            e = e * 10 + (*s - '0');
+        }
+        exponent += negative ? -e : e;
+    }
+    snprintf(buf + n, sizeof(buf) - n, "e%ld", exponent);
+
+    return strtod(buf, NULL);
+}
+
+/**
+ * Convert the number between s and end, scanned into d, to a double. When the
+ *   mantissa and the power of ten are both exact the result is one correctly
+ *   rounded multiply or divide, anything else goes to jsmn_strtod.
+ */
+static
+double jsmn_decimal_double(const char *s, const char *end, const jsmn_decimal *d)
+{
+    double value;
+
+    if (d->truncated || d->mantissa > (1ULL << 53) ||
+            d->exponent < -22 || d->exponent > 22) {
+        return jsmn_strtod(s, end);
+    }
+
+    value = (double)d->mantissa;
+    if (d->exponent < 0) {
+        value /= jsmn_pow10[-d->exponent];
+    } else {
+        value *= jsmn_pow10[d->exponent];
+    }
+    return d->negative ? -value : value;
+}
+
+/**
+ * Decode the elements of an array token into doubles or int64_ts
+ */
+static
+jsmnint_t jsmn_array_to_numbers(const char *json, const jsmntokens_t *tokens, const jsmnint_t array,
+                                double *doubles, int64_t *ints, const size_t num_values, jsmnint_t *error)
+{
+    const char *p, *end, *number_end;
+    jsmn_decimal d;
+    jsmnint_t i = 0;
+    jsmnbool comma = JSMN_FALSE;
+
+    if (!(JSMN_TOK_TYPE(tokens, array) & JSMN_ARRAY) ||
+            JSMN_TOK_END(tokens, array) == JSMN_NEG) {
+        if (error != NULL) {
+            *error = 0;
+        }
+        return (jsmnint_t)JSMN_ERROR_INVAL;
+    }
+
+    /* the array's own text, between the brackets */
+    p = json + JSMN_TOK_START(tokens, array) + 1;
+    end = json + JSMN_TOK_END(tokens, array) - 1;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    while (p < end) {
+        const char *number = p;
+
+        p = number_end = jsmn_decimal_scan(p, end, &d);
+        if (p == NULL) {
+            break;
+        }
+        /* integers only, dropped digits show up as an exponent */
+        if (ints != NULL &&
+                (!d.integer || d.exponent != 0 ||
+                 d.mantissa > (uint64_t)INT64_MAX + d.negative)) {
+            p = NULL;
+            break;
+        }
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            p++;
+        }
+        if (p < end && *p != ',') {
+            p = NULL;
+            break;
+        }
+
+        if (i == num_values) {
+            return (jsmnint_t)JSMN_ERROR_NOMEM;
+        }
+        if (doubles != NULL) {
+            doubles[i] = jsmn_decimal_double(number, number_end, &d);
+        } else {
+            /* negate as unsigned, INT64_MIN has no positive counterpart */
+            ints[i] = d.negative ? (int64_t)(0 - d.mantissa) : (int64_t)d.mantissa;
+        }
+        i++;
+
+        comma = (p < end);
+        if (comma) {
+            p++;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+                p++;
+            }
+        }
+    }
+
+    /* a comma must be followed by another element */
+    if (p == NULL || (p == end && comma)) {
+        if (error != NULL) {
+            *error = i;
+        }
+        return (jsmnint_t)JSMN_ERROR_INVAL;
+    }
+    return i;
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_array_to_doubles(const char *json, const jsmntokens_t *tokens, const jsmnint_t array,
+                                double *values, const size_t num_values, jsmnint_t *error)
+{
+    return jsmn_array_to_numbers(json, tokens, array, values, NULL, num_values, error);
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_array_to_int64(const char *json, const jsmntokens_t *tokens, const jsmnint_t array,
+                              int64_t *values, const size_t num_values, jsmnint_t *error)
+{
+    return jsmn_array_to_numbers(json, tokens, array, NULL, values, num_values, error);
+}
+
+/* Packed token type byte: base type, key/value, inside object, primitive class */
+#define JSMN_PACK_KEY    0x04
+#define JSMN_PACK_VALUE  0x08
+#define JSMN_PACK_RAW    (JSMN_PACK_KEY | JSMN_PACK_VALUE)
+#define JSMN_PACK_INSD   0x10
+#define JSMN_PACK_SHIFT  5
+#define JSMN_PRI_FLAGS   (JSMN_PRI_LITERAL | JSMN_PRI_SIGN | JSMN_PRI_DECIMAL | JSMN_PRI_EXPONENT)
+
+static const jsmntype_t jsmn_pack_bases[] = {
+    JSMN_OBJECT, JSMN_ARRAY, JSMN_STRING, JSMN_PRIMITIVE,
+};
+
+static const jsmntype_t jsmn_pack_classes[] = {
+    JSMN_UNDEFINED, JSMN_PRI_LITERAL, JSMN_PRI_SIGN, JSMN_PRI_DECIMAL, JSMN_PRI_EXPONENT,
+    JSMN_PRI_SIGN | JSMN_PRI_DECIMAL, JSMN_PRI_SIGN | JSMN_PRI_EXPONENT, JSMN_PRI_DECIMAL | JSMN_PRI_EXPONENT,
+};
+
+/**
+ * Tokens that own children in the packed stream
+ */
+static
+jsmnbool jsmn_pack_has_children(const jsmntype_t type)
+{
+    if (type & (JSMN_CONTAINER | JSMN_KEY)) {
+        return JSMN_TRUE;
+    }
+    return JSMN_FALSE;
+}
+
+static
+unsigned char jsmn_pack_type(const jsmntype_t type)
+{
+    unsigned char base, kind;
+
+    if ((type & (JSMN_KEY | JSMN_VALUE)) == (JSMN_KEY | JSMN_VALUE) ||
+            (type & ~(JSMN_VAL_TYPE | JSMN_KEY | JSMN_VALUE | JSMN_INSD_OBJ | JSMN_PRI_FLAGS))) {
+        return JSMN_PACK_RAW;
+    }
+
+    for (base = 0; base < 4; base++) {
+        if ((type & JSMN_VAL_TYPE) == jsmn_pack_bases[base]) {
+            break;
+        }
+    }
+    for (kind = 0; kind < 8; kind++) {
+        if ((type & JSMN_PRI_FLAGS) == jsmn_pack_classes[kind]) {
+            break;
+        }
+    }
+    if (base == 4 || kind == 8) {
+        return JSMN_PACK_RAW;
+    }
+
+    return base | (type & JSMN_KEY ? JSMN_PACK_KEY : 0) | (type & JSMN_VALUE ? JSMN_PACK_VALUE : 0) |
+           (type & JSMN_INSD_OBJ ? JSMN_PACK_INSD : 0) | (kind << JSMN_PACK_SHIFT);
+}
+
+static
+size_t jsmn_varint_put(unsigned char *buf, size_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        buf[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (unsigned char)value;
+    return n;
+}
+
+static
+jsmnbool jsmn_varint_get(const unsigned char **pos, const unsigned char *end, size_t *value)
+{
+    unsigned int shift = 0;
+    *value = 0;
+    while (*pos < end && shift < sizeof(size_t) * CHAR_BIT) {
+        unsigned char b = *(*pos)++;
+        *value |= (size_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return JSMN_TRUE;
+        }
+        shift += 7;
+    }
+    return JSMN_FALSE;
+}
+
+JSMN_EXPORT
+size_t jsmn_pack_tokens(const jsmntokens_t *tokens, const jsmnint_t num_tokens,
+                        unsigned char *stream, const size_t stream_len)
+{
+    /* per token start delta, the open frames, and the finished subtrees */
+    struct subtree { jsmnint_t tokens; size_t bytes; } *subtrees;
+    jsmn_packed_frame *frames;
+    jsmnint_t *deltas;
+#if defined(JSMN_PAIR_TOKENS)
+    jsmnint_t *key_deltas;
+#endif
+    jsmnint_t i, depth, sp, base = 0;
+    size_t total = 0;
+
+    if (tokens == NULL || num_tokens == 0 || num_tokens == JSMN_NEG) {
+        return 0;
+    }
+
+#if !defined(JSMN_PAIR_TOKENS)
+    subtrees = malloc(num_tokens * (sizeof(*subtrees) + sizeof(*frames) + sizeof(*deltas)));
+#else
+    subtrees = malloc(num_tokens * (sizeof(*subtrees) + sizeof(*frames) + 2 * sizeof(*deltas)));
+#endif
+    if (subtrees == NULL) {
+        return 0;
+    }
+    frames = (jsmn_packed_frame *)(subtrees + num_tokens);
+    deltas = (jsmnint_t *)(frames + num_tokens);
+#if defined(JSMN_PAIR_TOKENS)
+    key_deltas = deltas + num_tokens;
+#endif
+
+    /* Walk forward to find what every start is relative to, all offsets in json */
+    for (i = 0, depth = 0; i < num_tokens; i++) {
+        jsmntype_t type = JSMN_TOK_TYPE(tokens, i);
+        jsmnint_t start = JSMN_TOK_START(tokens, i), end = JSMN_TOK_END(tokens, i);
+
+        while (depth > 0 && frames[depth - 1].remaining == 0) {
+            depth--;
+        }
+
+        if (start == JSMN_NEG || end == JSMN_NEG || end < start ||
+                (!jsmn_pack_has_children(type) && JSMN_TOK_SIZE(tokens, i) != 0)) {
+            goto error;
+        }
+
+        if (depth > 0) {
+#if defined(JSMN_PAIR_TOKENS)
+            /* the key sits between the previous sibling and the value */
+            if (type & JSMN_INSD_OBJ) {
+                jsmnint_t key_start = JSMN_TOK_KEY_START(tokens, i), key_end = JSMN_TOK_KEY_END(tokens, i);
+                if (key_start < frames[depth - 1].base || key_end < key_start || key_end == JSMN_NEG) {
+                    goto error;
+                }
+                key_deltas[i] = key_start - frames[depth - 1].base;
+                frames[depth - 1].base = key_end;
+            }
+#endif
+            if (start < frames[depth - 1].base) {
+                goto error;
+            }
+            deltas[i] = start - frames[depth - 1].base;
+            frames[depth - 1].remaining--;
+            frames[depth - 1].base = end;
+        } else {
+            if (start < base) {
+                goto error;
+            }
+            deltas[i] = start - base;
+            base = end;
+        }
+
+        if (JSMN_TOK_SIZE(tokens, i) > 0) {
+            frames[depth].id = i;
+            frames[depth].remaining = JSMN_TOK_SIZE(tokens, i);
+            frames[depth].base = (type & JSMN_CONTAINER) ? start : end;
+            depth++;
+        }
+    }
+    while (depth > 0 && frames[depth - 1].remaining == 0) {
+        depth--;
+    }
+    if (depth != 0) {
+        goto error;
+    }
+
+    /* Walk backward so every subtree is measured before its root is written */
+    for (i = num_tokens - 1, sp = 0; i != JSMN_NEG; i--) {
+        unsigned char record[64];
+        jsmntype_t type = JSMN_TOK_TYPE(tokens, i);
+        jsmnint_t size = JSMN_TOK_SIZE(tokens, i), j;
+        jsmnint_t desc_tokens = 0;
+        size_t desc_bytes = 0, n = 0;
+
+        if (size > sp) {
+            goto error;
+        }
+        for (j = 0; j < size; j++) {
+            sp--;
+            desc_tokens += subtrees[sp].tokens + 1;
+            desc_bytes += subtrees[sp].bytes;
+        }
+
+        record[n] = jsmn_pack_type(type);
+        if (record[n++] == JSMN_PACK_RAW) {
+            n += jsmn_varint_put(&record[n], type);
+        }
+#if defined(JSMN_PAIR_TOKENS)
+        if (type & JSMN_INSD_OBJ) {
+            n += jsmn_varint_put(&record[n], key_deltas[i]);
+            n += jsmn_varint_put(&record[n], JSMN_TOK_KEY_END(tokens, i) - JSMN_TOK_KEY_START(tokens, i));
+        }
+#endif
+        n += jsmn_varint_put(&record[n], deltas[i]);
+        n += jsmn_varint_put(&record[n], JSMN_TOK_END(tokens, i) - JSMN_TOK_START(tokens, i));
+        if (jsmn_pack_has_children(type)) {
+            n += jsmn_varint_put(&record[n], size);
+            if (size > 0) {
+                n += jsmn_varint_put(&record[n], desc_tokens);
+                n += jsmn_varint_put(&record[n], desc_bytes);
+            }
+        }
+
+        total += n;
+        if (stream != NULL) {
+            if (total > stream_len) {
+                goto error;
+            }
+            memcpy(stream + stream_len - total, record, n);
+        }
+
+        subtrees[sp].tokens = desc_tokens;
+        subtrees[sp].bytes = desc_bytes + n;
+        sp++;
+    }
+
+    if (stream != NULL && total < stream_len) {
+        memmove(stream, stream + stream_len - total, total);
+    }
+
+    free(subtrees);
+    return total;
+
+error:
+    free(subtrees);
+    return 0;
+}
+
+JSMN_EXPORT
+void jsmn_packed_init(jsmn_packed_iter *it, const unsigned char *stream, const size_t stream_len)
+{
+    it->pos = stream;
+    it->end = stream + stream_len;
+    it->id = 0;
+    it->base = 0;
+    it->depth = 0;
+    it->skip_tokens = 0;
+    it->skip_bytes = 0;
+    it->error = JSMN_SUCCESS;
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_packed_next(jsmn_packed_iter *it, jsmntok_t *token)
+{
+    jsmn_packed_frame *frame;
+    jsmntype_t type;
+    size_t raw, delta, len, size = 0, desc_tokens = 0, desc_bytes = 0;
+    jsmnint_t id, start, end;
+#if defined(JSMN_PAIR_TOKENS)
+    size_t key_delta = 0, key_len = 0;
+    jsmnint_t key_start = JSMN_NEG, key_end = JSMN_NEG;
+#endif
+    jsmnbool more;
+
+    if (it->error != JSMN_SUCCESS) {
+        return JSMN_NEG;
+    }
+
+    while (it->depth > 0 && it->frames[it->depth - 1].remaining == 0) {
+        it->depth--;
+    }
+
+    if (it->pos == it->end) {
+        if (it->depth != 0) {
+            it->error = JSMN_ERROR_PART;
+        }
+        return JSMN_NEG;
+    }
+
+    raw = *it->pos++;
+    if ((raw & JSMN_PACK_RAW) == JSMN_PACK_RAW) {
+        if (!jsmn_varint_get(&it->pos, it->end, &raw)) {
+            goto corrupt;
+        }
+        type = (jsmntype_t)raw;
+    } else {
+        type = jsmn_pack_bases[raw & 0x03] | jsmn_pack_classes[raw >> JSMN_PACK_SHIFT];
+        if (raw & JSMN_PACK_KEY) {
+            type |= JSMN_KEY;
+        }
+        if (raw & JSMN_PACK_VALUE) {
+            type |= JSMN_VALUE;
+        }
+        if (raw & JSMN_PACK_INSD) {
+            type |= JSMN_INSD_OBJ;
+        }
+    }
+
+#if defined(JSMN_PAIR_TOKENS)
+    if ((type & JSMN_INSD_OBJ) &&
+            (!jsmn_varint_get(&it->pos, it->end, &key_delta) ||
+             !jsmn_varint_get(&it->pos, it->end, &key_len))) {
+        goto corrupt;
+    }
+#endif
+    if (!jsmn_varint_get(&it->pos, it->end, &delta) ||
+            !jsmn_varint_get(&it->pos, it->end, &len)) {
+        goto corrupt;
+    }
+    if (jsmn_pack_has_children(type)) {
+        if (!jsmn_varint_get(&it->pos, it->end, &size)) {
+            goto corrupt;
+        }
+        if (size > 0 &&
+                (!jsmn_varint_get(&it->pos, it->end, &desc_tokens) ||
+                 !jsmn_varint_get(&it->pos, it->end, &desc_bytes))) {
+            goto corrupt;
+        }
+    }
+    if (desc_bytes > (size_t)(it->end - it->pos)) {
+        goto corrupt;
+    }
+
+    frame = it->depth > 0 ? &it->frames[it->depth - 1] : NULL;
+#if defined(JSMN_PAIR_TOKENS)
+    if (frame != NULL && (type & JSMN_INSD_OBJ)) {
+        key_start = frame->base + key_delta;
+        key_end = key_start + key_len;
+        frame->base = key_end;
+    }
+#endif
+    start = (frame != NULL ? frame->base : it->base) + delta;
+    end = start + len;
+    id = it->id++;
+
+    if (frame != NULL) {
+        frame->remaining--;
+        frame->base = end;
+        more = frame->remaining > 0 ? JSMN_TRUE : JSMN_FALSE;
+    } else {
+        it->base = end;
+        more = (it->pos + desc_bytes < it->end) ? JSMN_TRUE : JSMN_FALSE;
+    }
+
+    if (size > 0) {
+        if (it->depth == JSMN_PACKED_DEPTH) {
+            it->error = JSMN_ERROR_NOMEM;
+            return JSMN_NEG;
+        }
+        it->frames[it->depth].id = id;
+        it->frames[it->depth].remaining = size;
+        it->frames[it->depth].base = (type & JSMN_CONTAINER) ? start : end;
+        it->depth++;
+    }
+    it->skip_tokens = desc_tokens;
+    it->skip_bytes = desc_bytes;
+
+    token->type = type;
+    token->start = start;
+    token->end = end;
+    token->size = size;
+#if defined(JSMN_PAIR_TOKENS)
+    token->key_start = key_start;
+    token->key_end = key_end;
+#endif
+#if defined(JSMN_PARENT_LINKS)
+    token->parent = frame != NULL ? frame->id : JSMN_NEG;
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+    token->next_sibling = more ? id + 1 + desc_tokens : JSMN_NEG;
+#else
+    (void)more;
+#endif
+
+    return id;
+
+corrupt:
+    it->error = JSMN_ERROR_INVAL;
+    return JSMN_NEG;
+}
+
+JSMN_EXPORT
+void jsmn_packed_skip(jsmn_packed_iter *it)
+{
+    if (it->depth > 0 && it->frames[it->depth - 1].id == it->id - 1) {
+        it->depth--;
+    }
+    it->pos += it->skip_bytes;
+    it->id += it->skip_tokens;
+    it->skip_tokens = 0;
+    it->skip_bytes = 0;
+}
+
+JSMN_EXPORT
+int jsmn_file_open(jsmn_file *file, const char *path, const int flags)
+{
+    file->js = NULL;
+    file->len = 0;
+    file->mapped = 0;
+
+#if defined(JSMN_MMAP)
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    int map_flags = MAP_PRIVATE;
+    void *map;
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    /* An empty mapping is an error, an empty document is not */
+    if (st.st_size == 0) {
+        close(fd);
+        file->js = "";
+        return 0;
+    }
+
+# if defined(MAP_POPULATE)
+    if (flags & JSMN_MAP_POPULATE) {
+        map_flags |= MAP_POPULATE;
+    }
+# endif
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, map_flags, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    /* The parser reads the file front to back once */
+    (void)madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+# if defined(MADV_HUGEPAGE)
+    if (flags & JSMN_MAP_HUGE) {
+        (void)madvise(map, (size_t)st.st_size, MADV_HUGEPAGE);
+    }
+# endif
+
+    file->js = map;
+    file->len = (size_t)st.st_size;
+    file->mapped = 1;
+    return 0;
+#else
+    FILE *fp = fopen(path, "rb");
+    char *js;
+    long size;
+
+    (void)flags;
+    if (fp == NULL) {
+        return -1;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0) {
+        fclose(fp);
+        return -1;
+    }
+    rewind(fp);
+
+    js = malloc((size_t)size + 1);
+    if (js == NULL || fread(js, 1, (size_t)size, fp) != (size_t)size) {
+        free(js);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    file->js = js;
+    file->len = (size_t)size;
+    return 0;
+#endif
+}
+
+JSMN_EXPORT
+void jsmn_file_close(jsmn_file *file)
+{
+#if defined(JSMN_MMAP)
+    if (file->mapped) {
+        munmap((void *)file->js, file->len);
+    }
+#else
+    free((void *)file->js);
+#endif
+    file->js = NULL;
+    file->len = 0;
+    file->mapped = 0;
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_parse_file(const char *path, const int flags, jsmn_file *file,
+                          jsmn_parser *parser, jsmntokens_t *tokens, const size_t num_tokens)
+{
+    if (jsmn_file_open(file, path, flags) != 0) {
+        return JSMN_ERROR_INVAL;
+    }
+
+    return jsmn_parse(parser, file->js, file->len, tokens, num_tokens);
+}
+
+/**
+ * Reads the next stretch of a stream, as fread() or read() does.
+ */
+typedef long (*jsmn_doc_read)(void *src, char *buf, const size_t size);
+
+static long jsmn_doc_fread(void *src, char *buf, const size_t size)
+{
+    FILE *fp = src;
+    size_t n = fread(buf, 1, size, fp);
+
+    if (n == 0 && ferror(fp)) {
+        return -1;
+    }
+    return (long)n;
+}
+
+static long jsmn_doc_fdread(void *src, char *buf, const size_t size)
+{
+#if defined(_WIN32)
+    return (long)_read(*(const int *)src, buf, (unsigned)size);
+#else
+    return (long)read(*(const int *)src, buf, size);
+#endif
+}
+
+/**
+ * Makes room for twice as many tokens, keeping the ones already parsed.
+ */
+static int jsmn_doc_grow(jsmn_doc *doc)
+{
+#if defined(JSMN_BLOCK_TOKENS)
+    /* Blocks are appended by the parser itself */
+    if (doc->tokens != NULL) {
+        return -1;
+    }
+    doc->tokens = jsmn_tokens_alloc(0);
+    return (doc->tokens != NULL ? 0 : -1);
+#else
+    const size_t num_tokens = (doc->num_tokens != 0 ? doc->num_tokens * 2 : 64);
+# if !defined(JSMN_SOA_TOKENS)
+    jsmntokens_t *tokens = realloc(doc->tokens, num_tokens * sizeof(jsmntok_t));
+    if (tokens == NULL) {
+        return -1;
+    }
+# else
+    /* Every array moves, so copy them one by one into a new block */
+    jsmntokens_t *tokens = jsmn_tokens_alloc(num_tokens);
+    const size_t n = doc->num_tokens;
+    if (tokens == NULL) {
+        return -1;
+    }
+    if (doc->tokens != NULL) {
+        memcpy(tokens->types, doc->tokens->types, n * sizeof(jsmntype_t));
+        memcpy(tokens->starts, doc->tokens->starts, n * sizeof(jsmnint_t));
+        memcpy(tokens->ends, doc->tokens->ends, n * sizeof(jsmnint_t));
+        memcpy(tokens->sizes, doc->tokens->sizes, n * sizeof(jsmnint_t));
+#  if defined(JSMN_PAIR_TOKENS)
+        memcpy(tokens->key_starts, doc->tokens->key_starts, n * sizeof(jsmnint_t));
+        memcpy(tokens->key_ends, doc->tokens->key_ends, n * sizeof(jsmnint_t));
+#  endif
+#  if defined(JSMN_PARENT_LINKS)
+        memcpy(tokens->parents, doc->tokens->parents, n * sizeof(jsmnint_t));
+#  endif
+#  if defined(JSMN_NEXT_SIBLING)
+        memcpy(tokens->siblings, doc->tokens->siblings, n * sizeof(jsmnint_t));
+#  endif
+#  if defined(JSMN_COMPACT_ARRAYS)
+        memcpy(tokens->elements, doc->tokens->elements, n * sizeof(jsmnint_t));
+#  endif
+        jsmn_tokens_free(doc->tokens);
+    }
+# endif
+    doc->tokens = tokens;
+    doc->num_tokens = num_tokens;
+    return 0;
+#endif
+}
+
+/**
+ * Reads until the parser has a whole document, resuming it after every read.
+ */
+static jsmnint_t jsmn_doc_parse(jsmn_doc *doc, jsmn_doc_read read_fn, void *src)
+{
+    jsmnint_t r = JSMN_ERROR_PART;
+    char *js;
+    long n;
+
+    /* The previous document goes, what was read past it stays */
+    if (doc->parser.pos > 0) {
+        doc->len -= doc->parser.pos;
+        memmove(doc->js, doc->js + doc->parser.pos, doc->len);
+        doc->js[doc->len] = '\0';
+    }
+    jsmn_init(&doc->parser);
+
+    if (doc->tokens == NULL && jsmn_doc_grow(doc) != 0) {
+        return JSMN_ERROR_NOMEM;
+    }
+
+    for (;;) {
+        if (doc->len > 0 || doc->eof) {
+#if defined(JSMN_BLOCK_TOKENS)
+            r = jsmn_parse(&doc->parser, doc->js, doc->len, doc->tokens, (size_t)-1);
+#else
+            r = jsmn_parse(&doc->parser, doc->js, doc->len, doc->tokens, doc->num_tokens);
+#endif
+            if (r == (jsmnint_t)JSMN_ERROR_NOMEM) {
+                if (jsmn_doc_grow(doc) != 0) {
+                    return r;
+                }
+                continue;
+            }
+            if (doc->eof) {
+                break;
+            }
+            if (!jsmn_parse_more(&doc->parser, r, doc->len)) {
+                return r;
+            }
+        }
+
+        if (doc->cap - doc->len < JSMN_DOC_CHUNK + 1) {
+            size_t cap = (doc->cap != 0 ? doc->cap : JSMN_DOC_CHUNK + 1);
+            while (cap - doc->len < JSMN_DOC_CHUNK + 1) {
+                cap *= 2;
+            }
+            js = realloc(doc->js, cap);
+            if (js == NULL) {
+                return JSMN_ERROR_NOMEM;
+            }
+            doc->js = js;
+            doc->cap = cap;
+        }
+        n = read_fn(src, doc->js + doc->len, JSMN_DOC_CHUNK);
+        if (n < 0) {
+            return JSMN_ERROR_INVAL;
+        }
+        doc->eof = (n == 0);
+        doc->len += (size_t)n;
+        doc->js[doc->len] = '\0';
+    }
+
+    /* Nothing but whitespace up to the end of the input */
+    if (r == (jsmnint_t)JSMN_ERROR_INVAL && jsmn_parse_more(&doc->parser, r, doc->len)) {
+        doc->eof = 0;
+        return 0;
+    }
+    return r;
+}
+
+JSMN_EXPORT
+void jsmn_doc_init(jsmn_doc *doc)
+{
+    memset(doc, 0, sizeof(*doc));
+    jsmn_init(&doc->parser);
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_fparse(FILE *fp, jsmn_doc *doc)
+{
+    return jsmn_doc_parse(doc, jsmn_doc_fread, fp);
+}
+
+JSMN_EXPORT
+jsmnint_t jsmn_fdparse(const int fd, jsmn_doc *doc)
+{
+    int src = fd;
+    return jsmn_doc_parse(doc, jsmn_doc_fdread, &src);
+}
+
+JSMN_EXPORT
+void jsmn_doc_free(jsmn_doc *doc)
+{
+    free(doc->js);
+    jsmn_tokens_free(doc->tokens);
+    memset(doc, 0, sizeof(*doc));
+}
+
 JSMN_EXPORT
 void jsmn_explodeJSON(const char *json, const size_t len)
 {
-    jsmnint_t rv, i, depth;
+    jsmnint_t rv, i, depth, parent;
     char c;
 
-    jsmntok_t *tokens = jsmn_tokenize(json, len, &rv);
-    jsmntok_t *token;
+    jsmntokens_t *tokens = jsmn_tokenize(json, len, &rv);
+    jsmntype_t type;
 
     if (rv >= (jsmnint_t)-4) {
         printf("jsmn_parse error: %s\n", jsmn_strerror(rv));
@@ -234,37 +1420,57 @@ void jsmn_explodeJSON(const char *json, const size_t len)
     printf("    Token |      Type |    Start |      End |   Length | Children |   Parent |  Sibling | K/V   | \n");
     printf("----------+-----------+----------+----------+----------+----------+----------+----------+-------+-\n");
     for (i = 0, depth = 0; i < rv; i++) {
-        token = &tokens[i];
+        int indent = depth << 2;
+        type = JSMN_TOK_TYPE(tokens, i);
         printf(   "%9d", i);
-        printf(" | %9s", jsmntype[token->type & JSMN_VAL_TYPE]);
-        printf(" | %8d", token->start);
-        printf(" | %8d", token->end);
-        printf(" | %8d", token->end - token->start);
-        printf(" | %8d", token->size);
-        printf(" | %8d", token->parent != JSMN_NEG ? token->parent : -1);
-        printf(" | %8d", token->next_sibling != JSMN_NEG ? token->next_sibling : -1);
-        printf(" | %5s", jsmnextr[(token->type & (JSMN_KEY | JSMN_VALUE)) >> 4]);
+        printf(" | %9s", jsmntype[type & JSMN_VAL_TYPE]);
+        printf(" | %8d", JSMN_TOK_START(tokens, i));
+        printf(" | %8d", JSMN_TOK_END(tokens, i));
+        printf(" | %8d", JSMN_TOK_END(tokens, i) - JSMN_TOK_START(tokens, i));
+        printf(" | %8d", JSMN_TOK_SIZE(tokens, i));
+        printf(" | %8d", JSMN_TOK_PARENT(tokens, i) != JSMN_NEG ? JSMN_TOK_PARENT(tokens, i) : -1);
+        printf(" | %8d", JSMN_TOK_NEXT_SIBLING(tokens, i) != JSMN_NEG ? JSMN_TOK_NEXT_SIBLING(tokens, i) : -1);
+        printf(" | %5s", jsmnextr[(type & (JSMN_KEY | JSMN_VALUE)) >> 4]);
         printf(" |");
 
-        if (token->type & JSMN_CONTAINER) {
-            printf("%*s  %s\n", depth << 2, "", token->type & JSMN_OBJECT ? "{" : "[");
+#if defined(JSMN_PAIR_TOKENS)
+        if (type & JSMN_INSD_OBJ) {
+            printf("%*s  \"%.*s\" :", indent, "", JSMN_TOK_KEY_END(tokens, i) - JSMN_TOK_KEY_START(tokens, i), &json[JSMN_TOK_KEY_START(tokens, i)]);
+            indent = 0;
+        }
+#endif
+
+#if defined(JSMN_LAZY_TOKENS)
+        if (type & JSMN_CONTAINER && !(type & JSMN_UNEXPANDED)) {
+#else
+        if (type & JSMN_CONTAINER) {
+#endif
+            printf("%*s  %s\n", indent, "", type & JSMN_OBJECT ? "{" : "[");
             depth += 1;
             continue;
         }
 
-        if (token->type & JSMN_KEY) {
-            c = (token->type & JSMN_STRING) ? '\"' : ' ';
-            printf("%*s%c%.*s%c :\n", depth << 2, "", c, token->end - token->start, &json[token->start], c);
+        if (type & JSMN_KEY) {
+            c = (type & JSMN_STRING) ? '\"' : ' ';
+            printf("%*s%c%.*s%c :\n", depth << 2, "", c, JSMN_TOK_END(tokens, i) - JSMN_TOK_START(tokens, i), &json[JSMN_TOK_START(tokens, i)], c);
             continue;
         }
 
+#if !defined(JSMN_PAIR_TOKENS)
         printf("%*s", depth << 2, "");
-        if (token->type & JSMN_INSD_OBJ)
+        if (type & JSMN_INSD_OBJ)
             printf("  ");
-        c = (token->type & JSMN_STRING) ? '\"' : ' ';
-        printf("%c%.*s%c", c, token->end - token->start, &json[token->start], c);
-        if ((token->type & JSMN_INSD_OBJ && tokens[token->parent].next_sibling != JSMN_NEG) ||
-               token->next_sibling != JSMN_NEG) {
+#else
+        printf("%*s ", indent, "");
+#endif
+        c = (type & JSMN_STRING) ? '\"' : ' ';
+        printf("%c%.*s%c", c, JSMN_TOK_END(tokens, i) - JSMN_TOK_START(tokens, i), &json[JSMN_TOK_START(tokens, i)], c);
+#if !defined(JSMN_PAIR_TOKENS)
+        if ((type & JSMN_INSD_OBJ && JSMN_TOK_NEXT_SIBLING(tokens, JSMN_TOK_PARENT(tokens, i)) != JSMN_NEG) ||
+               JSMN_TOK_NEXT_SIBLING(tokens, i) != JSMN_NEG) {
+#else
+        if (JSMN_TOK_NEXT_SIBLING(tokens, i) != JSMN_NEG) {
+#endif
             printf(",\n");
             continue;
         }
@@ -273,27 +1479,33 @@ void jsmn_explodeJSON(const char *json, const size_t len)
 
         depth -= 1;
         if (depth == JSMN_NEG) {
-          printf("  %c\n", tokens[0].type == JSMN_OBJECT ? '}' : ']');
+          printf("  %c\n", JSMN_TOK_TYPE(tokens, 0) == JSMN_OBJECT ? '}' : ']');
           continue;
         }
 
-        if (tokens[token->parent].type & JSMN_ARRAY) {
+        parent = JSMN_TOK_PARENT(tokens, i);
+        if (JSMN_TOK_TYPE(tokens, parent) & JSMN_ARRAY) {
             printf("%*s  ]", depth << 2, "");
-            if (tokens[token->parent].parent != 0 &&
-                    tokens[tokens[token->parent].parent].next_sibling != JSMN_NEG) {
+            if (JSMN_TOK_PARENT(tokens, parent) != 0 &&
+                    JSMN_TOK_NEXT_SIBLING(tokens, JSMN_TOK_PARENT(tokens, parent)) != JSMN_NEG) {
                 printf(",");
             }
             printf("\n");
         }
-        else if (tokens[tokens[token->parent].parent].type & JSMN_OBJECT) {
+#if !defined(JSMN_PAIR_TOKENS)
+        else if (JSMN_TOK_TYPE(tokens, JSMN_TOK_PARENT(tokens, parent)) & JSMN_OBJECT) {
+            parent = JSMN_TOK_PARENT(tokens, parent);
+#else
+        else if (JSMN_TOK_TYPE(tokens, parent) & JSMN_OBJECT) {
+#endif
             printf("%*s  }", depth << 2, "");
-            if (tokens[tokens[token->parent].parent].parent != JSMN_NEG &&
-                    tokens[tokens[tokens[token->parent].parent].parent].next_sibling != JSMN_NEG) {
+            if (JSMN_TOK_PARENT(tokens, parent) != JSMN_NEG &&
+                    JSMN_TOK_NEXT_SIBLING(tokens, JSMN_TOK_PARENT(tokens, parent)) != JSMN_NEG) {
                 printf(",");
             }
             printf("\n");
         }
     }
 
-    free(tokens);
+    jsmn_tokens_free(tokens);
 }
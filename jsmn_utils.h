@@ -3,12 +3,18 @@
 
 #include <stdarg.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "jsmn_defines.h"
 
 #define JSMN_HEADER
 #include "jsmn.h"
 
+/* The helpers read token positions as offsets in the JSON string */
+#if defined(JSMN_SEGMENTED_TOKENS)
+# error "jsmn_utils does not support JSMN_SEGMENTED_TOKENS"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,15 +27,44 @@ extern "C" {
  */
 const char *jsmn_strerror(jsmnerr errno);
 
+/**
+ * @brief Allocate storage for tokens
+ *
+ * With JSMN_SOA_TOKENS the descriptor and all of its arrays are allocated
+ *   as a single block. With JSMN_BLOCK_TOKENS enough blocks for num_tokens are
+ *   allocated up front and jsmn_tokens_grow is installed to append more.
+ *
+ * @param[in] num_tokens Number of Tokens
+ * @return Allocated tokens pointer or NULL, release with jsmn_tokens_free()
+ */
+jsmntokens_t *jsmn_tokens_alloc(const size_t num_tokens);
+
+/**
+ * @brief Release tokens from jsmn_tokens_alloc() or jsmn_tokenize()
+ *
+ * @param[in] tokens Tokens to release, may be NULL
+ */
+void jsmn_tokens_free(jsmntokens_t *tokens);
+
+#if defined(JSMN_BLOCK_TOKENS)
+/**
+ * @brief Append a heap allocated block, usable as jsmntok_blocks_t::grow
+ *
+ * @param[in,out] tokens Block directory
+ * @return nonzero on success, 0 when out of memory
+ */
+int jsmn_tokens_grow(jsmntok_blocks_t *tokens);
+#endif
+
 /**
  * @brief Tokenizes JSON string
  *
  * @param[in] json JSON String
  * @param[in] json_len Length of JSON String
  * @param[out] rv Return Value
- * @return Allocated jsmntok_t array pointer
+ * @return Allocated jsmntokens_t pointer
  */
-jsmntok_t *jsmn_tokenize(const char *json, const size_t json_len, jsmnint_t *rv);
+jsmntokens_t *jsmn_tokenize(const char *json, const size_t json_len, jsmnint_t *rv);
 
 /**
  * @brief Tokenize JSON string
@@ -40,7 +75,7 @@ jsmntok_t *jsmn_tokenize(const char *json, const size_t json_len, jsmnint_t *rv)
  * @param[in] json_len Length of JSON String
  * @return Return Value
  */
-jsmnint_t jsmn_tokenize_noalloc(jsmntok_t *tokens, const uint32_t num_tokens, const char *json, const size_t json_len);
+jsmnint_t jsmn_tokenize_noalloc(jsmntokens_t *tokens, const uint32_t num_tokens, const char *json, const size_t json_len);
 
 /**
  * @brief String comparison between token and string
@@ -59,7 +94,7 @@ int jsmn_streq(const char *json, const jsmntok_t *tok, const char *s);
  * @param[in] t the position of the token
  * @return jsmnint_t the position of t's previous sibling, else JSMN_NEG
  */
-jsmnint_t jsmn_get_prev_sibling(const jsmntok_t *tokens, const jsmnint_t t);
+jsmnint_t jsmn_get_prev_sibling(const jsmntokens_t *tokens, const jsmnint_t t);
 
 /**
  * @brief Find the next sibling of token at position t
@@ -68,7 +103,7 @@ jsmnint_t jsmn_get_prev_sibling(const jsmntok_t *tokens, const jsmnint_t t);
  * @param[in] t the position of the token
  * @return jsmnint_t the position of t's next sibling, else JSMN_NEG
  */
-jsmnint_t jsmn_get_next_sibling(const jsmntok_t *tokens, const jsmnint_t t);
+jsmnint_t jsmn_get_next_sibling(const jsmntokens_t *tokens, const jsmnint_t t);
 
 /**
  * @brief Look for a value in a JSON string
@@ -76,9 +111,252 @@ jsmnint_t jsmn_get_next_sibling(const jsmntok_t *tokens, const jsmnint_t t);
  * @param[in] json json string
  * @param[in] tokens jsmn tokens
  * @param[in] num_keys number of keys
- * @return jsmnint_t position of value requested
+ * @return jsmnint_t position of value requested, JSMN_NEG if not found or
+ *         inside a JSMN_UNEXPANDED or JSMN_COMPACT token
+ */
+jsmnint_t jsmn_lookup(const char *json, const jsmntokens_t *tokens, const size_t num_keys, ...);
+
+/**
+ * @brief Decode an array of numbers into doubles
+ *
+ * The elements are read straight from the array's text, so no child tokens
+ *   are visited and a JSMN_UNEXPANDED array works as well. Digits are
+ *   converted 8 at a time, and numbers that fit in a double's mantissa with a
+ *   power of ten up to 22 skip strtod. The others are handed to strtod without
+ *   a decimal point, so the locale does not change the result.
+ *
+ * @param[in] json JSON String
+ * @param[in] tokens jsmn tokens
+ * @param[in] array position of the array token
+ * @param[out] values Buffer for the elements
+ * @param[in] num_values Size of values
+ * @param[out] error Index of the first element that is not a number, 0 if array
+ *             is not a complete array. Only set on JSMN_ERROR_INVAL, may be NULL
+ * @return jsmnint_t number of elements decoded, JSMN_ERROR_NOMEM if values is
+ *         too small, JSMN_ERROR_INVAL if an element is not a number or array
+ *         is not a complete array
+ */
+jsmnint_t jsmn_array_to_doubles(const char *json, const jsmntokens_t *tokens, const jsmnint_t array,
+                                double *values, const size_t num_values, jsmnint_t *error);
+
+/**
+ * @brief Decode an array of integers into int64_ts
+ *
+ * Same as jsmn_array_to_doubles(), but an element with a fraction or an
+ *   exponent, or one outside of int64_t's range, is not a number.
+ *
+ * @param[in] json JSON String
+ * @param[in] tokens jsmn tokens
+ * @param[in] array position of the array token
+ * @param[out] values Buffer for the elements
+ * @param[in] num_values Size of values
+ * @param[out] error Index of the first element that is not an integer, 0 if array
+ *             is not a complete array. Only set on JSMN_ERROR_INVAL, may be NULL
+ * @return jsmnint_t number of elements decoded, JSMN_ERROR_NOMEM if values is
+ *         too small, JSMN_ERROR_INVAL if an element is not an integer or array
+ *         is not a complete array
+ */
+jsmnint_t jsmn_array_to_int64(const char *json, const jsmntokens_t *tokens, const jsmnint_t array,
+                              int64_t *values, const size_t num_values, jsmnint_t *error);
+
+#if !defined(JSMN_PACKED_DEPTH)
+/*! Maximum nesting (containers and keys) a jsmn_packed_iter can follow */
+# define JSMN_PACKED_DEPTH 64
+#endif
+
+/**
+ * Open token in a packed token stream
+ */
+typedef struct jsmn_packed_frame {
+  jsmnint_t id;                 /*!< token id */
+  jsmnint_t remaining;          /*!< children not yet visited */
+  jsmnint_t base;               /*!< offset the next child's start is relative to */
+} jsmn_packed_frame;
+
+/**
+ * Forward iterator over a packed token stream
+ */
+typedef struct jsmn_packed_iter {
+  const unsigned char *pos;     /*!< next record */
+  const unsigned char *end;     /*!< end of the stream */
+  jsmnint_t id;                 /*!< id of the next token */
+  jsmnint_t base;               /*!< offset the next root token's start is relative to */
+  jsmnint_t depth;              /*!< number of open frames */
+  jsmnint_t skip_tokens;        /*!< descendants of the last token */
+  size_t skip_bytes;            /*!< size of the last token's descendants in the stream */
+  jsmnerr error;                /*!< JSMN_SUCCESS, or why iteration stopped early */
+  jsmn_packed_frame frames[JSMN_PACKED_DEPTH];
+} jsmn_packed_iter;
+
+/**
+ * @brief Encode tokens as a packed token stream
+ *
+ * Every token is stored as a one byte type, its start as a varint delta from
+ *   the end of its previous sibling (or the start of its parent), and its
+ *   length as a varint. Objects, arrays, and keys add their size and the number
+ *   of tokens and bytes beneath them, parent and sibling links are implied by
+ *   the order of the stream. With JSMN_PAIR_TOKENS object members also store
+ *   their key as a delta and length ahead of their own start. Call with
+ *   stream == NULL to get the size needed. Deltas are taken between offsets
+ *   in the JSON string, which is why JSMN_SEGMENTED_TOKENS is not supported.
+ *
+ * @param[in] tokens jsmn tokens from a complete parse
+ * @param[in] num_tokens Number of Tokens
+ * @param[out] stream Buffer for the packed stream or NULL
+ * @param[in] stream_len Size of stream
+ * @return size_t Size of the packed stream, 0 on error
+ */
+size_t jsmn_pack_tokens(const jsmntokens_t *tokens, const jsmnint_t num_tokens,
+                        unsigned char *stream, const size_t stream_len);
+
+/**
+ * @brief Start iterating over a packed token stream
+ *
+ * @param[out] it iterator
+ * @param[in] stream Packed stream from jsmn_pack_tokens
+ * @param[in] stream_len Size of stream
+ */
+void jsmn_packed_init(jsmn_packed_iter *it, const unsigned char *stream, const size_t stream_len);
+
+/**
+ * @brief Decode the next token of a packed token stream
+ *
+ * @param[in,out] it iterator
+ * @param[out] token the decoded token
+ * @return jsmnint_t id of the token, JSMN_NEG at the end of the stream or on
+ *         error (see it->error)
+ */
+jsmnint_t jsmn_packed_next(jsmn_packed_iter *it, jsmntok_t *token);
+
+/**
+ * @brief Skip the descendants of the token last returned by jsmn_packed_next
+ *
+ * @param[in,out] it iterator
+ */
+void jsmn_packed_skip(jsmn_packed_iter *it);
+
+/*! jsmn_file_open flag: read the whole file in as it is mapped (MAP_POPULATE) */
+#define JSMN_MAP_POPULATE 0x1
+/*! jsmn_file_open flag: back the mapping with huge pages where the system can (MADV_HUGEPAGE) */
+#define JSMN_MAP_HUGE     0x2
+
+/**
+ * JSON file held in memory for parsing
+ */
+typedef struct jsmn_file {
+  const char *js;               /*!< contents of the file */
+  size_t len;                   /*!< size of the file */
+  int mapped;                   /*!< js is mapped rather than read into the heap */
+} jsmn_file;
+
+/**
+ * @brief Map a JSON file into memory
+ *
+ * The file is mapped read only with MADV_SEQUENTIAL, so it is paged in by
+ *   read-ahead as the parser goes and never copied. Where mmap is not
+ *   available, or with JSMN_NO_MMAP, the file is read into the heap instead.
+ *
+ * @param[out] file Handle to fill, release with jsmn_file_close()
+ * @param[in] path Path of the file
+ * @param[in] flags JSMN_MAP_POPULATE, JSMN_MAP_HUGE or 0
+ * @return 0 on success, file->js is then never NULL, even for an empty file;
+ *         -1 if the file could not be read (see errno), file->js is then NULL
+ */
+int jsmn_file_open(jsmn_file *file, const char *path, const int flags);
+
+/**
+ * @brief Release a file from jsmn_file_open()
+ *
+ * Tokens parsed from the file point into it and have to be used first.
+ *
+ * @param[in,out] file Handle to release
+ */
+void jsmn_file_close(jsmn_file *file);
+
+/**
+ * @brief Tokenize a JSON file in place
+ *
+ * Opens the file with jsmn_file_open() and runs jsmn_parse over it; the
+ *   tokens' positions are relative to file->js, which stays valid until
+ *   jsmn_file_close(). The handle is filled even if parsing fails. A file that
+ *   could not be read also gives JSMN_ERROR_INVAL, tell it from malformed JSON
+ *   by file->js, which is then NULL (and errno says why).
+ *
+ * @param[in] path Path of the file
+ * @param[in] flags JSMN_MAP_POPULATE, JSMN_MAP_HUGE or 0
+ * @param[out] file Handle for the file's contents
+ * @param[in,out] parser jsmn parser, initialized
+ * @param[out] tokens Tokens or NULL
+ * @param[in] num_tokens Number of Tokens
+ * @return jsmnint_t number of tokens found or ERRNO, JSMN_ERROR_INVAL with
+ *         file->js NULL if the file could not be read
+ */
+jsmnint_t jsmn_parse_file(const char *path, const int flags, jsmn_file *file,
+                          jsmn_parser *parser, jsmntokens_t *tokens, const size_t num_tokens);
+
+#if !defined(JSMN_DOC_CHUNK)
+/*! Bytes jsmn_fparse and jsmn_fdparse ask for in each read */
+# define JSMN_DOC_CHUNK 65536
+#endif
+
+/**
+ * JSON document read from a stream, with the storage for its tokens
+ *
+ * The buffer and the tokens are kept from one call to the next, so reading
+ *   several documents through one handle only allocates when one is larger
+ *   than those before it.
+ */
+typedef struct jsmn_doc {
+  char *js;                     /*!< input read so far, NUL terminated */
+  size_t len;                   /*!< bytes in js, the document and whatever was read past it */
+  size_t cap;                   /*!< size of the js allocation */
+  jsmntokens_t *tokens;         /*!< tokens of the document */
+  size_t num_tokens;            /*!< tokens allocated */
+  int eof;                      /*!< the end of the input has been read */
+  jsmn_parser parser;           /*!< parser state, parser.pos is where the document ends */
+} jsmn_doc;
+
+/**
+ * @brief Set up an empty document handle
+ *
+ * @param[out] doc Handle to set up, release with jsmn_doc_free()
+ */
+void jsmn_doc_init(jsmn_doc *doc);
+
+/**
+ * @brief Read and tokenize the next JSON document from a stream
+ *
+ * Reads JSMN_DOC_CHUNK bytes at a time into doc->js and resumes the parser
+ *   from where it stopped after each read rather than parsing the input again;
+ *   the tokens are doubled and the parser resumed when it runs out of them.
+ *   Input read past the end of the document is kept in doc->js and is the
+ *   start of the next call, which reuses the buffer and the tokens.
+ *
+ * @param[in] fp Stream to read from
+ * @param[in,out] doc Handle from jsmn_doc_init()
+ * @return jsmnint_t number of tokens found or ERRNO, 0 if the input ends
+ *         before another document starts, JSMN_ERROR_INVAL if the stream
+ *         could not be read (see errno), JSMN_ERROR_NOMEM when out of memory
+ */
+jsmnint_t jsmn_fparse(FILE *fp, jsmn_doc *doc);
+
+/**
+ * @brief Read and tokenize the next JSON document from a file descriptor
+ *
+ * As jsmn_fparse(), reading with read(2).
+ *
+ * @param[in] fd File or pipe open for reading, left open
+ * @param[in,out] doc Handle from jsmn_doc_init()
+ * @return jsmnint_t number of tokens found or ERRNO, as jsmn_fparse()
+ */
+jsmnint_t jsmn_fdparse(const int fd, jsmn_doc *doc);
+
+/**
+ * @brief Release the buffer and tokens of a document handle
+ *
+ * @param[in,out] doc Handle to release
  */
-jsmnint_t jsmn_lookup(const char *json, const jsmntok_t *tokens, const size_t num_keys, ...);
+void jsmn_doc_free(jsmn_doc *doc);
 
 /**
  * @brief Print an extremely verbose description of JSON string
@@ -0,0 +1,397 @@
+#include <stdlib.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "jsmn_reader.h"
+
+#if defined(JSMN_HAVE_ZLIB)
+# include <zlib.h>
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+# include <zstd.h>
+#endif
+
+int total_tests = 0;
+void *cur_test = NULL;
+
+/**
+ * @brief Open a file or a pipe holding data
+ *
+ * @param[in] data bytes to read back
+ * @param[in] len number of bytes, less than a pipe holds when use_pipe
+ * @param[in] use_pipe read through a pipe rather than a regular file
+ * @return int file descriptor positioned at the start of data
+ */
+static int data_fd(const void *data, const size_t len, const int use_pipe)
+{
+    char path[] = "/tmp/jsmn_reader_testXXXXXX";
+    int fds[2];
+
+    if (use_pipe) {
+        assert_int_equal(pipe(fds), 0);
+        assert_int_equal(write(fds[1], data, len), len);
+        close(fds[1]);
+        return fds[0];
+    }
+
+    fds[0] = mkstemp(path);
+    assert_true(fds[0] >= 0);
+    unlink(path);
+    assert_int_equal(write(fds[0], data, len), len);
+    assert_int_equal(lseek(fds[0], 0, SEEK_SET), 0);
+    return fds[0];
+}
+
+/**
+ * @brief Take every block of a reader, checking it against data
+ *
+ * @param[in,out] rd reader, at the start of its input
+ * @param[in] data bytes the reader should give
+ * @param[in] len number of bytes
+ */
+static void read_all(jsmn_reader *rd, const void *data, const size_t len)
+{
+    long n;
+
+    while ((n = jsmn_reader_fill(rd)) > 0) {
+        assert_true(rd->len <= len);
+    }
+    assert_int_equal(n, 0);
+    assert_int_equal(rd->error, 0);
+    assert_true(rd->eof);
+    assert_int_equal(rd->len, len);
+    assert_memory_equal(rd->js, data, len);
+
+    /* the end of the input stays the end */
+    assert_int_equal(jsmn_reader_fill(rd), 0);
+    assert_int_equal(rd->len, len);
+}
+
+static void test_reader_01(void **state)
+{
+    (void)state; // unused
+    static unsigned char data[50000];
+    jsmn_reader rd;
+    size_t i;
+    int fd, use_pipe;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (unsigned char)(i * 7 % 251);
+    }
+
+    /* blocks come back in order from a file and from a pipe */
+    for (use_pipe = 0; use_pipe < 2; use_pipe++) {
+        fd = data_fd(data, sizeof(data), use_pipe);
+        assert_int_equal(jsmn_reader_open(&rd, fd, 4096, 4), 0);
+        if (use_pipe) {
+            assert_false(rd.uring);
+        }
+        read_all(&rd, data, sizeof(data));
+        assert_int_equal(rd.in, sizeof(data));
+        jsmn_reader_close(&rd);
+        close(fd);
+
+        /* with blocks that do not divide the input, and a single one in flight */
+        fd = data_fd(data, sizeof(data), use_pipe);
+        assert_int_equal(jsmn_reader_open(&rd, fd, 13, 1), 0);
+        read_all(&rd, data, sizeof(data));
+        jsmn_reader_close(&rd);
+        close(fd);
+    }
+
+    /* nothing to read */
+    fd = data_fd(data, 0, 0);
+    assert_int_equal(jsmn_reader_open(&rd, fd, 64, 2), 0);
+    read_all(&rd, data, 0);
+    jsmn_reader_close(&rd);
+    close(fd);
+
+    /* a depth or a block size it cannot use */
+    assert_int_equal(jsmn_reader_open(&rd, 0, 64, JSMN_READER_DEPTH + 1), -1);
+    assert_int_equal(jsmn_reader_open(&rd, 0, 0, 1), -1);
+}
+
+static void test_reader_02(void **state)
+{
+    (void)state; // unused
+    const char *data = "0123456789abcdefghijklmnopqrstuvwxyz";
+    jsmn_reader rd;
+    int fd;
+
+    /* what is dropped is gone from the front, the rest follows it */
+    fd = data_fd(data, strlen(data), 0);
+    assert_int_equal(jsmn_reader_open(&rd, fd, 8, 2), 0);
+    assert_int_equal(jsmn_reader_fill(&rd), 8);
+    assert_int_equal(jsmn_reader_fill(&rd), 8);
+    jsmn_reader_drop(&rd, 5);
+    assert_int_equal(rd.len, 11);
+    assert_memory_equal(rd.js, data + 5, 11);
+    while (jsmn_reader_fill(&rd) > 0) {
+        jsmn_reader_drop(&rd, 3);
+    }
+    assert_int_equal(rd.len + 5 + 3 * 3, strlen(data));
+    assert_memory_equal(rd.js, data + 5 + 3 * 3, rd.len);
+
+    /* more than there is drops everything */
+    jsmn_reader_drop(&rd, rd.len + 10);
+    assert_int_equal(rd.len, 0);
+    jsmn_reader_close(&rd);
+    close(fd);
+}
+
+static void test_reader_03(void **state)
+{
+    (void)state; // unused
+    static char js[8192];
+    jsmntok_t tokens[2048];
+    jsmn_parser p;
+    jsmn_reader rd;
+    size_t n = 0;
+    jsmnint_t count;
+    int i, fd;
+
+    n += sprintf(js + n, "{\"values\": [");
+    for (i = 0; i < 500; i++) {
+        n += sprintf(js + n, (i != 0 ? ", %d" : "%d"), i * 1000);
+    }
+    n += sprintf(js + n, "], \"name\": \"a string longer than a block\"}\n");
+    jsmn_init(&p);
+    count = jsmn_parse(&p, js, n, NULL, 0);
+    assert_int_equal(count, 505);
+
+    /* values, keys and strings are cut by the blocks */
+    fd = data_fd(js, n, 1);
+    assert_int_equal(jsmn_reader_open(&rd, fd, 7, 3), 0);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_reader_parse(&rd, &p, tokens, 2048), count);
+    assert_int_equal(tokens[0].end, n - 1);
+    assert_memory_equal(rd.js + tokens[count - 1].start, "a string longer than a block", 28);
+    jsmn_reader_close(&rd);
+    close(fd);
+
+    /* a root number is only complete at the end of the input */
+    fd = data_fd("1234567890", 10, 1);
+    assert_int_equal(jsmn_reader_open(&rd, fd, 3, 2), 0);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_reader_parse(&rd, &p, tokens, 2048), 1);
+    assert_int_equal(tokens[0].start, 0);
+    assert_int_equal(tokens[0].end, 10);
+    jsmn_reader_close(&rd);
+    close(fd);
+
+    /* and a document cut short stays cut short */
+    fd = data_fd("[1, [2", 6, 1);
+    assert_int_equal(jsmn_reader_open(&rd, fd, 4, 2), 0);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_reader_parse(&rd, &p, tokens, 2048), (jsmnint_t)JSMN_ERROR_PART);
+    jsmn_reader_close(&rd);
+    close(fd);
+}
+
+#if defined(JSMN_HAVE_ZLIB) || defined(JSMN_HAVE_ZSTD)
+/**
+ * @brief JSON text that compresses well, with matches longer than a block
+ *
+ * @param[out] js buffer for the text
+ * @param[in] size size of js
+ * @param[in] seed varies the text
+ * @return size_t length of the text
+ */
+static size_t sample(char *js, const size_t size, const int seed)
+{
+    size_t n = 0;
+    int i;
+
+    n += sprintf(js + n, "[");
+    for (i = 0; n + 64 < size; i++) {
+        n += sprintf(js + n, "{\"id\": %d, \"name\": \"record\", \"seed\": %d},\n", i, seed);
+    }
+    n += sprintf(js + n, "null]\n");
+    return n;
+}
+
+/**
+ * @brief Decompress a whole input, checking it against the plain text
+ *
+ * @param[in] z compressed input
+ * @param[in] zlen length of z
+ * @param[in] format format to open with
+ * @param[in] found format the input should be taken for
+ * @param[in] block_size size of the blocks
+ * @param[in] js plain text the input holds
+ * @param[in] len length of js
+ */
+static void decode_all(const void *z, const size_t zlen, const jsmn_compression format,
+                       const jsmn_compression found, const size_t block_size,
+                       const char *js, const size_t len)
+{
+    jsmn_reader rd;
+    int fd;
+
+    fd = data_fd(z, zlen, 0);
+    assert_int_equal(jsmn_reader_open_compressed(&rd, fd, format, block_size, 3), 0);
+    read_all(&rd, js, len);
+    assert_int_equal(rd.format, found);
+    assert_int_equal(rd.in, zlen);
+    jsmn_reader_close(&rd);
+    close(fd);
+}
+
+/**
+ * @brief Decompress an input cut short, which must fail with EIO
+ *
+ * @param[in] z compressed input, cut short
+ * @param[in] zlen length of z
+ * @param[in] block_size size of the blocks
+ * @param[in] js plain text the whole input holds
+ */
+static void decode_cut(const void *z, const size_t zlen, const size_t block_size, const char *js)
+{
+    jsmn_reader rd;
+    long n;
+    int fd;
+
+    fd = data_fd(z, zlen, 0);
+    assert_int_equal(jsmn_reader_open_compressed(&rd, fd, JSMN_READ_AUTO, block_size, 3), 0);
+    while ((n = jsmn_reader_fill(&rd)) > 0) {
+        continue;
+    }
+    assert_int_equal(n, -1);
+    assert_int_equal(rd.error, EIO);
+    assert_false(rd.eof);
+    assert_memory_equal(rd.js, js, rd.len);
+
+    /* the error stays */
+    assert_int_equal(jsmn_reader_fill(&rd), -1);
+    jsmn_reader_close(&rd);
+    close(fd);
+}
+#endif
+
+#if defined(JSMN_HAVE_ZLIB)
+/**
+ * @brief Compress text as one gzip member
+ *
+ * @param[in] js text to compress
+ * @param[in] len length of js
+ * @param[out] z buffer for the member
+ * @param[in] size size of z
+ * @return size_t length of the member
+ */
+static size_t gzip(const char *js, const size_t len, unsigned char *z, const size_t size)
+{
+    z_stream strm;
+
+    memset(&strm, 0, sizeof(strm));
+    assert_int_equal(deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY), Z_OK);
+    strm.next_in = (Bytef *)js;
+    strm.avail_in = (uInt)len;
+    strm.next_out = z;
+    strm.avail_out = (uInt)size;
+    assert_int_equal(deflate(&strm, Z_FINISH), Z_STREAM_END);
+    deflateEnd(&strm);
+    return size - strm.avail_out;
+}
+
+static void test_gunzip_01(void **state)
+{
+    (void)state; // unused
+    static char js[40000];
+    static unsigned char z[40000];
+    const size_t sizes[] = { 13, 4096, 65536 };
+    size_t len, first, zfirst, zlen;
+    unsigned i;
+
+    /* two members, taken one after the other */
+    first = sample(js, 20000, 1);
+    len = first + sample(js + first, 20000, 2);
+    zfirst = zlen = gzip(js, first, z, sizeof(z));
+    zlen += gzip(js + first, len - first, z + zlen, sizeof(z) - zlen);
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        decode_all(z, zlen, JSMN_READ_AUTO, JSMN_READ_GZIP, sizes[i], js, len);
+        decode_all(z, zlen, JSMN_READ_GZIP, JSMN_READ_GZIP, sizes[i], js, len);
+    }
+
+    /* plain text is told from a member */
+    decode_all(js, len, JSMN_READ_AUTO, JSMN_READ_PLAIN, 13, js, len);
+
+    /* a member cut short, in its data and in its trailer */
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        decode_cut(z, zfirst / 2, sizes[i], js);
+        decode_cut(z, zlen - 3, sizes[i], js);
+    }
+}
+#endif
+
+#if defined(JSMN_HAVE_ZSTD)
+static void test_unzstd_01(void **state)
+{
+    (void)state; // unused
+    static char js[40000];
+    static unsigned char z[40000];
+    const size_t sizes[] = { 13, 4096, 65536 };
+    size_t len, first, zfirst, zlen, r;
+    unsigned i;
+
+    /* two frames, taken one after the other */
+    first = sample(js, 20000, 1);
+    len = first + sample(js + first, 20000, 2);
+    zlen = ZSTD_compress(z, sizeof(z), js, first, 19);
+    assert_false(ZSTD_isError(zlen));
+    zfirst = zlen;
+    r = ZSTD_compress(z + zlen, sizeof(z) - zlen, js + first, len - first, 19);
+    assert_false(ZSTD_isError(r));
+    zlen += r;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        decode_all(z, zlen, JSMN_READ_AUTO, JSMN_READ_ZSTD, sizes[i], js, len);
+        decode_all(z, zlen, JSMN_READ_ZSTD, JSMN_READ_ZSTD, sizes[i], js, len);
+    }
+
+    /* plain text is told from a frame */
+    decode_all(js, len, JSMN_READ_AUTO, JSMN_READ_PLAIN, 13, js, len);
+
+    /* a frame cut short, in its data and at its end */
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        decode_cut(z, zfirst / 2, sizes[i], js);
+        decode_cut(z, zlen - 3, sizes[i], js);
+    }
+}
+#endif
+
+void test_reader(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_reader_01),
+        cmocka_unit_test(test_reader_02),
+        cmocka_unit_test(test_reader_03),
+#if defined(JSMN_HAVE_ZLIB)
+        cmocka_unit_test(test_gunzip_01),
+#endif
+#if defined(JSMN_HAVE_ZSTD)
+        cmocka_unit_test(test_unzstd_01),
+#endif
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+
+int main(void)
+{
+    struct CMUnitTest *tests = cur_test = calloc(64, sizeof(struct CMUnitTest));
+
+    test_reader();         // test for reading ahead of the parser
+
+    return _cmocka_run_group_tests("jsmn_reader_test", tests, total_tests, NULL, NULL);
+}
@@ -11,15 +11,73 @@
 #include "jsmn.h"
 
 jsmn_parser p;
+#if defined(JSMN_BLOCK_TOKENS)
+jsmntok_t t_storage[500];
+jsmntok_t *t_dir[500 >> JSMN_BLOCK_SHIFT];
+jsmntok_blocks_t t_blocks = { t_dir, 0, NULL, NULL };
+jsmntok_blocks_t *const t = &t_blocks;
+#elif !defined(JSMN_SOA_TOKENS)
 jsmntok_t t[500];
+#else
+jsmntype_t t_types[500];
+jsmnint_t t_starts[500], t_ends[500], t_sizes[500];
+# if defined(JSMN_PARENT_LINKS)
+jsmnint_t t_parents[500];
+# endif
+# if defined(JSMN_NEXT_SIBLING)
+jsmnint_t t_siblings[500];
+# endif
+jsmntok_soa_t t_soa = {
+    t_types, t_starts, t_ends, t_sizes,
+# if defined(JSMN_PARENT_LINKS)
+    t_parents,
+# endif
+# if defined(JSMN_NEXT_SIBLING)
+    t_siblings,
+# endif
+};
+jsmntok_soa_t *const t = &t_soa;
+#endif
 int total_tests = 0;
 void *cur_test = NULL;
 
+/**
+ * @brief Zero the first n tokens of t
+ *
+ * @param[in] n number of tokens
+ */
+void tokclear(const size_t n)
+{
+#if defined(JSMN_BLOCK_TOKENS)
+    size_t i;
+    for (i = 0; i < sizeof(t_dir) / sizeof(t_dir[0]); i++) {
+        t_dir[i] = t_storage + (i << JSMN_BLOCK_SHIFT);
+    }
+    t_blocks.blocks = t_dir;
+    t_blocks.num_blocks = i;
+    t_blocks.grow = NULL;
+    memset(t_storage, 0, n * sizeof(jsmntok_t));
+#elif !defined(JSMN_SOA_TOKENS)
+    memset(t, 0, n * sizeof(jsmntok_t));
+#else
+    memset(t_types, 0, n * sizeof(jsmntype_t));
+    memset(t_starts, 0, n * sizeof(jsmnint_t));
+    memset(t_ends, 0, n * sizeof(jsmnint_t));
+    memset(t_sizes, 0, n * sizeof(jsmnint_t));
+# if defined(JSMN_PARENT_LINKS)
+    memset(t_parents, 0, n * sizeof(jsmnint_t));
+# endif
+# if defined(JSMN_NEXT_SIBLING)
+    memset(t_siblings, 0, n * sizeof(jsmnint_t));
+# endif
+#endif
+}
+
 int jsmn_setup(void **state)
 {
     (void)state; // unused
     jsmn_init(&p);
-    memset(t, 0, 128 * sizeof(jsmntok_t));
+    tokclear(128);
 
     return 0;
 }
@@ -35,7 +93,7 @@ int jsmn_setup(void **state)
  * @param[in] numtok number of tokens
  * @param[in] ap p_ap:...
  */
-void vtokeq(const char *s, const jsmntok_t *t, const size_t numtok, va_list ap)
+void vtokeq(const char *s, const jsmntokens_t *t, const size_t numtok, va_list ap)
 {
     if (numtok == 0)
         return;
@@ -67,29 +125,31 @@ void vtokeq(const char *s, const jsmntok_t *t, const size_t numtok, va_list ap)
                 break;
             }
         }
-        if (!(t[i].type & type)) {
-            fail_msg("token %zu type is %d, not %d", i, t[i].type, type);
+        jsmnint_t tstart = JSMN_TOK_START(t, i), tend = JSMN_TOK_END(t, i);
+
+        if (!(JSMN_TOK_TYPE(t, i) & type)) {
+            fail_msg("token %zu type is %d, not %d", i, JSMN_TOK_TYPE(t, i), type);
         }
 
         if (start != JSMN_NEG && end != JSMN_NEG) {
-            if (t[i].start != start) {
-                fail_msg("token %zu start is %d, not %d", i, t[i].start, start);
+            if (tstart != start) {
+                fail_msg("token %zu start is %d, not %d", i, tstart, start);
             }
-            if (t[i].end != end) {
-                fail_msg("token %zu end is %d, not %d", i, t[i].end, end);
+            if (tend != end) {
+                fail_msg("token %zu end is %d, not %d", i, tend, end);
             }
         }
 
-        if (size != JSMN_NEG && t[i].size != size) {
-            fail_msg("token %zu size is %d, not %d", i, t[i].size, size);
+        if (size != JSMN_NEG && JSMN_TOK_SIZE(t, i) != size) {
+            fail_msg("token %zu size is %d, not %d", i, JSMN_TOK_SIZE(t, i), size);
         }
 
         if (s != NULL && value != NULL) {
-            const char *p = s + t[i].start;
-            if (strlen(value) != t[i].end - t[i].start ||
-                    strncmp(p, value, t[i].end - t[i].start) != 0) {
+            const char *p = s + tstart;
+            if (strlen(value) != tend - tstart ||
+                    strncmp(p, value, tend - tstart) != 0) {
                 fail_msg("token %zu value is %.*s, not %s",
-                         i, t[i].end - t[i].start, s + t[i].start, value);
+                         i, tend - tstart, s + tstart, value);
             }
         }
     }
@@ -102,7 +162,7 @@ void vtokeq(const char *s, const jsmntok_t *t, const size_t numtok, va_list ap)
  * @param[in] tokens pointer to jsmn tokens
  * @param[in] numtok number of tokens
  */
-void tokeq(const char *s, const jsmntok_t *tokens, const int numtok, ...)
+void tokeq(const char *s, const jsmntokens_t *tokens, const int numtok, ...)
 {
     va_list args;
     va_start(args, numtok);
@@ -2240,7 +2300,9 @@ static void n_structure_object_with_trailing_garbage(void **state)
 {
     (void)state; // unused
     const char *js = "{\"a\": true} \"x\"";
-#if defined(JSMN_MULTIPLE_JSON) || defined(JSMN_MULTIPLE_JSON_FAIL)
+#if defined(JSMN_MULTIPLE_JSON) && !defined(JSMN_PERMISSIVE_RULESET)
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 4);
+#elif defined(JSMN_MULTIPLE_JSON) || defined(JSMN_MULTIPLE_JSON_FAIL)
     assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), (jsmnint_t)JSMN_ERROR_INVAL);
 #else
     assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 3);
@@ -4477,6 +4539,47 @@ static void test_partial_array_02(void **state)
     }
     assert_int_equal(jsmn_parse(&p, js, i, NULL, 0), 6);
 }
+
+static void test_partial_array_03(void **state)
+{
+    (void)state; // unused
+    const char *part[] = { "[-", "[1.", "[-0.5e", "[1E+", "-", "2.", "3e-" };
+    const char *inval[] = { "[1.]", "[-,1]", "[1e, 2]", "1.x" };
+
+    /* A number cut short at the end of the data may still be completed */
+    int i;
+    for (i = 0; i < sizeof(part) / sizeof(part[0]); i++) {
+        jsmn_init(&p);
+        assert_int_equal(jsmn_parse(&p, part[i], strlen(part[i]), t, 4), (jsmnint_t)JSMN_ERROR_PART);
+        jsmn_init(&p);
+        assert_int_equal(jsmn_parse(&p, part[i], strlen(part[i]), NULL, 0), (jsmnint_t)JSMN_ERROR_PART);
+    }
+    /* but not once something else follows it */
+    for (i = 0; i < sizeof(inval) / sizeof(inval[0]); i++) {
+        jsmn_init(&p);
+        assert_int_equal(jsmn_parse(&p, inval[i], strlen(inval[i]), t, 4), (jsmnint_t)JSMN_ERROR_INVAL);
+    }
+}
+
+static void test_partial_array_04(void **state)
+{
+    (void)state; // unused
+    const char *js = "[ 1, 10000000000, -0.5e10, [\"x\", 1000000000]]";
+
+    int i;
+    for (i = 1; i < strlen(js); i++) {
+        assert_int_equal(jsmn_parse(&p, js, i, t, 7), (jsmnint_t)JSMN_ERROR_PART);
+    }
+    assert_int_equal(jsmn_parse(&p, js, i, t, 7), 7);
+    tokeq(js, t, 7,
+          JSMN_ARRAY, 0, 45, 4,
+          JSMN_PRIMITIVE, "1",
+          JSMN_PRIMITIVE, "10000000000",
+          JSMN_PRIMITIVE, "-0.5e10",
+          JSMN_ARRAY, 27, 44, 2,
+          JSMN_STRING, "x", 0,
+          JSMN_PRIMITIVE, "1000000000");
+}
 #endif
 
 void test_partial_array(void)
@@ -4485,6 +4588,8 @@ void test_partial_array(void)
 #if !defined(JSMN_PERMISSIVE)
         cmocka_unit_test_setup(test_partial_array_01, jsmn_setup),
         cmocka_unit_test_setup(test_partial_array_02, jsmn_setup),
+        cmocka_unit_test_setup(test_partial_array_03, jsmn_setup),
+        cmocka_unit_test_setup(test_partial_array_04, jsmn_setup),
 #endif
     };
 
@@ -4494,6 +4599,45 @@ void test_partial_array(void)
 //  return cmocka_run_group_tests_name("test partial array reading", tests, NULL, NULL);
 }
 
+static void test_partial_primitive_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "123456\n\"x\"";
+
+    /* The number goes on in the next chunk, the newline in the one after ends it */
+    assert_int_equal(jsmn_parse(&p, js, 3, t, 4), 1);
+    assert_int_equal(jsmn_parse(&p, js, 6, t, 4), 1);
+    assert_int_equal(jsmn_parse(&p, js, 7, t, 4), 1);
+    tokeq(js, t, 1,
+          JSMN_PRIMITIVE, "123456");
+#if defined(JSMN_MULTIPLE_JSON)
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 4), 2);
+    tokeq(js, t, 2,
+          JSMN_PRIMITIVE, "123456",
+          JSMN_STRING, "x", 0);
+#elif defined(JSMN_MULTIPLE_JSON_FAIL)
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 4), (jsmnint_t)JSMN_ERROR_INVAL);
+#else
+    /* The next document is left for another parser */
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 4), 1);
+    assert_int_equal(p.pos, 7);
+#endif
+}
+
+void test_partial_primitive(void)
+{
+    const struct CMUnitTest tests[] = {
+#if !defined(JSMN_PERMISSIVE)
+        cmocka_unit_test_setup(test_partial_primitive_01, jsmn_setup),
+#endif
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+//  return cmocka_run_group_tests_name("test partial primitive reading", tests, NULL, NULL);
+}
+
 static void test_array_nomem_01(void **state)
 {
     (void)state; // unused
@@ -4502,7 +4646,7 @@ static void test_array_nomem_01(void **state)
     int i;
     for (i = 0; i < 6; i++) {
         jsmn_init(&p);
-        memset(t, 0, 6 * sizeof(jsmntok_t));
+        tokclear(6);
         assert_int_equal(jsmn_parse(&p, js, strlen(js), t, i), (jsmnint_t)JSMN_ERROR_NOMEM);
         assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 6), 6);
         tokeq(js, t, 6,
@@ -4984,13 +5128,13 @@ void test_object_key(void)
 void test_length_01(void **state)
 {
     (void)state; // unused
-    assert_int_equal(jsmn_parse(&p, "", ((jsmnint_t)JSMN_ERROR_MAX), NULL, 0), (jsmnint_t)JSMN_ERROR_LENGTH);
+    assert_int_equal(jsmn_parse(&p, "", ((jsmnpos_t)JSMN_ERROR_MAX), NULL, 0), (jsmnint_t)JSMN_ERROR_LENGTH);
 }
 
 void test_length_02(void **state)
 {
     (void)state; // unused
-    assert_int_equal(jsmn_parse(&p, "", ((size_t)((jsmnint_t)-1)) + 1, NULL, 0), (jsmnint_t)JSMN_ERROR_LENGTH);
+    assert_int_equal(jsmn_parse(&p, "", ((size_t)((jsmnpos_t)-1)) + 1, NULL, 0), (jsmnint_t)JSMN_ERROR_LENGTH);
 }
 
 void test_length(void)
@@ -5006,48 +5150,1695 @@ void test_length(void)
 //  return cmocka_run_group_tests_name("test for non-strict mode", tests, NULL, NULL);
 }
 
+#if defined(JSMN_SEGMENTED_TOKENS)
+static char *segmented_json(const size_t pad, const char *inner)
+{
+    size_t inner_len = strlen(inner);
+    char *js = malloc(2 * pad + inner_len + 3);
+
+    js[0] = '[';
+    memset(js + 1, ' ', pad);
+    memcpy(js + 1 + pad, inner, inner_len);
+    memset(js + 1 + pad + inner_len, ' ', pad);
+    strcpy(js + 1 + 2 * pad + inner_len, "]");
+    return js;
+}
+
+static void test_segmented_01(void **state)
+{
+    (void)state; // unused
+    char *js = segmented_json(70000, "\"abc\", 1, {\"k\": [true]}");
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 7);
+    assert_int_equal(p.segment, 2);
+
+    assert_int_equal(JSMN_TOK_POS_START(&p, t, 0), 0);
+    assert_int_equal(JSMN_TOK_POS_END(&p, t, 0), 140025);
+    assert_int_equal(JSMN_TOK_POS_START(&p, t, 1), 70002);
+    assert_int_equal(JSMN_TOK_POS_END(&p, t, 1), 70005);
+    assert_int_equal(JSMN_TOK_POS_START(&p, t, 2), 70008);
+    assert_int_equal(JSMN_TOK_POS_START(&p, t, 3), 70011);
+    assert_int_equal(JSMN_TOK_POS_END(&p, t, 3), 70024);
+    assert_int_equal(JSMN_TOK_POS_START(&p, t, 6), 70018);
+    assert_int_equal(JSMN_TOK_POS_END(&p, t, 6), 70022);
+    assert_int_equal(t[0].start, 0);
+    assert_int_equal(t[6].start, 70018 - p.segments[1]);
+    free(js);
+}
+
+static void test_segmented_02(void **state)
+{
+    (void)state; // unused
+    char *js = malloc(70004);
+
+    /* a string longer than a segment can reach */
+    js[0] = '[';
+    js[1] = '"';
+    memset(js + 2, 'a', 69999);
+    strcpy(js + 70001, "\"]");
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 2);
+    assert_int_equal(JSMN_TOK_POS_START(&p, t, 1), 2);
+    assert_int_equal(JSMN_TOK_POS_END(&p, t, 1), 70001);
+    assert_int_equal(JSMN_TOK_POS_END(&p, t, 0), 70003);
+    assert_int_equal(t[1].start_segment, 0);
+    assert_int_equal(t[1].end_segment, 1);
+    free(js);
+}
+
+static void test_segmented_03(void **state)
+{
+    (void)state; // unused
+    char *js = segmented_json(70000, "1");
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 2);
+    free(js);
+}
+
+void test_segmented(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_segmented_01, jsmn_setup),
+        cmocka_unit_test_setup(test_segmented_02, jsmn_setup),
+        cmocka_unit_test_setup(test_segmented_03, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_BLOCK_TOKENS)
+static jsmntok_t *block_pool[3];
+static size_t block_pool_left;
+
+static int block_grow(jsmntok_blocks_t *tokens)
+{
+    if (block_pool_left == 0) {
+        return 0;
+    }
+    tokens->blocks[tokens->num_blocks] = block_pool[--block_pool_left];
+    tokens->num_blocks++;
+    return 1;
+}
+
+static void test_blocks_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "[1,2,3,4,5,6,7,8,9,10]";
+    jsmntok_t *dir[3];
+    jsmntok_blocks_t tokens = { dir, 0, block_grow, NULL };
+
+    block_pool[0] = t_storage + (2 << JSMN_BLOCK_SHIFT);
+    block_pool[1] = t_storage + (1 << JSMN_BLOCK_SHIFT);
+    block_pool[2] = t_storage;
+    block_pool_left = 3;
+
+    /* every block is appended by the parser */
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), &tokens, 500), 11);
+    assert_int_equal(tokens.num_blocks, 3);
+    tokeq(js, &tokens, 11,
+                JSMN_ARRAY, 0, 22, 10,
+                JSMN_PRIMITIVE, "1",
+                JSMN_PRIMITIVE, "2",
+                JSMN_PRIMITIVE, "3",
+                JSMN_PRIMITIVE, "4",
+                JSMN_PRIMITIVE, "5",
+                JSMN_PRIMITIVE, "6",
+                JSMN_PRIMITIVE, "7",
+                JSMN_PRIMITIVE, "8",
+                JSMN_PRIMITIVE, "9",
+                JSMN_PRIMITIVE, "10");
+}
+
+static void test_blocks_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[1,2,3,4,5,6,7,8,9,10]";
+    jsmntok_t *dir[3];
+    jsmntok_blocks_t tokens = { dir, 0, block_grow, NULL };
+
+    block_pool[0] = t_storage + (1 << JSMN_BLOCK_SHIFT);
+    block_pool[1] = t_storage;
+    block_pool_left = 2;
+
+    /* out of blocks, then resumed once the caller appended one */
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), &tokens, 500), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(p.toknext, 2 << JSMN_BLOCK_SHIFT);
+
+    dir[tokens.num_blocks++] = t_storage + (2 << JSMN_BLOCK_SHIFT);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), &tokens, 500), 11);
+    assert_ptr_equal(tokens.blocks[0], t_storage);
+    tokeq(js, &tokens, 11,
+                JSMN_ARRAY, 0, 22, 10,
+                JSMN_PRIMITIVE, "1",
+                JSMN_PRIMITIVE, "2",
+                JSMN_PRIMITIVE, "3",
+                JSMN_PRIMITIVE, "4",
+                JSMN_PRIMITIVE, "5",
+                JSMN_PRIMITIVE, "6",
+                JSMN_PRIMITIVE, "7",
+                JSMN_PRIMITIVE, "8",
+                JSMN_PRIMITIVE, "9",
+                JSMN_PRIMITIVE, "10");
+}
+
+static void test_blocks_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "[1,2,3,[4]]";
+    jsmntok_t *dir[2];
+    jsmntok_blocks_t tokens = { dir, 1, NULL, NULL };
+
+    dir[0] = t_storage;
+
+    /* a container is the first token that does not fit */
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), &tokens, 500), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(p.toknext, 1 << JSMN_BLOCK_SHIFT);
+
+    dir[tokens.num_blocks++] = t_storage + (1 << JSMN_BLOCK_SHIFT);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), &tokens, 500), 6);
+    tokeq(js, &tokens, 6,
+                JSMN_ARRAY, 0, 11, 4,
+                JSMN_PRIMITIVE, "1",
+                JSMN_PRIMITIVE, "2",
+                JSMN_PRIMITIVE, "3",
+                JSMN_ARRAY, 7, 10, 1,
+                JSMN_PRIMITIVE, "4");
+}
+
+void test_blocks(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_blocks_01, jsmn_setup),
+        cmocka_unit_test_setup(test_blocks_02, jsmn_setup),
+        cmocka_unit_test_setup(test_blocks_03, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
 #if !defined(JSMN_PERMISSIVE)
-# if defined(JSMN_LOW_MEMORY)
-#  define JSMN_TEST_GROUP "jsmn_test_default_low_memory"
-# elif defined(JSMN_MULTIPLE_JSON_FAIL)
-#  define JSMN_TEST_GROUP "jsmn_test_default_mult_json_fail"
-# else
-#  define JSMN_TEST_GROUP "jsmn_test_default"
-# endif
+static void test_validate_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": [1, -2.5e3, true, null], \"b\": {\"c\": \"a long string \\\"with\\\" escapes \\u00e9\"}}  ";
+    jsmnpos_t error;
+
+    assert_int_equal(jsmn_validate(js, strlen(js), &error), JSMN_SUCCESS);
+    assert_int_equal(jsmn_validate("\"x\"", 3, NULL), JSMN_SUCCESS);
+    assert_int_equal(jsmn_validate("12", 2, NULL), JSMN_SUCCESS);
+}
+
+static void test_validate_02(void **state)
+{
+    (void)state; // unused
+    jsmnpos_t error;
+
+    assert_int_equal(jsmn_validate("{\"a\" 1}", 7, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 5);
+    assert_int_equal(jsmn_validate("[1, 02]", 7, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 4);
+    assert_int_equal(jsmn_validate("[{]", 3, &error), (jsmnint_t)JSMN_ERROR_BRACKETS);
+    assert_int_equal(error, 2);
+    assert_int_equal(jsmn_validate("{\"a\": \"b", 8, &error), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(error, 8);
+    /* a second root value is an error, even with JSMN_MULTIPLE_JSON */
+    assert_int_equal(jsmn_validate("[1] 2", 5, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 4);
+    assert_int_equal(jsmn_validate("1 2", 3, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 2);
+    assert_int_equal(jsmn_validate("{} []", 5, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 3);
+    assert_int_equal(jsmn_validate("\"a\" \"b\"", 7, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 4);
+    assert_int_equal(jsmn_validate("[1] \n ", 6, &error), JSMN_SUCCESS);
+    assert_int_equal(jsmn_validate("   ", 3, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+}
+
+static void test_validate_03(void **state)
+{
+    (void)state; // unused
+    char js[2 * JSMN_VALIDATE_DEPTH + 2];
+    jsmnpos_t error;
+
+    /* far deeper than the 32 levels jsmn_parse can count without tokens */
+    memset(js, '[', JSMN_VALIDATE_DEPTH);
+    memset(js + JSMN_VALIDATE_DEPTH, ']', JSMN_VALIDATE_DEPTH);
+    assert_int_equal(jsmn_validate(js, 2 * JSMN_VALIDATE_DEPTH, &error), JSMN_SUCCESS);
+
+    memset(js, '[', JSMN_VALIDATE_DEPTH + 1);
+    memset(js + JSMN_VALIDATE_DEPTH + 1, ']', JSMN_VALIDATE_DEPTH + 1);
+    assert_int_equal(jsmn_validate(js, 2 * JSMN_VALIDATE_DEPTH + 2, &error), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(error, JSMN_VALIDATE_DEPTH);
+}
+#endif
+
+#if defined(JSMN_PERMISSIVE)
+static void test_validate_04(void **state)
+{
+    (void)state; // unused
+    jsmnpos_t error;
+
+    /* jsmn_validate agrees with jsmn_parse on a root KEY */
+    assert_int_equal(jsmn_parse(&p, "[]:", 3, t, 10), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(jsmn_validate("[]:", 3, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 2);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, "false:\n", 7, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_validate("false:\n", 7, &error), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(error, 7);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, "1:2", 3, t, 10), 2);
+    assert_int_equal(jsmn_validate("1:2", 3, NULL), JSMN_SUCCESS);
+}
+#endif
+
+void test_validate(void)
+{
+    const struct CMUnitTest tests[] = {
+#if !defined(JSMN_PERMISSIVE)
+        cmocka_unit_test_setup(test_validate_01, jsmn_setup),
+        cmocka_unit_test_setup(test_validate_02, jsmn_setup),
+        cmocka_unit_test_setup(test_validate_03, jsmn_setup),
 #else
-# if defined(JSMN_LOW_MEMORY)
-#  define JSMN_TEST_GROUP "jsmn_test_permissive_low_memory"
-# elif defined(JSMN_MULTIPLE_JSON_FAIL)
-#  define JSMN_TEST_GROUP "jsmn_test_permissive_mult_json_fail"
-# else
-#  define JSMN_TEST_GROUP "jsmn_test_permissive"
-# endif
+        cmocka_unit_test_setup(test_validate_04, jsmn_setup),
 #endif
+    };
 
-int main(void)
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+
+#if defined(JSMN_TRUSTED)
+static void test_trusted_01(void **state)
 {
-    struct CMUnitTest *tests = cur_test = calloc(512, sizeof(struct CMUnitTest));
-    test_empty();          // test for a empty JSON objects/arrays
-    test_object();         // test for a JSON objects
-    test_array();          // test for a JSON arrays
-    test_primitive();      // test primitive JSON data types
-    test_string();         // test string JSON data types
+    (void)state; // unused
+    const char *js = "{\"a\": [-1.5e3, 0, true, false, null], \"b\\\"\": \"x\\u00e9\\n\", \"c\": {\"d\": -7}}";
+    jsmntok_t checked[16];
+    jsmnint_t i;
 
-    test_partial_string(); // test partial JSON string parsing
-    test_partial_array();  // test partial array reading
-    test_array_nomem();    // test array reading with a smaller number of tokens
-    test_unquoted_keys();  // test unquoted keys (like in JavaScript)
-    test_input_length();   // test strings that are not null-terminated
-    test_issues();         // test issues
-    test_count();          // test tokens count estimation
-    test_nonstrict();      // test for non-strict mode
-    test_unmatched_brackets(); // test for unmatched brackets
-    test_object_key();     // test for key type
-    test_length();         // test for length
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 16), 14);
+    jsmn_init(&p);
+    p.trusted = JSMN_FALSE;
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), checked, 16), 14);
+
+    /* valid input gets the same tokens, JSMN_PRI_* bits included */
+    for (i = 0; i < 14; i++) {
+        assert_int_equal(t[i].type, checked[i].type);
+        assert_int_equal(t[i].start, checked[i].start);
+        assert_int_equal(t[i].end, checked[i].end);
+        assert_int_equal(t[i].size, checked[i].size);
+    }
+}
 
-    test_jsontestsuite_i();
-    test_jsontestsuite_n();
-    test_jsontestsuite_y();
+static void test_trusted_02(void **state)
+{
+    (void)state; // unused
+
+    /* checks are back when trusted is cleared */
+    p.trusted = JSMN_FALSE;
+    assert_int_equal(jsmn_parse(&p, "[1 2]", 5, t, 10), (jsmnint_t)JSMN_ERROR_INVAL);
+
+    /* jsmn_validate always checks */
+    assert_int_equal(jsmn_validate("[1 2]", 5, NULL), (jsmnint_t)JSMN_ERROR_INVAL);
+}
+
+static void test_trusted_03(void **state)
+{
+    (void)state; // unused
+
+    /* missing data is still reported */
+    assert_int_equal(jsmn_parse(&p, "[tru", 4, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, "[\"ab", 4, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, "[true", 5, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_parse(&p, "[true]", 6, t, 10), 2);
+}
+
+void test_trusted(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_trusted_01, jsmn_setup),
+        cmocka_unit_test_setup(test_trusted_02, jsmn_setup),
+        cmocka_unit_test_setup(test_trusted_03, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_LAZY_TOKENS)
+static void test_lazy_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":{\"b\":[1,2,{\"c\":\"}\"}]},\"d\":[3],\"e\":1}";
+    p.max_depth = 1;
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 7);
+    tokeq(js, t, 7,
+          JSMN_OBJECT, 0, 41, 3,
+          JSMN_STRING, "a", 1,
+          JSMN_OBJECT, 5, 26, 0,
+          JSMN_STRING, "d", 1,
+          JSMN_ARRAY, 31, 34, 0,
+          JSMN_STRING, "e", 1,
+          JSMN_PRIMITIVE, "1");
+    assert_false(JSMN_TOK_TYPE(t, 0) & JSMN_UNEXPANDED);
+    assert_true(JSMN_TOK_TYPE(t, 2) & JSMN_UNEXPANDED);
+    assert_true(JSMN_TOK_TYPE(t, 4) & JSMN_UNEXPANDED);
+
+    jsmn_init(&p);
+    p.max_depth = 1;
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 7);
+}
+
+static void test_lazy_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":{\"b\":[1,2,{\"c\":\"}\"}]},\"d\":[3],\"e\":1}";
+    jsmn_parser sp;
+    jsmntok_t sub[8];
+
+    p.max_depth = 1;
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 7);
+
+    /* expanded tokens keep their position in js */
+    jsmn_init(&sp);
+    assert_int_equal(jsmn_expand(&sp, js, t, 2, sub, 4), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(jsmn_expand(&sp, js, t, 2, sub, 8), 8);
+    tokeq(js, sub, 8,
+          JSMN_OBJECT, 5, 26, 1,
+          JSMN_STRING, "b", 1,
+          JSMN_ARRAY, 10, 25, 3,
+          JSMN_PRIMITIVE, "1",
+          JSMN_PRIMITIVE, "2",
+          JSMN_OBJECT, 15, 24, 1,
+          JSMN_STRING, "c", 1,
+          JSMN_STRING, "}", 0);
+
+    /* and can be lazy again */
+    jsmn_init(&sp);
+    sp.max_depth = 1;
+    assert_int_equal(jsmn_expand(&sp, js, t, 2, sub, 8), 3);
+    assert_true(sub[2].type & JSMN_UNEXPANDED);
+    assert_int_equal(sub[2].end, 25);
+
+    jsmn_init(&sp);
+    assert_int_equal(jsmn_expand(&sp, js, t, 1, sub, 8), (jsmnint_t)JSMN_ERROR_INVAL);
+}
+
+static void test_lazy_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "[\"\\\"]\\\\[{\", {\"long string with ] and } inside\": [[[]]]}, \"x\"]";
+    p.max_depth = 1;
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 4);
+    tokeq(js, t, 4,
+          JSMN_ARRAY, 0, 61, 3,
+          JSMN_STRING, "\\\"]\\\\[{", 0,
+          JSMN_OBJECT, 12, 55, 0,
+          JSMN_STRING, "x", 0);
+
+    jsmn_init(&p);
+    p.max_depth = 0;
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 1);
+    tokeq(js, t, 1,
+          JSMN_ARRAY, 0, 61, 0);
+}
+
+static void test_lazy_04(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":{\"b\":[1,2,{\"c\":\"}\"}]},\"d\":[3],\"e\":1}";
+
+    /* an unexpanded container cut short is picked up again */
+    p.max_depth = 1;
+    assert_int_equal(jsmn_parse(&p, js, 20, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 7);
+    assert_true(JSMN_TOK_TYPE(t, 2) & JSMN_UNEXPANDED);
+
+    jsmn_init(&p);
+    p.max_depth = 0;
+    assert_int_equal(jsmn_parse(&p, "[1}", 3, t, 10), (jsmnint_t)JSMN_ERROR_BRACKETS);
+}
+
+void test_lazy(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_lazy_01, jsmn_setup),
+        cmocka_unit_test_setup(test_lazy_02, jsmn_setup),
+        cmocka_unit_test_setup(test_lazy_03, jsmn_setup),
+        cmocka_unit_test_setup(test_lazy_04, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_PROJECTION)
+static void test_projection_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"id\":7,\"meta\":{\"a\":1,\"b\":[1,2]},\"items\":[{\"x\":1,\"y\":2},{\"x\":3,\"y\":[5]}],\"name\":\"n\"}";
+    const char *paths[] = { "/id", "/items/1/x", "/meta" };
+
+    assert_int_equal(jsmn_project(&p, paths, 3), JSMN_SUCCESS);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 16), 16);
+    tokeq(js, t, 16,
+          JSMN_OBJECT, 0, 84, 3,
+          JSMN_STRING, "id", 1,
+          JSMN_PRIMITIVE, "7",
+          JSMN_STRING, "meta", 1,
+          JSMN_OBJECT, 15, 32, 2,
+          JSMN_STRING, "a", 1,
+          JSMN_PRIMITIVE, "1",
+          JSMN_STRING, "b", 1,
+          JSMN_ARRAY, 26, 31, 2,
+          JSMN_PRIMITIVE, "1",
+          JSMN_PRIMITIVE, "2",
+          JSMN_STRING, "items", 1,
+          JSMN_ARRAY, 41, 72, 1,
+          JSMN_OBJECT, 56, 71, 1,
+          JSMN_STRING, "x", 1,
+          JSMN_PRIMITIVE, "3");
+
+    jsmn_init(&p);
+    jsmn_project(&p, paths, 3);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 16);
+}
+
+static void test_projection_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[{\"a/b\":[1,{\"c\":2}],\"x~y\":3},4]";
+    const char *paths[] = { "/0/a~1b/1/c", "/0/x~0y", "/2" };
+
+    assert_int_equal(jsmn_project(&p, paths, 3), JSMN_SUCCESS);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 9);
+    tokeq(js, t, 9,
+          JSMN_ARRAY, 0, 31, 1,
+          JSMN_OBJECT, 1, 28, 2,
+          JSMN_STRING, "a/b", 1,
+          JSMN_ARRAY, 8, 19, 1,
+          JSMN_OBJECT, 11, 18, 1,
+          JSMN_STRING, "c", 1,
+          JSMN_PRIMITIVE, "2",
+          JSMN_STRING, "x~y", 1,
+          JSMN_PRIMITIVE, "3");
+
+    /* skipped values are picked up again after JSMN_ERROR_PART and NOMEM */
+    jsmn_init(&p);
+    jsmn_project(&p, paths, 3);
+    assert_int_equal(jsmn_parse(&p, js, 12, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 5), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 9);
+    assert_int_equal(t[8].start, 26);
+}
+
+static void test_projection_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":[1,2],\"b\":{\"c\":3}}";
+    const char *all[] = { "" };
+    const char *bad[] = { "a" };
+
+    /* "" is the whole document */
+    assert_int_equal(jsmn_project(&p, all, 1), JSMN_SUCCESS);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 9);
+
+    jsmn_init(&p);
+    assert_int_equal(jsmn_project(&p, bad, 1), (jsmnint_t)JSMN_ERROR_INVAL);
+
+    /* skipped containers still need their brackets */
+    jsmn_init(&p);
+    jsmn_project(&p, all + 1, 0);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 1);
+    jsmn_init(&p);
+    jsmn_project(&p, all + 1, 0);
+    assert_int_equal(jsmn_parse(&p, "{\"a\":[1}}", 9, t, 10), (jsmnint_t)JSMN_ERROR_BRACKETS);
+}
+
+void test_projection(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_projection_01, jsmn_setup),
+        cmocka_unit_test_setup(test_projection_02, jsmn_setup),
+        cmocka_unit_test_setup(test_projection_03, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_COMPACT_ARRAYS)
+static void test_compact_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":[1,-2.5,3e2],\"b\":[1,\"x\",2],\"c\":[],\"d\":[[1,2],[3]]}";
+    jsmnint_t offsets[16];
+    jsmntok_t element;
+
+    jsmn_compact(&p, offsets, 16);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 16), 14);
+    tokeq(js, t, 14,
+          JSMN_OBJECT, 0, 55, 4,
+          JSMN_STRING, "a", 1,
+          JSMN_ARRAY, 5, 17, 0,
+          JSMN_STRING, "b", 1,
+          JSMN_ARRAY, 22, 31, 3,
+          JSMN_PRIMITIVE, "1",
+          JSMN_STRING, "x", 0,
+          JSMN_PRIMITIVE, "2",
+          JSMN_STRING, "c", 1,
+          JSMN_ARRAY, 36, 38, 0,
+          JSMN_STRING, "d", 1,
+          JSMN_ARRAY, 43, 54, 2,
+          JSMN_ARRAY, 44, 49, 0,
+          JSMN_ARRAY, 50, 53, 0);
+
+    /* only the arrays holding nothing but numbers are compact */
+    assert_true(t[2].type & JSMN_COMPACT);
+    assert_false(t[4].type & JSMN_COMPACT);
+    assert_false(t[9].type & JSMN_COMPACT);
+    assert_false(t[11].type & JSMN_COMPACT);
+    assert_true(t[12].type & JSMN_COMPACT);
+    assert_true(t[13].type & JSMN_COMPACT);
+    assert_int_equal(p.offnext, 9);
+
+    assert_int_equal(jsmn_array_size(&p, t, 2), 3);
+    assert_int_equal(jsmn_array_element(&p, js, t, 2, 1, &element), JSMN_NEG);
+    assert_int_equal(element.type, JSMN_PRIMITIVE | JSMN_VALUE | JSMN_PRI_MINUS | JSMN_PRI_DECIMAL);
+    assert_int_equal(element.start, 8);
+    assert_int_equal(element.end, 12);
+    assert_int_equal(jsmn_array_element(&p, js, t, 2, 3, &element), JSMN_NEG);
+    assert_int_equal(element.type, JSMN_UNDEFINED);
+}
+
+static void test_compact_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[10,20,30,40]";
+    jsmnint_t offsets[8];
+
+    /* a full table gives the elements tokens instead */
+    jsmn_compact(&p, offsets, 3);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 8), 5);
+    tokeq(js, t, 5,
+          JSMN_ARRAY, 0, 13, 4,
+          JSMN_PRIMITIVE, "10",
+          JSMN_PRIMITIVE, "20",
+          JSMN_PRIMITIVE, "30",
+          JSMN_PRIMITIVE, "40");
+    assert_false(t[0].type & JSMN_COMPACT);
+    assert_int_equal(p.offnext, 0);
+
+    /* a number cut short is parsed again with the next chunk */
+    jsmn_init(&p);
+    jsmn_compact(&p, offsets, 8);
+    assert_int_equal(jsmn_parse(&p, js, 5, t, 8), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 8), 1);
+    assert_true(t[0].type & JSMN_COMPACT);
+    assert_int_equal(offsets[0], 4);
+    assert_int_equal(offsets[4], 10);
+
+    /* not enough tokens for the elements leaves the array compact until there are */
+    jsmn_init(&p);
+    jsmn_compact(&p, offsets, 8);
+    assert_int_equal(jsmn_parse(&p, "[1,2,\"x\"]", 9, t, 2), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(p.toknext, 1);
+    assert_int_equal(jsmn_parse(&p, "[1,2,\"x\"]", 9, t, 8), 4);
+}
+
+static void test_compact_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "[[1,2],{\"a\":[3]},true,4]";
+    jsmnint_t offsets[8];
+    jsmntok_t element;
+
+    jsmn_compact(&p, offsets, 8);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 16), 7);
+
+    /* elements are found the same way whether the array is compact or not */
+    assert_int_equal(jsmn_array_size(&p, t, 0), 4);
+    assert_int_equal(jsmn_array_element(&p, js, t, 0, 1, &element), 2);
+    assert_true(element.type & JSMN_OBJECT);
+    assert_int_equal(jsmn_array_element(&p, js, t, 0, 3, &element), 6);
+    assert_int_equal(element.start, 22);
+    assert_int_equal(jsmn_array_element(&p, js, t, 1, 1, &element), JSMN_NEG);
+    assert_int_equal(element.start, 4);
+
+    /* counting gives the tokens without compaction */
+    jsmn_init(&p);
+    jsmn_compact(&p, offsets, 8);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 10);
+}
+
+void test_compact(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_compact_01, jsmn_setup),
+        cmocka_unit_test_setup(test_compact_02, jsmn_setup),
+        cmocka_unit_test_setup(test_compact_03, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_EVENTS)
+static char events[256];
+static jsmntype_t events_type;
+static int events_stop;
+
+static int events_append(const char *prefix, const char *js, jsmnpos_t start, jsmnpos_t end)
+{
+    size_t n = strlen(events);
+    snprintf(events + n, sizeof(events) - n, "%s%.*s ", prefix, (int)(end - start), js + start);
+    return events_stop != 0 && --events_stop == 0;
+}
+
+static int events_begin(void *data, const jsmntype_t type, const jsmnpos_t start)
+{
+    (void)data; // unused
+    (void)start; // unused
+    return events_append((type & JSMN_OBJECT) ? "{" : "[", "", 0, 0);
+}
+
+static int events_end(void *data, const jsmntype_t type, const jsmnpos_t end)
+{
+    (void)data; // unused
+    (void)end; // unused
+    return events_append((type & JSMN_OBJECT) ? "}" : "]", "", 0, 0);
+}
+
+static int events_key(void *data, const char *js, const jsmnpos_t start, const jsmnpos_t end)
+{
+    (void)data; // unused
+    return events_append("k:", js, start, end);
+}
+
+static int events_string(void *data, const char *js, const jsmnpos_t start, const jsmnpos_t end)
+{
+    (void)data; // unused
+    return events_append("s:", js, start, end);
+}
+
+static int events_primitive(void *data, const jsmntype_t type, const char *js,
+                            const jsmnpos_t start, const jsmnpos_t end)
+{
+    (void)data; // unused
+    events_type = type;
+    return events_append("p:", js, start, end);
+}
+
+static const jsmn_handler events_handler = {
+    events_begin, events_end, events_key, events_string, events_primitive, NULL
+};
+
+static void test_events_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": [1, -2.5e3, \"x\"], \"b\": {\"c\": null}, \"d\": []}";
+
+    events[0] = '\0';
+    events_stop = 0;
+    assert_int_equal(jsmn_parse_events(&p, js, strlen(js), &events_handler), 12);
+    assert_string_equal(events, "{ k:a [ p:1 p:-2.5e3 s:x ] k:b { k:c p:null } k:d [ ] } ");
+    assert_int_equal(events_type, JSMN_PRIMITIVE | JSMN_VALUE | JSMN_INSD_OBJ | JSMN_PRI_LITERAL);
+
+    /* the count is the one jsmn_parse gives */
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 12);
+
+    events[0] = '\0';
+    jsmn_init(&p);
+    p.final = JSMN_TRUE;
+    assert_int_equal(jsmn_parse_events(&p, "-2.5e3", 6, &events_handler), 1);
+    assert_string_equal(events, "p:-2.5e3 ");
+    assert_int_equal(events_type, JSMN_PRIMITIVE | JSMN_VALUE | JSMN_PRI_MINUS | JSMN_PRI_DECIMAL | JSMN_PRI_EXPONENT);
+}
+
+static void test_events_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[{\"key\": \"value\", \"n\": 1234}, true, [10, 200]]";
+    size_t i;
+
+    /* every value is reported once, when it is complete */
+    for (i = 1; i <= strlen(js); i++) {
+        events[0] = '\0';
+        events_stop = 0;
+        jsmn_init(&p);
+        assert_int_equal(jsmn_parse_events(&p, js, i, &events_handler), (i < strlen(js) ? (jsmnint_t)JSMN_ERROR_PART : 10));
+        assert_int_equal(jsmn_parse_events(&p, js, strlen(js), &events_handler), 10);
+        assert_string_equal(events, "[ { k:key s:value k:n p:1234 } p:true [ p:10 p:200 ] ] ");
+    }
+}
+
+static void test_events_03(void **state)
+{
+    (void)state; // unused
+    char deep[JSMN_EVENT_DEPTH + 2];
+
+    assert_int_equal(jsmn_parse_events(&p, "[1}", 3, &events_handler), (jsmnint_t)JSMN_ERROR_BRACKETS);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_events(&p, "{1: 2}", 6, &events_handler), (jsmnint_t)JSMN_ERROR_INVAL);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_events(&p, "[1 2]", 5, &events_handler), (jsmnint_t)JSMN_ERROR_INVAL);
+
+    memset(deep, '[', sizeof(deep));
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_events(&p, deep, JSMN_EVENT_DEPTH, &events_handler), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_parse_events(&p, deep, sizeof(deep), &events_handler), (jsmnint_t)JSMN_ERROR_NOMEM);
+
+    /* a callback stops the parse, calling again goes on after its value */
+    events[0] = '\0';
+    events_stop = 2;
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_events(&p, "[1, 2, 3]", 9, &events_handler), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_string_equal(events, "[ p:1 ");
+    assert_int_equal(jsmn_parse_events(&p, "[1, 2, 3]", 9, &events_handler), 4);
+    assert_string_equal(events, "[ p:1 p:2 p:3 ] ");
+}
+
+/* Pulls every event of js, reading size bytes at a time, returns the count */
+static jsmnint_t events_pull(const char *js, const size_t size)
+{
+    char chunk[32];
+    size_t read = 0, used = 0, n;
+    jsmn_iterator it;
+    jsmn_event ev;
+    jsmnint_t r;
+
+    events[0] = '\0';
+    events_stop = 0;
+    jsmn_iterator_init(&it);
+    for (;;) {
+        r = jsmn_next_event(&it, &ev);
+        if (r == (jsmnint_t)JSMN_ERROR_PART) {
+            assert_false(it.parser.final);
+            used = it.len - it.parser.pos;
+            memmove(chunk, it.js + it.parser.pos, used);
+            n = strlen(js) - read;
+            if (n > size) {
+                n = size;
+            }
+            assert_true(used + n <= sizeof(chunk));
+            if (n == 0) {
+                jsmn_feed(&it, NULL, 0);
+                continue;
+            }
+            memcpy(chunk + used, js + read, n);
+            read += n;
+            jsmn_feed(&it, chunk, used + n);
+            continue;
+        }
+        assert_int_equal(r, JSMN_SUCCESS);
+        if (ev.type == JSMN_UNDEFINED) {
+            break;
+        }
+        if (ev.type & JSMN_CLOSE) {
+            assert_int_equal(ev.start, JSMN_POS_NEG);
+            assert_int_equal(js[it.offset + ev.end - 1], (ev.type & JSMN_OBJECT) ? '}' : ']');
+            events_end(NULL, ev.type, 0);
+        } else if (ev.type & JSMN_CONTAINER) {
+            assert_int_equal(ev.end, JSMN_POS_NEG);
+            events_begin(NULL, ev.type, 0);
+        } else if (ev.type & JSMN_KEY) {
+            events_key(NULL, it.js, ev.start, ev.end);
+        } else if (ev.type & JSMN_STRING) {
+            events_string(NULL, it.js, ev.start, ev.end);
+        } else {
+            events_primitive(NULL, ev.type, it.js, ev.start, ev.end);
+        }
+    }
+    assert_int_equal(read, strlen(js));
+    return it.parser.count;
+}
+
+static void test_events_04(void **state)
+{
+    (void)state; // unused
+
+    /* the whole document is read in chunks that cut its values short */
+    assert_int_equal(events_pull("{\"list\": [\"abc\", 123456, {\"x\": false}], \"end\": -1.5}", 12), 10);
+    assert_string_equal(events, "{ k:list [ s:abc p:123456 { k:x p:false } ] k:end p:-1.5 } ");
+
+    /* a root PRIMITIVE is only complete at the end of the input */
+    assert_int_equal(events_pull("123456", 3), 1);
+    assert_string_equal(events, "p:123456 ");
+    assert_int_equal(events_pull(" -1.5e3", 2), 1);
+    assert_string_equal(events, "p:-1.5e3 ");
+}
+
+static void test_events_05(void **state)
+{
+    (void)state; // unused
+
+    /* a root PRIMITIVE at the end of the data may go on */
+    events[0] = '\0';
+    events_stop = 0;
+    assert_int_equal(jsmn_parse_events(&p, "123456", 3, &events_handler), (jsmnint_t)JSMN_ERROR_PART);
+    assert_string_equal(events, "");
+    assert_int_equal(jsmn_parse_events(&p, "123456", 6, &events_handler), (jsmnint_t)JSMN_ERROR_PART);
+    assert_string_equal(events, "");
+    p.final = JSMN_TRUE;
+    assert_int_equal(jsmn_parse_events(&p, "123456", 6, &events_handler), 1);
+    assert_string_equal(events, "p:123456 ");
+
+    /* whitespace ends it without the end of the input */
+    events[0] = '\0';
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_events(&p, "true \n", 6, &events_handler), 1);
+    assert_string_equal(events, "p:true ");
+
+    /* with nothing but whitespace there is no document */
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_events(&p, " ", 1, &events_handler), (jsmnint_t)JSMN_ERROR_PART);
+    p.final = JSMN_TRUE;
+    assert_int_equal(jsmn_parse_events(&p, " ", 1, &events_handler), (jsmnint_t)JSMN_ERROR_INVAL);
+}
+
+void test_events(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_events_01, jsmn_setup),
+        cmocka_unit_test_setup(test_events_02, jsmn_setup),
+        cmocka_unit_test_setup(test_events_03, jsmn_setup),
+        cmocka_unit_test_setup(test_events_04, jsmn_setup),
+        cmocka_unit_test_setup(test_events_05, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_STREAM_ELEMENTS)
+static char stream_seen[256];
+static int stream_stop;
+
+static int stream_element(void *data, const char *js,
+                          const jsmntokens_t *tokens, const jsmnint_t num_tokens)
+{
+    size_t n = strlen(stream_seen);
+    (void)data; // unused
+    assert_true(JSMN_TOK_TYPE(tokens, 0) & JSMN_ARRAY);
+    assert_int_equal(JSMN_TOK_END(tokens, 0), JSMN_NEG);
+#if defined(JSMN_PARENT_LINKS)
+    assert_int_equal(JSMN_TOK_PARENT(tokens, 1), 0);
+#endif
+    snprintf(stream_seen + n, sizeof(stream_seen) - n, "%.*s/%u ",
+             (int)(JSMN_TOK_END(tokens, 1) - JSMN_TOK_START(tokens, 1)),
+             js + JSMN_TOK_START(tokens, 1), (unsigned)num_tokens);
+    return stream_stop;
+}
+
+static void test_stream_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "[{\"a\": [1, 2]}, \"x\", [3, {\"b\": null}], 4]";
+
+    /* the root and the largest element fit, the whole document would not */
+    stream_seen[0] = '\0';
+    stream_stop = 0;
+    jsmn_stream(&p, stream_element, NULL);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 6), 13);
+    assert_string_equal(stream_seen, "{\"a\": [1, 2]}/6 x/2 [3, {\"b\": null}]/6 4/2 ");
+    tokeq(js, t, 1,
+          JSMN_ARRAY, 0, 41, 4);
+    assert_int_equal(p.toknext, 1);
+
+    /* an element too large for the tokens */
+    jsmn_init(&p);
+    jsmn_stream(&p, stream_element, NULL);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 5), (jsmnint_t)JSMN_ERROR_NOMEM);
+}
+
+static void test_stream_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[[1, 2], {\"c\": \"d\"}, true]";
+    size_t i;
+
+    /* elements are passed on once, however the input is split */
+    for (i = 1; i < strlen(js); i++) {
+        stream_seen[0] = '\0';
+        stream_stop = 0;
+        jsmn_init(&p);
+        jsmn_stream(&p, stream_element, NULL);
+        assert_int_equal(jsmn_parse(&p, js, i, t, 4), (jsmnint_t)JSMN_ERROR_PART);
+        assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 4), 8);
+        assert_string_equal(stream_seen, "[1, 2]/4 {\"c\": \"d\"}/4 true/2 ");
+    }
+
+    /* objects and counting keep every token */
+    stream_seen[0] = '\0';
+    jsmn_init(&p);
+    jsmn_stream(&p, stream_element, NULL);
+    assert_int_equal(jsmn_parse(&p, "{\"a\": 1, \"b\": 2}", 16, t, 8), 5);
+    jsmn_init(&p);
+    jsmn_stream(&p, stream_element, NULL);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 8);
+    assert_string_equal(stream_seen, "");
+
+    /* the callback stops the parse */
+    stream_stop = 1;
+    jsmn_init(&p);
+    jsmn_stream(&p, stream_element, NULL);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 4), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_string_equal(stream_seen, "[1, 2]/4 ");
+}
+
+void test_stream(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_stream_01, jsmn_setup),
+        cmocka_unit_test_setup(test_stream_02, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_WINDOW)
+static void test_window_01(void **state)
+{
+    (void)state; // unused
+    char js[32] = "[\"ab\", {\"c\": 12";
+
+    /* a number cut short is kept, everything before it can go */
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 8), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_slide(&p, js, t, 100), 13);
+    assert_int_equal(p.base, 13);
+    assert_int_equal(p.pos, 2);
+    memmove(js, js + 13, strlen(js) - 13 + 1);
+    strcat(js, "3}, 4]");
+    assert_string_equal(js, "123}, 4]");
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 8), 6);
+    tokeq(js, t, 6,
+          JSMN_ARRAY, 0, 8, 3,
+          JSMN_STRING, "", 0,
+          JSMN_OBJECT, 0, 4, 1,
+          JSMN_STRING, "", 1,
+          JSMN_PRIMITIVE, "123",
+          JSMN_PRIMITIVE, "4");
+    assert_int_equal(p.base + t[4].start, 13);
+
+    /* nothing past pos is dropped */
+    jsmn_init(&p);
+    strcpy(js, "{\"key\": \"val");
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 8), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_slide(&p, js, t, 5), 5);
+    assert_int_equal(jsmn_slide(&p, js + 5, t, 100), 3);
+    assert_int_equal(p.base, 8);
+    assert_int_equal(t[1].start, 0);
+    assert_int_equal(t[1].end, 0);
+}
+
+static void test_window_02(void **state)
+{
+    (void)state; // unused
+    const char *stream = "[1, [2, 3], {\"a\": \"bcd\"}, -4.5e6, \"end\"]";
+    char window[16];
+    size_t read = 0, used = 0, n;
+    jsmnpos_t dropped;
+    jsmnint_t r;
+
+    /* the whole stream passes through a buffer shorter than it */
+    stream_seen[0] = '\0';
+    stream_stop = 0;
+    jsmn_stream(&p, stream_element, NULL);
+    for (;;) {
+        n = strlen(stream) - read;
+        if (n > sizeof(window) - used) {
+            n = sizeof(window) - used;
+        }
+        memcpy(window + used, stream + read, n);
+        read += n;
+        used += n;
+        r = jsmn_parse(&p, window, used, t, 8);
+        if (r != (jsmnint_t)JSMN_ERROR_PART) {
+            break;
+        }
+        /* keep the element in progress for the callback */
+        dropped = jsmn_slide(&p, window, t, (p.toknext > 1 ? t[1].start : used));
+        memmove(window, window + dropped, used - dropped);
+        used -= dropped;
+        assert_int_equal(p.base + used, read);
+    }
+    assert_int_equal(r, 10);
+    assert_int_equal(read, strlen(stream));
+    assert_string_equal(stream_seen, "1/2 [2, 3]/4 {\"a\": \"bcd\"}/4 -4.5e6/2 end/2 ");
+}
+
+void test_window(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_window_01, jsmn_setup),
+        cmocka_unit_test_setup(test_window_02, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_IOVEC)
+static void test_iovec_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"name\": \"a string split three ways\", \"n\": [12345, true]}";
+    jsmn_iovec iov[6];
+    char carry[32], buf[40];
+
+    /* buffers that cut a key, a string twice, a number and a literal */
+    iov[0].iov_base = js;      iov[0].iov_len = 4;
+    iov[1].iov_base = js + 4;  iov[1].iov_len = 12;
+    iov[2].iov_base = js + 16; iov[2].iov_len = 14;
+    iov[3].iov_base = js + 30; iov[3].iov_len = 18;
+    iov[4].iov_base = js + 48; iov[4].iov_len = 5;
+    iov[5].iov_base = js + 53; iov[5].iov_len = strlen(js) - 53;
+    assert_int_equal(jsmn_parsev(&p, iov, 6, t, 10, carry, sizeof(carry)), 7);
+    tokeq(js, t, 7,
+          JSMN_OBJECT, -1, -1, 2,
+          JSMN_STRING, "name", 1,
+          JSMN_STRING, "a string split three ways", 0,
+          JSMN_STRING, "n", 1,
+          JSMN_ARRAY, -1, -1, 2,
+          JSMN_PRIMITIVE, "12345",
+          JSMN_PRIMITIVE, "true");
+    assert_int_equal(t[4].parent, 3);
+
+    assert_int_equal(jsmn_iov_copy(iov, 6, t, 2, buf, sizeof(buf)), 25);
+    assert_string_equal(buf, "a string split three ways");
+    assert_int_equal(jsmn_iov_copy(iov, 6, t, 2, buf, 25), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_true(jsmn_iov_equal(iov, 6, t, 5, "12345", 5));
+    assert_false(jsmn_iov_equal(iov, 6, t, 5, "12346", 5));
+    assert_true(jsmn_iov_equal(iov, 6, t, 6, "true", 4));
+    assert_false(jsmn_iov_equal(iov, 6, t, 6, "tru", 3));
+}
+
+static void test_iovec_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[\"abcdefghijklmnopqrstuvwxyz\", 1]";
+    jsmn_iovec iov[3];
+    char carry[16], big[40];
+
+    iov[0].iov_base = js;      iov[0].iov_len = 10;
+    iov[1].iov_base = js + 10; iov[1].iov_len = 15;
+    iov[2].iov_base = js + 25; iov[2].iov_len = strlen(js) - 25;
+
+    /* more buffers may follow */
+    assert_int_equal(jsmn_parsev(&p, iov, 1, t, 10, carry, sizeof(carry)), (jsmnint_t)JSMN_ERROR_PART);
+
+    /* the string spans buffers and does not fit in carry */
+    assert_int_equal(jsmn_parsev(&p, iov, 3, t, 10, carry, sizeof(carry)), (jsmnint_t)JSMN_ERROR_NOMEM);
+
+    /* counting tokens works the same way */
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parsev(&p, iov, 3, NULL, 0, big, sizeof(big)), 3);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parsev(&p, iov, 2, t, 10, big, sizeof(big)), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_parsev(&p, iov, 3, t, 10, big, sizeof(big)), 3);
+    tokeq(js, t, 3,
+          JSMN_ARRAY, 0, 33, 2,
+          JSMN_STRING, "abcdefghijklmnopqrstuvwxyz", 0,
+          JSMN_PRIMITIVE, "1");
+}
+
+void test_iovec(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_iovec_01, jsmn_setup),
+        cmocka_unit_test_setup(test_iovec_02, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_COMMITTED)
+static char closed_seen[256];
+
+static int closed_record(void *data, const char *js,
+                         const jsmntokens_t *tokens, const jsmnint_t token)
+{
+    size_t n = strlen(closed_seen);
+    assert_int_not_equal(JSMN_TOK_END(tokens, token), JSMN_NEG);
+    snprintf(closed_seen + n, sizeof(closed_seen) - n, "%.*s@%u ",
+             (int)(JSMN_TOK_END(tokens, token) - JSMN_TOK_START(tokens, token)),
+             js + JSMN_TOK_START(tokens, token), (unsigned)token);
+    return (data != NULL && strchr(closed_seen, '@') != strrchr(closed_seen, '@'));
+}
+
+static void test_committed_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "[{\"id\": 1}, {\"id\": 23}, \"x\"]";
+
+    assert_int_equal(jsmn_committed(&p, t), 0);
+
+    /* the first record is final, the key waiting for its value is not */
+    assert_int_equal(jsmn_parse(&p, js, 18, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(p.toknext, 6);
+    assert_int_equal(jsmn_committed(&p, t), 5);
+
+    /* a number at the end of the input may go on */
+    assert_int_equal(jsmn_parse(&p, js, 21, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(p.toknext, 7);
+    assert_int_equal(jsmn_committed(&p, t), 6);
+
+    /* open containers do not hold it back */
+    assert_int_equal(jsmn_parse(&p, js, 22, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_committed(&p, t), 7);
+
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 8);
+    assert_int_equal(jsmn_committed(&p, t), 8);
+}
+
+static void test_committed_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[{\"id\": 1}, {\"id\": [2, 3]}, \"x\"]";
+
+    /* containers are passed on as soon as they close, innermost first */
+    closed_seen[0] = '\0';
+    jsmn_on_close(&p, closed_record, NULL);
+    assert_int_equal(jsmn_parse(&p, js, 25, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_string_equal(closed_seen, "{\"id\": 1}@1 [2, 3]@6 ");
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 10);
+    assert_string_equal(closed_seen, "{\"id\": 1}@1 [2, 3]@6 {\"id\": [2, 3]}@4 [{\"id\": 1}, {\"id\": [2, 3]}, \"x\"]@0 ");
+
+    /* returning nonzero stops the parse */
+    closed_seen[0] = '\0';
+    jsmn_init(&p);
+    jsmn_on_close(&p, closed_record, closed_seen);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_string_equal(closed_seen, "{\"id\": 1}@1 [2, 3]@6 ");
+}
+
+void test_committed(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_committed_01, jsmn_setup),
+        cmocka_unit_test_setup(test_committed_02, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_STEPS)
+static void test_steps_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": [1, 2, 3], \"b\": {\"c\": null}, \"d\": -12.5}";
+    jsmnint_t r;
+    int steps = 0;
+
+    /* each call stops after about 8 bytes */
+    while ((r = jsmn_parse_step(&p, js, strlen(js), t, 20, 8)) == (jsmnint_t)JSMN_ERROR_YIELD) {
+        assert_true(p.pos <= (jsmnpos_t)(8 * ++steps));
+    }
+    assert_int_equal(r, 12);
+    assert_int_equal(steps, 6);
+    tokeq(js, t, 12,
+          JSMN_OBJECT, -1, -1, 3,
+          JSMN_STRING, "a", 1,
+          JSMN_ARRAY, -1, -1, 3,
+          JSMN_PRIMITIVE, "1",
+          JSMN_PRIMITIVE, "2",
+          JSMN_PRIMITIVE, "3",
+          JSMN_STRING, "b", 1,
+          JSMN_OBJECT, -1, -1, 1,
+          JSMN_STRING, "c", 1,
+          JSMN_PRIMITIVE, "null",
+          JSMN_STRING, "d", 1,
+          JSMN_PRIMITIVE, "-12.5");
+}
+
+static void test_steps_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[\"a string longer than a step\", 1]";
+
+    /* a value longer than the step is read whole */
+    assert_int_equal(jsmn_parse_step(&p, js, strlen(js), t, 10, 4), (jsmnint_t)JSMN_ERROR_YIELD);
+    assert_int_equal(p.pos, 1);
+    assert_int_equal(jsmn_parse_step(&p, js, strlen(js), t, 10, 4), (jsmnint_t)JSMN_ERROR_YIELD);
+    assert_int_equal(p.pos, 33);
+    assert_int_equal(jsmn_parse_step(&p, js, strlen(js), t, 10, 4), 3);
+
+    /* errors are still errors */
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_step(&p, "[1, 2}", 6, t, 10, 4), (jsmnint_t)JSMN_ERROR_YIELD);
+    assert_int_equal(jsmn_parse_step(&p, "[1, 2}", 6, t, 10, 4), (jsmnint_t)JSMN_ERROR_BRACKETS);
+}
+
+#if defined(JSMN_MULTIPLE_JSON)
+static void test_steps_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "[1] [2] [3]";
+    jsmnint_t r;
+
+    /* a document that ends inside a step is not the end of the input */
+    while ((r = jsmn_parse_step(&p, js, strlen(js), t, 10, 4)) == (jsmnint_t)JSMN_ERROR_YIELD) {
+        assert_true(p.pos < strlen(js));
+    }
+    assert_int_equal(r, 6);
+    assert_int_equal(p.pos, strlen(js));
+    tokeq(js, t, 6,
+          JSMN_ARRAY, 0, 3, 1,
+          JSMN_PRIMITIVE, "1",
+          JSMN_ARRAY, 4, 7, 1,
+          JSMN_PRIMITIVE, "2",
+          JSMN_ARRAY, 8, 11, 1,
+          JSMN_PRIMITIVE, "3");
+}
+#endif
+
+void test_steps(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_steps_01, jsmn_setup),
+        cmocka_unit_test_setup(test_steps_02, jsmn_setup),
+#if defined(JSMN_MULTIPLE_JSON)
+        cmocka_unit_test_setup(test_steps_03, jsmn_setup),
+#endif
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_CHECKPOINTS)
+static void test_checkpoints_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": [1, 2], \"b\": 345}";
+    const char *guess = "{\"a\": [1, 2], \"b\": 3}";
+    jsmn_undo log[8];
+    jsmn_state saved;
+
+    /* the chunk ends in a number that may go on */
+    assert_int_equal(jsmn_parse(&p, js, 20, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_checkpoint(&p, t, &saved, log, 8), JSMN_SUCCESS);
+
+    /* guess how it ends, then take it back */
+    assert_int_equal(jsmn_parse(&p, guess, strlen(guess), t, 10), 7);
+    assert_int_equal(t[0].end, 21);
+    jsmn_rollback(&p, t, &saved);
+    assert_int_equal(p.toknext, 7);
+    assert_int_equal(t[0].end, JSMN_NEG);
+
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 7);
+    tokeq(js, t, 7,
+          JSMN_OBJECT, 0, 23, 2,
+          JSMN_STRING, "a", 1,
+          JSMN_ARRAY, -1, -1, 2,
+          JSMN_PRIMITIVE, "1",
+          JSMN_PRIMITIVE, "2",
+          JSMN_STRING, "b", 1,
+          JSMN_PRIMITIVE, "345");
+}
+
+static void test_checkpoints_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[[1, 2, 3], [4, 5, 6], [7]]";
+    jsmn_undo log[1];
+    jsmn_state saved;
+
+    /* retry with more tokens from where they ran out */
+    assert_int_equal(jsmn_parse(&p, js, 11, t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_checkpoint(&p, t, &saved, log, 1), (jsmnint_t)JSMN_ERROR_NOMEM);
+    jsmn_undo more[8];
+    assert_int_equal(jsmn_checkpoint(&p, t, &saved, more, 8), JSMN_SUCCESS);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 8), (jsmnint_t)JSMN_ERROR_NOMEM);
+    jsmn_rollback(&p, t, &saved);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 12), 11);
+    tokeq(js, t, 11,
+          JSMN_ARRAY, -1, -1, 3,
+          JSMN_ARRAY, -1, -1, 3,
+          JSMN_PRIMITIVE, "1",
+          JSMN_PRIMITIVE, "2",
+          JSMN_PRIMITIVE, "3",
+          JSMN_ARRAY, -1, -1, 3,
+          JSMN_PRIMITIVE, "4",
+          JSMN_PRIMITIVE, "5",
+          JSMN_PRIMITIVE, "6",
+          JSMN_ARRAY, -1, -1, 1,
+          JSMN_PRIMITIVE, "7");
+
+    /* without tokens only the parser is saved */
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, js, 11, NULL, 0), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(jsmn_checkpoint(&p, NULL, &saved, NULL, 0), JSMN_SUCCESS);
+    assert_int_equal(jsmn_parse(&p, "[[1, 2, 3]]]", 12, NULL, 0), (jsmnint_t)JSMN_ERROR_INVAL);
+    jsmn_rollback(&p, NULL, &saved);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 11);
+}
+
+void test_checkpoints(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_checkpoints_01, jsmn_setup),
+        cmocka_unit_test_setup(test_checkpoints_02, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_RECOVERY)
+static void test_recovery_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": 1}\n"
+                     "{\"a\": 2,}\n"
+                     "\n"
+                     "[1, 2]]\n"
+                     "{\"a\": [3\n"
+                     "\"x\"\n";
+    jsmn_bad_record bad[4];
+
+    jsmn_recover(&p, bad, 4);
+    assert_int_equal(jsmn_parse_records(&p, js, strlen(js), t, 10), 4);
+    tokeq(js, t, 4,
+          JSMN_OBJECT, 0, 8, 1,
+          JSMN_STRING, "a", 1,
+          JSMN_PRIMITIVE, "1",
+          JSMN_STRING, "x", 0);
+    assert_int_equal(t[0].next_sibling, 3);
+    assert_int_equal(t[3].parent, JSMN_NEG);
+
+    assert_int_equal(p.badnext, 3);
+    assert_int_equal(bad[0].start, 9);
+    assert_int_equal(bad[0].end, 18);
+    assert_int_equal(bad[0].error, (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(bad[1].start, 20);
+    assert_int_equal(bad[1].end, 27);
+    assert_int_equal(bad[1].error, (jsmnint_t)JSMN_ERROR_INVAL);
+    /* a record has to end on its own line */
+    assert_int_equal(bad[2].start, 28);
+    assert_int_equal(bad[2].end, 36);
+    assert_int_equal(bad[2].error, (jsmnint_t)JSMN_ERROR_PART);
+}
+
+static void test_recovery_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[1]\n[2, }\n[3, 4]\n[5";
+    jsmn_bad_record bad[1];
+
+    /* without a table the first bad line stops the parse at its start */
+    assert_int_equal(jsmn_parse_records(&p, js, strlen(js), t, 10), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(p.pos, 4);
+    assert_int_equal(p.toknext, 2);
+    assert_int_equal(t[0].next_sibling, JSMN_NEG);
+
+    jsmn_recover(&p, bad, 1);
+    /* the last line is cut short, it is parsed again with more data */
+    assert_int_equal(jsmn_parse_records(&p, js, strlen(js), t, 10), (jsmnint_t)JSMN_ERROR_PART);
+    assert_int_equal(p.pos, 17);
+    assert_int_equal(p.toknext, 5);
+    assert_int_equal(p.badnext, 1);
+
+    js = "[1]\n[2, }\n[3, 4]\n[5]";
+    /* out of tokens, the line is parsed again with more */
+    assert_int_equal(jsmn_parse_records(&p, js, strlen(js), t, 6), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(p.pos, 17);
+    assert_int_equal(jsmn_parse_records(&p, js, strlen(js), t, 10), 7);
+    tokeq(js, t, 7,
+          JSMN_ARRAY, -1, -1, 1,
+          JSMN_PRIMITIVE, "1",
+          JSMN_ARRAY, -1, -1, 2,
+          JSMN_PRIMITIVE, "3",
+          JSMN_PRIMITIVE, "4",
+          JSMN_ARRAY, -1, -1, 1,
+          JSMN_PRIMITIVE, "5");
+    assert_int_equal(t[2].next_sibling, 5);
+}
+
+void test_recovery(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_recovery_01, jsmn_setup),
+        cmocka_unit_test_setup(test_recovery_02, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if defined(JSMN_PAIR_TOKENS)
+/**
+ * @brief Check the key stored on an object member's token
+ */
+static void pairkeyeq(const char *js, const jsmnint_t i, const char *key)
+{
+    jsmnint_t key_start = JSMN_TOK_KEY_START(t, i), key_end = JSMN_TOK_KEY_END(t, i);
+
+    assert_true(JSMN_TOK_TYPE(t, i) & JSMN_INSD_OBJ);
+    assert_int_not_equal(key_start, JSMN_NEG);
+    assert_int_equal(key_end - key_start, strlen(key));
+    assert_memory_equal(js + key_start, key, strlen(key));
+}
+
+static void test_pairs_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":0,\"b\":{\"c\":[1,\"x\"]}}";
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 6);
+    tokeq(js, t, 6,
+          JSMN_OBJECT, 0, 25, 2,
+          JSMN_PRIMITIVE, "0",
+          JSMN_OBJECT, 11, 24, 1,
+          JSMN_ARRAY, 16, 23, 2,
+          JSMN_PRIMITIVE, "1",
+          JSMN_STRING, "x", 0);
+    pairkeyeq(js, 1, "a");
+    pairkeyeq(js, 2, "b");
+    pairkeyeq(js, 3, "c");
+    assert_int_equal(JSMN_TOK_KEY_START(t, 0), JSMN_NEG);
+    assert_int_equal(JSMN_TOK_KEY_START(t, 4), JSMN_NEG);
+    assert_false(JSMN_TOK_TYPE(t, 4) & JSMN_INSD_OBJ);
+#if defined(JSMN_PARENT_LINKS)
+    assert_int_equal(JSMN_TOK_PARENT(t, 1), 0);
+    assert_int_equal(JSMN_TOK_PARENT(t, 2), 0);
+    assert_int_equal(JSMN_TOK_PARENT(t, 3), 2);
+    assert_int_equal(JSMN_TOK_PARENT(t, 5), 3);
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+    assert_int_equal(JSMN_TOK_NEXT_SIBLING(t, 1), 2);
+    assert_int_equal(JSMN_TOK_NEXT_SIBLING(t, 2), JSMN_NEG);
+#endif
+}
+
+static void test_pairs_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[{},{\"k\":null},{\"s\":\"v\"}]";
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), NULL, 0), 6);
+
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 10), 6);
+    tokeq(js, t, 6,
+          JSMN_ARRAY, 0, 25, 3,
+          JSMN_OBJECT, 1, 3, 0,
+          JSMN_OBJECT, 4, 14, 1,
+          JSMN_PRIMITIVE, "null",
+          JSMN_OBJECT, 15, 24, 1,
+          JSMN_STRING, "v", 0);
+    pairkeyeq(js, 3, "k");
+    pairkeyeq(js, 5, "s");
+}
+
+static void test_pairs_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\":1,\"bc\":{}}";
+
+    /* the key is kept by the parser until its value gets a token */
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 2), (jsmnint_t)JSMN_ERROR_NOMEM);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), t, 3), 3);
+    tokeq(js, t, 3,
+          JSMN_OBJECT, 0, 15, 2,
+          JSMN_PRIMITIVE, "1",
+          JSMN_OBJECT, 12, 14, 0);
+    pairkeyeq(js, 1, "a");
+    pairkeyeq(js, 2, "bc");
+}
+
+void test_pairs(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_pairs_01, jsmn_setup),
+        cmocka_unit_test_setup(test_pairs_02, jsmn_setup),
+        cmocka_unit_test_setup(test_pairs_03, jsmn_setup),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+#endif
+
+#if !defined(JSMN_PERMISSIVE)
+# if defined(JSMN_LOW_MEMORY)
+#  define JSMN_TEST_GROUP "jsmn_test_default_low_memory"
+# elif defined(JSMN_MULTIPLE_JSON_FAIL)
+#  define JSMN_TEST_GROUP "jsmn_test_default_mult_json_fail"
+# elif defined(JSMN_SOA_TOKENS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_soa"
+# elif defined(JSMN_SEGMENTED_TOKENS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_segmented"
+# elif defined(JSMN_BLOCK_TOKENS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_blocks"
+# elif defined(JSMN_PAIR_TOKENS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_pairs"
+# elif defined(JSMN_PROJECTION)
+#  define JSMN_TEST_GROUP "jsmn_test_default_projection"
+# elif defined(JSMN_COMPACT_ARRAYS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_compact"
+# elif defined(JSMN_EVENTS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_events"
+# elif defined(JSMN_WINDOW)
+#  define JSMN_TEST_GROUP "jsmn_test_default_window"
+# elif defined(JSMN_IOVEC)
+#  define JSMN_TEST_GROUP "jsmn_test_default_iovec"
+# elif defined(JSMN_COMMITTED)
+#  define JSMN_TEST_GROUP "jsmn_test_default_committed"
+# elif defined(JSMN_STEPS) && defined(JSMN_MULTIPLE_JSON)
+#  define JSMN_TEST_GROUP "jsmn_test_default_steps_mult_json"
+# elif defined(JSMN_STEPS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_steps"
+# elif defined(JSMN_CHECKPOINTS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_checkpoints"
+# elif defined(JSMN_RECOVERY)
+#  define JSMN_TEST_GROUP "jsmn_test_default_recovery"
+# elif defined(JSMN_STREAM_ELEMENTS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_stream"
+# elif defined(JSMN_TRUSTED)
+#  define JSMN_TEST_GROUP "jsmn_test_default_trusted"
+# elif defined(JSMN_LAZY_TOKENS)
+#  define JSMN_TEST_GROUP "jsmn_test_default_lazy"
+# else
+#  define JSMN_TEST_GROUP "jsmn_test_default"
+# endif
+#else
+# if defined(JSMN_LOW_MEMORY)
+#  define JSMN_TEST_GROUP "jsmn_test_permissive_low_memory"
+# elif defined(JSMN_MULTIPLE_JSON_FAIL)
+#  define JSMN_TEST_GROUP "jsmn_test_permissive_mult_json_fail"
+# else
+#  define JSMN_TEST_GROUP "jsmn_test_permissive"
+# endif
+#endif
+
+int main(void)
+{
+    struct CMUnitTest *tests = cur_test = calloc(512, sizeof(struct CMUnitTest));
+#if defined(JSMN_TRUSTED)
+    /* tokens for invalid input are unspecified, only valid input is tested */
+    test_jsontestsuite_y();
+    test_trusted();        // test for trusted input
+#elif !defined(JSMN_PAIR_TOKENS)
+    test_empty();          // test for a empty JSON objects/arrays
+    test_object();         // test for a JSON objects
+    test_array();          // test for a JSON arrays
+    test_primitive();      // test primitive JSON data types
+    test_string();         // test string JSON data types
+
+    test_partial_string(); // test partial JSON string parsing
+    test_partial_array();  // test partial array reading
+    test_partial_primitive(); // test a root primitive cut short
+    test_array_nomem();    // test array reading with a smaller number of tokens
+    test_unquoted_keys();  // test unquoted keys (like in JavaScript)
+    test_input_length();   // test strings that are not null-terminated
+    test_issues();         // test issues
+    test_count();          // test tokens count estimation
+    test_nonstrict();      // test for non-strict mode
+    test_unmatched_brackets(); // test for unmatched brackets
+    test_object_key();     // test for key type
+    test_length();         // test for length
+#if defined(JSMN_SEGMENTED_TOKENS)
+    test_segmented();      // test for segmented tokens
+#endif
+#if defined(JSMN_BLOCK_TOKENS)
+    test_blocks();         // test for chunked token blocks
+#endif
+#if defined(JSMN_LAZY_TOKENS)
+    test_lazy();           // test for depth-limited lazy parsing
+#endif
+#if defined(JSMN_PROJECTION)
+    test_projection();     // test for path-projected parsing
+#endif
+#if defined(JSMN_COMPACT_ARRAYS)
+    test_compact();        // test for compact arrays of numbers
+#endif
+#if defined(JSMN_EVENTS)
+    test_events();         // test for callbacks without tokens
+#endif
+#if defined(JSMN_STREAM_ELEMENTS)
+    test_stream();         // test for streaming the elements of a root array
+#endif
+#if defined(JSMN_WINDOW)
+    test_window();         // test for dropping consumed input
+#endif
+#if defined(JSMN_IOVEC)
+    test_iovec();          // test for input held in several buffers
+#endif
+#if defined(JSMN_COMMITTED)
+    test_committed();      // test for tokens final before the input ends
+#endif
+#if defined(JSMN_STEPS)
+    test_steps();          // test for parsing a few bytes per call
+#endif
+#if defined(JSMN_CHECKPOINTS)
+    test_checkpoints();    // test for undoing a parse
+#endif
+#if defined(JSMN_RECOVERY)
+    test_recovery();       // test for skipping bad records
+#endif
+
+    test_jsontestsuite_i();
+    test_jsontestsuite_n();
+    test_jsontestsuite_y();
+#else
+    /* every object member is a single token, the groups above expect keys */
+    test_pairs();          // test for pair tokens
+#endif
+    test_validate();       // test for validation without tokens
 
     return _cmocka_run_group_tests(JSMN_TEST_GROUP, tests, total_tests, NULL, NULL);
 //  return cmocka_run_group_tests(tests, NULL, NULL);
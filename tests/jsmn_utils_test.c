@@ -0,0 +1,648 @@
+#include <stdlib.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <locale.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include "jsmn_utils.h"
+
+int total_tests = 0;
+void *cur_test = NULL;
+
+/**
+ * @brief Parse js into freshly allocated tokens
+ *
+ * @param[in] js json string
+ * @param[out] tokens allocated tokens, release with jsmn_tokens_free()
+ * @return jsmnint_t number of tokens
+ */
+static jsmnint_t tokenize(const char *js, jsmntokens_t **tokens)
+{
+    jsmn_parser p;
+    jsmnint_t r;
+
+    jsmn_init(&p);
+    r = jsmn_parse(&p, js, strlen(js), NULL, 0);
+    assert_true(r < (jsmnint_t)JSMN_ERROR_MAX);
+    *tokens = jsmn_tokens_alloc(r);
+    assert_non_null(*tokens);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse(&p, js, strlen(js), *tokens, r), r);
+    return r;
+}
+
+/**
+ * @brief Pack the tokens of js
+ *
+ * @param[in] js json string
+ * @param[out] tokens tokens of js, release with jsmn_tokens_free()
+ * @param[out] num_tokens number of tokens
+ * @param[out] len size of the packed stream
+ * @return unsigned char* packed stream, release with free()
+ */
+static unsigned char *pack(const char *js, jsmntokens_t **tokens, jsmnint_t *num_tokens, size_t *len)
+{
+    unsigned char *stream;
+
+    *num_tokens = tokenize(js, tokens);
+    *len = jsmn_pack_tokens(*tokens, *num_tokens, NULL, 0);
+    assert_int_not_equal(*len, 0);
+    stream = malloc(*len);
+    assert_non_null(stream);
+    assert_int_equal(jsmn_pack_tokens(*tokens, *num_tokens, stream, *len), *len);
+    return stream;
+}
+
+/**
+ * @brief Check that a decoded token is the one that was packed
+ */
+static void packed_tokeq(const jsmntokens_t *tokens, const jsmnint_t i, const jsmntok_t *tok)
+{
+    assert_int_equal(tok->type, JSMN_TOK_TYPE(tokens, i));
+    assert_int_equal(tok->start, JSMN_TOK_START(tokens, i));
+    assert_int_equal(tok->end, JSMN_TOK_END(tokens, i));
+    assert_int_equal(tok->size, JSMN_TOK_SIZE(tokens, i));
+#if defined(JSMN_PAIR_TOKENS)
+    assert_int_equal(tok->key_start, JSMN_TOK_KEY_START(tokens, i));
+    assert_int_equal(tok->key_end, JSMN_TOK_KEY_END(tokens, i));
+#endif
+#if defined(JSMN_PARENT_LINKS)
+    assert_int_equal(tok->parent, JSMN_TOK_PARENT(tokens, i));
+#endif
+#if defined(JSMN_NEXT_SIBLING)
+    assert_int_equal(tok->next_sibling, JSMN_TOK_NEXT_SIBLING(tokens, i));
+#endif
+}
+
+static void test_pack_01(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": [1, -2.5e3, \"x\", true], \"bc\": {\"d\": null, \"e\": {}}, \"f\": []}";
+    jsmntokens_t *tokens;
+    jsmn_packed_iter it;
+    unsigned char *stream;
+    jsmnint_t n, i;
+    jsmntok_t tok;
+    size_t len;
+
+    /* every token comes back as it was parsed */
+    stream = pack(js, &tokens, &n, &len);
+    jsmn_packed_init(&it, stream, len);
+    for (i = 0; i < n; i++) {
+        assert_int_equal(jsmn_packed_next(&it, &tok), i);
+        packed_tokeq(tokens, i, &tok);
+    }
+    assert_int_equal(jsmn_packed_next(&it, &tok), JSMN_NEG);
+    assert_int_equal(it.error, JSMN_SUCCESS);
+
+    /* a stream too short for the tokens is not written */
+    assert_int_equal(jsmn_pack_tokens(tokens, n, stream, len - 1), 0);
+
+    free(stream);
+    jsmn_tokens_free(tokens);
+}
+
+static void test_pack_02(void **state)
+{
+    (void)state; // unused
+    const char *js = "[[1, [2, 3]], {\"a\": [4]}, 5]";
+    jsmntokens_t *tokens;
+    jsmn_packed_iter it;
+    unsigned char *stream;
+    jsmnint_t n, i, id;
+    jsmntok_t tok;
+    size_t len;
+
+    /* skipping a container lands on its next sibling */
+    stream = pack(js, &tokens, &n, &len);
+    jsmn_packed_init(&it, stream, len);
+    assert_int_equal(jsmn_packed_next(&it, &tok), 0);
+    assert_int_equal(jsmn_packed_next(&it, &tok), 1);
+    jsmn_packed_skip(&it);
+    id = jsmn_packed_next(&it, &tok);
+    assert_true(JSMN_TOK_TYPE(tokens, id) & JSMN_OBJECT);
+    packed_tokeq(tokens, id, &tok);
+    jsmn_packed_skip(&it);
+    id = jsmn_packed_next(&it, &tok);
+    assert_int_equal(js[tok.start], '5');
+    packed_tokeq(tokens, id, &tok);
+    assert_int_equal(id, n - 1);
+    assert_int_equal(jsmn_packed_next(&it, &tok), JSMN_NEG);
+    assert_int_equal(it.error, JSMN_SUCCESS);
+
+    /* skipping a PRIMITIVE changes nothing */
+    jsmn_packed_init(&it, stream, len);
+    assert_int_equal(jsmn_packed_next(&it, &tok), 0);
+    assert_int_equal(jsmn_packed_next(&it, &tok), 1);
+    assert_int_equal(jsmn_packed_next(&it, &tok), 2);
+    jsmn_packed_skip(&it);
+    for (i = 3; i < n; i++) {
+        assert_int_equal(jsmn_packed_next(&it, &tok), i);
+        packed_tokeq(tokens, i, &tok);
+    }
+
+    /* skipping the root is the end of the stream */
+    jsmn_packed_init(&it, stream, len);
+    assert_int_equal(jsmn_packed_next(&it, &tok), 0);
+    jsmn_packed_skip(&it);
+    assert_int_equal(jsmn_packed_next(&it, &tok), JSMN_NEG);
+    assert_int_equal(it.error, JSMN_SUCCESS);
+
+    free(stream);
+    jsmn_tokens_free(tokens);
+}
+
+static void test_pack_03(void **state)
+{
+    (void)state; // unused
+    char js[2 * JSMN_PACKED_DEPTH + 8];
+    jsmntokens_t *tokens;
+    jsmn_packed_iter it;
+    unsigned char *stream;
+    jsmnint_t n, i;
+    jsmntok_t tok;
+    size_t len;
+
+    /* one more open container than the iterator can follow */
+    memset(js, '[', JSMN_PACKED_DEPTH + 1);
+    js[JSMN_PACKED_DEPTH + 1] = '1';
+    memset(js + JSMN_PACKED_DEPTH + 2, ']', JSMN_PACKED_DEPTH + 1);
+    js[2 * JSMN_PACKED_DEPTH + 3] = '\0';
+
+    stream = pack(js, &tokens, &n, &len);
+    jsmn_packed_init(&it, stream, len);
+    for (i = 0; i < JSMN_PACKED_DEPTH; i++) {
+        assert_int_equal(jsmn_packed_next(&it, &tok), i);
+    }
+    assert_int_equal(jsmn_packed_next(&it, &tok), JSMN_NEG);
+    assert_int_equal(it.error, JSMN_ERROR_NOMEM);
+    /* and it stays stopped */
+    assert_int_equal(jsmn_packed_next(&it, &tok), JSMN_NEG);
+
+    free(stream);
+    jsmn_tokens_free(tokens);
+}
+
+static void test_pack_04(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"key\": [100000, \"a longer string\", {\"x\": false}]}";
+    jsmntokens_t *tokens;
+    jsmn_packed_iter it;
+    unsigned char *stream;
+    jsmnint_t n, i;
+    jsmntok_t tok;
+    size_t len, cut;
+
+    /* a truncated stream never passes for a complete one */
+    stream = pack(js, &tokens, &n, &len);
+    for (cut = 1; cut < len; cut++) {
+        jsmn_packed_init(&it, stream, cut);
+        for (i = 0; jsmn_packed_next(&it, &tok) != JSMN_NEG; i++) {
+            assert_true(i < n);
+            packed_tokeq(tokens, i, &tok);
+        }
+        assert_true(it.error == JSMN_ERROR_PART || it.error == JSMN_ERROR_INVAL);
+    }
+
+    free(stream);
+    jsmn_tokens_free(tokens);
+}
+
+void test_pack(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_pack_01),
+        cmocka_unit_test(test_pack_02),
+        cmocka_unit_test(test_pack_03),
+        cmocka_unit_test(test_pack_04),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+
+/**
+ * @brief Decode the root array of js
+ */
+static jsmnint_t to_doubles(const char *js, double *values, const size_t num_values, jsmnint_t *error)
+{
+    jsmntokens_t *tokens;
+    jsmnint_t r;
+
+    tokenize(js, &tokens);
+    r = jsmn_array_to_doubles(js, tokens, 0, values, num_values, error);
+    jsmn_tokens_free(tokens);
+    return r;
+}
+
+static jsmnint_t to_int64(const char *js, int64_t *values, const size_t num_values, jsmnint_t *error)
+{
+    jsmntokens_t *tokens;
+    jsmnint_t r;
+
+    tokenize(js, &tokens);
+    r = jsmn_array_to_int64(js, tokens, 0, values, num_values, error);
+    jsmn_tokens_free(tokens);
+    return r;
+}
+
+static void test_numbers_01(void **state)
+{
+    (void)state; // unused
+    double v[8];
+
+    /* 2^53 is the last mantissa that is always exact */
+    assert_int_equal(to_doubles("[9007199254740992, 9007199254740993, -9007199254740995]", v, 8, NULL), 3);
+    assert_true(v[0] == 9007199254740992.0);
+    assert_true(v[1] == 9007199254740992.0);
+    assert_true(v[2] == -9007199254740996.0);
+
+    /* and 10^22 the last exact power of ten */
+    assert_int_equal(to_doubles("[1e22, 1e23, 1e-22, 1e-23, 8.98846567431158e307, 4.9e-324]", v, 8, NULL), 6);
+    assert_true(v[0] == 1e22);
+    assert_true(v[1] == 1e23);
+    assert_true(v[2] == 1e-22);
+    assert_true(v[3] == 1e-23);
+    assert_true(v[4] == 8.98846567431158e307);
+    assert_true(v[5] == 4.9e-324);
+
+    /* 19 digits fill the mantissa, a 20th is dropped into the exponent */
+    assert_int_equal(to_doubles("[1234567890123456789, 12345678901234567891, 0.12345678901234567891]", v, 8, NULL), 3);
+    assert_true(v[0] == 1234567890123456789.0);
+    assert_true(v[1] == 12345678901234567891.0);
+    assert_true(v[2] == 0.12345678901234567891);
+
+    /* the rounding of a halfway case depends on a digit far past the 19th */
+    assert_int_equal(to_doubles("[9007199254740993.00000000000000000000001, 2.2250738585072011e-308, 0.0]", v, 8, NULL), 3);
+    assert_true(v[0] == 9007199254740994.0);
+    assert_true(v[1] == 2.2250738585072011e-308);
+    assert_true(v[2] == 0.0);
+
+#if !defined(_WIN32)
+    /* a locale with a decimal comma reads the same numbers */
+    if (setlocale(LC_NUMERIC, "de_DE.UTF-8") != NULL) {
+        assert_int_equal(to_doubles("[1.5, 0.1e-30]", v, 8, NULL), 2);
+        assert_true(v[0] == 1.5);
+        assert_true(v[1] == 0.1e-30);
+        setlocale(LC_NUMERIC, "C");
+    }
+#endif
+}
+
+static void test_numbers_02(void **state)
+{
+    (void)state; // unused
+    int64_t v[8];
+    jsmnint_t error = JSMN_NEG;
+
+    assert_int_equal(to_int64("[9223372036854775807, -9223372036854775808, 0, -1]", v, 8, NULL), 4);
+    assert_true(v[0] == INT64_MAX);
+    assert_true(v[1] == INT64_MIN);
+    assert_true(v[2] == 0);
+    assert_true(v[3] == -1);
+
+    /* one past either end is not an int64_t */
+    assert_int_equal(to_int64("[1, 9223372036854775808]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 1);
+    assert_int_equal(to_int64("[-9223372036854775809]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 0);
+    assert_int_equal(to_int64("[1, 2, 12345678901234567890]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 2);
+    assert_int_equal(to_int64("[1, 2.0]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 1);
+    assert_int_equal(to_int64("[1, 1e3]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 1);
+}
+
+static void test_numbers_03(void **state)
+{
+    (void)state; // unused
+    double v[8];
+    jsmnint_t error = JSMN_NEG;
+    jsmntokens_t *tokens;
+    const char *js;
+
+    /* error is the index of the first element that is not a number */
+    assert_int_equal(to_doubles("[1, 2, \"3\", 4]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 2);
+    assert_int_equal(to_doubles("[null]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 0);
+    assert_int_equal(to_doubles("[[1], 2]", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 0);
+    error = JSMN_NEG;
+    assert_int_equal(to_doubles("{\"a\": [1]}", v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 0);
+    assert_int_equal(to_doubles("[ ]", v, 8, NULL), 0);
+    assert_int_equal(to_doubles("[1, 2, 3]", v, 2, NULL), (jsmnint_t)JSMN_ERROR_NOMEM);
+
+    /* the array's text is read as is, whatever the parser let through */
+    js = "[1, 2]";
+    tokenize(js, &tokens);
+    assert_int_equal(jsmn_array_to_doubles("[1,  ]", tokens, 0, v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 1);
+    assert_int_equal(jsmn_array_to_doubles("[1 2 ]", tokens, 0, v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 0);
+    assert_int_equal(jsmn_array_to_doubles("[,1  ]", tokens, 0, v, 8, &error), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_int_equal(error, 0);
+    jsmn_tokens_free(tokens);
+}
+
+void test_numbers(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_numbers_01),
+        cmocka_unit_test(test_numbers_02),
+        cmocka_unit_test(test_numbers_03),
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+
+/**
+ * @brief Check the number of tokens and the text of the root of a document
+ */
+static void doc_eq(const jsmn_doc *doc, const jsmnint_t r, const char *s)
+{
+    jsmn_parser p;
+
+    jsmn_init(&p);
+    assert_int_equal(r, jsmn_parse(&p, s, strlen(s), NULL, 0));
+    assert_int_equal(JSMN_TOK_END(doc->tokens, 0) - JSMN_TOK_START(doc->tokens, 0),
+                     strlen(s) - ((JSMN_TOK_TYPE(doc->tokens, 0) & JSMN_STRING) ? 2 : 0));
+    assert_memory_equal(doc->js + JSMN_TOK_START(doc->tokens, 0) -
+                        ((JSMN_TOK_TYPE(doc->tokens, 0) & JSMN_STRING) ? 1 : 0), s, strlen(s));
+}
+
+/**
+ * @brief Write s to a temporary file and rewind it
+ */
+static FILE *doc_file(const char *s)
+{
+    FILE *fp = tmpfile();
+
+    assert_non_null(fp);
+    assert_int_equal(fwrite(s, 1, strlen(s), fp), strlen(s));
+    rewind(fp);
+    return fp;
+}
+
+static void test_doc_01(void **state)
+{
+    (void)state; // unused
+    char big[2048], js[sizeof(big) + 64];
+    size_t n = 0;
+    jsmn_doc doc;
+    FILE *fp;
+    int i;
+
+    /* several documents, one of them with more tokens than the first allocation */
+    n += sprintf(big + n, "[");
+    for (i = 0; i < 300; i++) {
+        n += sprintf(big + n, (i != 0 ? ",%d" : "%d"), i);
+    }
+    sprintf(big + n, "]");
+    sprintf(js, "[1, 2] {\"a\": {\"b\": [true]}}\n123 \"x\"\n%s  \n", big);
+    fp = doc_file(js);
+
+    jsmn_doc_init(&doc);
+    doc_eq(&doc, jsmn_fparse(fp, &doc), "[1, 2]");
+    doc_eq(&doc, jsmn_fparse(fp, &doc), "{\"a\": {\"b\": [true]}}");
+    doc_eq(&doc, jsmn_fparse(fp, &doc), "123");
+    doc_eq(&doc, jsmn_fparse(fp, &doc), "\"x\"");
+    doc_eq(&doc, jsmn_fparse(fp, &doc), big);
+    assert_true(doc.num_tokens >= 301);
+    assert_int_equal(JSMN_TOK_TYPE(doc.tokens, 300) & JSMN_PRIMITIVE, JSMN_PRIMITIVE);
+    assert_memory_equal(doc.js + JSMN_TOK_START(doc.tokens, 300), "299]", 4);
+
+    /* then only the end of the input, however often it is asked for */
+    assert_int_equal(jsmn_fparse(fp, &doc), 0);
+    assert_int_equal(jsmn_fparse(fp, &doc), 0);
+
+    jsmn_doc_free(&doc);
+    fclose(fp);
+}
+
+static void test_doc_02(void **state)
+{
+    (void)state; // unused
+    jsmn_doc doc;
+    FILE *fp;
+
+    /* nothing but whitespace is no document */
+    fp = doc_file(" \n\t ");
+    jsmn_doc_init(&doc);
+    assert_int_equal(jsmn_fparse(fp, &doc), 0);
+    jsmn_doc_free(&doc);
+    fclose(fp);
+
+    fp = doc_file("");
+    jsmn_doc_init(&doc);
+    assert_int_equal(jsmn_fparse(fp, &doc), 0);
+    jsmn_doc_free(&doc);
+    fclose(fp);
+
+    /* a document cut short by the end of the input */
+    fp = doc_file("[1, 2] [3, {\"a\": ");
+    jsmn_doc_init(&doc);
+    doc_eq(&doc, jsmn_fparse(fp, &doc), "[1, 2]");
+    assert_int_equal(jsmn_fparse(fp, &doc), (jsmnint_t)JSMN_ERROR_PART);
+    jsmn_doc_free(&doc);
+    fclose(fp);
+
+    /* and one that is not JSON */
+    fp = doc_file("[1, 2] [3 4]");
+    jsmn_doc_init(&doc);
+    doc_eq(&doc, jsmn_fparse(fp, &doc), "[1, 2]");
+    assert_int_equal(jsmn_fparse(fp, &doc), (jsmnint_t)JSMN_ERROR_INVAL);
+    jsmn_doc_free(&doc);
+    fclose(fp);
+}
+
+#if !defined(_WIN32)
+static void test_doc_03(void **state)
+{
+    (void)state; // unused
+    const char *js = "{\"a\": [1, 2.5]}\n[\"b\"]\n-7\n";
+    jsmn_doc doc;
+    int fds[2];
+
+    /* the same through a pipe */
+    assert_int_equal(pipe(fds), 0);
+    assert_int_equal(write(fds[1], js, strlen(js)), strlen(js));
+    close(fds[1]);
+
+    jsmn_doc_init(&doc);
+    doc_eq(&doc, jsmn_fdparse(fds[0], &doc), "{\"a\": [1, 2.5]}");
+    doc_eq(&doc, jsmn_fdparse(fds[0], &doc), "[\"b\"]");
+    doc_eq(&doc, jsmn_fdparse(fds[0], &doc), "-7");
+    assert_int_equal(jsmn_fdparse(fds[0], &doc), 0);
+    jsmn_doc_free(&doc);
+    close(fds[0]);
+
+    /* a read that fails */
+    jsmn_doc_init(&doc);
+    assert_int_equal(jsmn_fdparse(-1, &doc), (jsmnint_t)JSMN_ERROR_INVAL);
+    jsmn_doc_free(&doc);
+}
+#endif
+
+void test_doc(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_doc_01),
+        cmocka_unit_test(test_doc_02),
+#if !defined(_WIN32)
+        cmocka_unit_test(test_doc_03),
+#endif
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+
+#if !defined(_WIN32)
+/**
+ * @brief Write js to a new file
+ *
+ * @param[in] js contents of the file
+ * @param[out] path buffer of at least 32 bytes for the file's path, unlink it when done
+ */
+static void file_path(const char *js, char *path)
+{
+    int fd;
+
+    strcpy(path, "/tmp/jsmn_utils_testXXXXXX");
+    fd = mkstemp(path);
+    assert_true(fd >= 0);
+    assert_int_equal(write(fd, js, strlen(js)), strlen(js));
+    close(fd);
+}
+
+/**
+ * @brief Check a file is held as it was written and parses as js does
+ *
+ * @param[in] js contents of the file
+ * @param[in] flags flags for jsmn_parse_file
+ */
+static void file_eq(const char *js, const int flags)
+{
+    jsmntokens_t *tokens = jsmn_tokens_alloc(16);
+    jsmn_parser p;
+    jsmn_file file;
+    char path[32];
+    jsmnint_t r;
+
+    assert_non_null(tokens);
+    file_path(js, path);
+    jsmn_init(&p);
+    r = jsmn_parse(&p, js, strlen(js), NULL, 0);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_file(path, flags, &file, &p, tokens, 16), r);
+    assert_non_null(file.js);
+    assert_int_equal(file.len, strlen(js));
+    assert_memory_equal(file.js, js, file.len);
+# if defined(JSMN_NO_MMAP)
+    assert_false(file.mapped);
+# else
+    assert_int_equal(file.mapped, file.len != 0);
+# endif
+    if (r != 0 && r < (jsmnint_t)JSMN_ERROR_MAX) {
+        assert_int_equal(JSMN_TOK_END(tokens, 0), strlen(js) - (js[strlen(js) - 1] == '\n'));
+    }
+
+    jsmn_tokens_free(tokens);
+    jsmn_file_close(&file);
+    assert_null(file.js);
+    assert_int_equal(file.len, 0);
+    unlink(path);
+}
+
+static void test_file_01(void **state)
+{
+    (void)state; // unused
+
+    /* tokens are taken in place from the file */
+    file_eq("{\"a\": [1, 2.5, true], \"b\": \"x\"}\n", 0);
+    file_eq("[null, \"y\"]", JSMN_MAP_POPULATE | JSMN_MAP_HUGE);
+
+    /* an empty file is held, and is no document */
+    file_eq("", 0);
+}
+
+static void test_file_02(void **state)
+{
+    (void)state; // unused
+    jsmn_parser p;
+    jsmn_file file;
+    char path[32];
+
+    /* a file that is not there, as told by file.js */
+    errno = 0;
+    assert_int_equal(jsmn_file_open(&file, "/nonexistent/jsmn.json", 0), -1);
+    assert_int_equal(errno, ENOENT);
+    assert_null(file.js);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_file("/nonexistent/jsmn.json", 0, &file, &p, NULL, 0), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_null(file.js);
+
+    /* and a file that is there but not JSON */
+    file_path("[1 2]", path);
+    jsmn_init(&p);
+    assert_int_equal(jsmn_parse_file(path, 0, &file, &p, NULL, 0), (jsmnint_t)JSMN_ERROR_INVAL);
+    assert_non_null(file.js);
+    jsmn_file_close(&file);
+    unlink(path);
+}
+#endif
+
+void test_file(void)
+{
+    const struct CMUnitTest tests[] = {
+#if !defined(_WIN32)
+        cmocka_unit_test(test_file_01),
+        cmocka_unit_test(test_file_02),
+#endif
+    };
+
+    memcpy(cur_test, tests, sizeof(tests));
+    cur_test += sizeof(tests);
+    total_tests += sizeof(tests) / sizeof(struct CMUnitTest);
+}
+
+#if JSMN_DOC_CHUNK == 1
+# define JSMN_TEST_GROUP "jsmn_utils_test_doc_chunk"
+#elif defined(JSMN_NO_MMAP)
+# define JSMN_TEST_GROUP "jsmn_utils_test_no_mmap"
+#elif defined(JSMN_SOA_TOKENS)
+# define JSMN_TEST_GROUP "jsmn_utils_test_soa"
+#elif defined(JSMN_PAIR_TOKENS)
+# define JSMN_TEST_GROUP "jsmn_utils_test_pairs"
+#else
+# define JSMN_TEST_GROUP "jsmn_utils_test_default"
+#endif
+
+int main(void)
+{
+    struct CMUnitTest *tests = cur_test = calloc(64, sizeof(struct CMUnitTest));
+
+    test_pack();           // test for packed token streams
+    test_numbers();        // test for arrays of numbers
+    test_doc();            // test for documents read from a stream
+    test_file();           // test for files parsed in place
+
+    return _cmocka_run_group_tests(JSMN_TEST_GROUP, tests, total_tests, NULL, NULL);
+}